@@ -4,30 +4,41 @@
   Optimizado para Arduino Uno con memoria limitada
 */
 
-#include <Wire.h>
-#include <RTClib.h>
-#include <LiquidCrystal_I2C.h>
 #include <EEPROM.h>
 
 // Incluir módulos optimizados
 #include "config.h"
+#include "twi_engine.h"
 #include "button_manager.h"
 #include "lcd_display_avr.h"
 #include "rtc_manager.h"
 #include "schedule_manager.h"
 #include "relay_controller.h"
+#include "feed_queue.h"
+#include "power_manager.h"
+#include "loop_profiler.h"
+#include "task_scheduler.h"
+#include "serial_commands.h"
+#include "coroutine.h"
 
 // === INSTANCIAS DE MÓDULOS ===
 ButtonManager buttonManager;
 RTCManager rtcManager;
 ScheduleManager scheduleManager;
 RelayController relayController;
+FeedQueue feedQueue(&relayController);
+PowerManager powerManager(&rtcManager);
+LoopProfiler loopProfiler;
 LCDDisplayAVR lcdDisplay(&rtcManager, &scheduleManager, &relayController);
 
+// Comandos seriales; los de diagnóstico los atiende el sketch
+bool runDiagnosticCommand(const char* command);
+SerialCommands serialCommands(&rtcManager, &relayController, &scheduleManager, &feedQueue, runDiagnosticCommand);
+
 // === VARIABLES GLOBALES ===
-unsigned long lastLoopTime = 0;
-unsigned long lastLCDUpdate = 0;
 bool systemInitialized = false;
+bool rtcNewSecond = false;   // rtcManager.update() de esta pasada empezó un segundo
+Coroutine bootTask;          // Arranque que sigue desde loop() (ver runBoot)
 
 // === VARIABLES DEL MENÚ ===
 enum MenuState {
@@ -43,7 +54,9 @@ enum MenuState {
 enum EditState {
   EDIT_HOUR,
   EDIT_MINUTE,
+  EDIT_DURATION,
   EDIT_ENABLED,
+  EDIT_RELAYS,
   EDIT_SAVE
 };
 
@@ -62,9 +75,12 @@ int editingSchedule = 1;
 EditState editState = EDIT_HOUR;
 int tempHour = 8;
 int tempMinute = 0;
+int tempDuration = FEED_DURATION;
 bool tempEnabled = true;
-unsigned long lastActivity = 0;
+uint8_t tempRelays = RELAY_ALL;
+uint32_t lastActivity = 0;
 bool inMenu = false;
+uint8_t statusPage = 0;   // "Ver Estado": 0 = estado, 1 = perfil del loop
 
 // Variables para ajuste de tiempo
 TimeEditState timeEditState = TIME_EDIT_HOUR;
@@ -74,107 +90,295 @@ int tempTimeDay = 1;
 int tempTimeMonth = 1;
 int tempTimeYear = 2024;
 
+// === TAREAS DEL LOOP ===
+// Cada tarea envuelve una o más etapas del loop con su medición
+
+// Horarios: al empezar cada segundo, al sonar la alarma y como respaldo
+// cada TASK_SCHEDULE_PERIOD
+void runScheduleTask() {
+  loopProfiler.start();
+  checkScheduledFeeding();
+  loopProfiler.stop(PROFILE_SCHEDULE);
+}
+
+bool isScheduleDue() {
+  return rtcNewSecond || rtcManager.isAlarmPending();
+}
+
+// Arrancar los pedidos en espera cuyos relays quedaron libres (antes de
+// update(), para que el LED siga encendido entre un pedido y otro)
+void runRelayTask() {
+  feedQueue.update();
+  loopProfiler.start();
+  relayController.update();
+  loopProfiler.stop(PROFILE_RELAY);
+}
+
+// Botones y, con sus pulsaciones ya aplicadas, timeout y menú
+void runButtonTask() {
+  loopProfiler.start();
+  buttonManager.update();
+  loopProfiler.stop(PROFILE_BUTTONS);
+  
+  loopProfiler.start();
+  checkMenuTimeout();
+  loopProfiler.stop(PROFILE_TIMEOUT);
+  
+  loopProfiler.start();
+  processMenu();
+  loopProfiler.stop(PROFILE_MENU);
+}
+
+bool isSerialPending() {
+  return SERIAL_ENABLED && serialCommands.isPending();
+}
+
+// El reloj se redibuja justo al cambiar el segundo
+void runLcdTask() {
+  loopProfiler.start();
+  updateLCD();
+  loopProfiler.stop(PROFILE_LCD);
+}
+
+bool isNewSecond() {
+  return rtcNewSecond;
+}
+
+// Tabla de tareas en orden de prioridad: período, fase y plazo en ms
+const TaskConfig loopTasks[] PROGMEM = {
+  // Nombre     Función              A pedido         Período               Fase  Plazo
+  {"Horarios", runScheduleTask,     isScheduleDue,   TASK_SCHEDULE_PERIOD, 0,    100},
+  {"Relays",   runRelayTask,        0,               TASK_RELAY_PERIOD,    1,    TASK_RELAY_PERIOD},
+  {"Botones",  runButtonTask,       0,               TASK_BUTTONS_PERIOD,  2,    TASK_BUTTONS_PERIOD},
+  {"Serie",    checkSerialCommands, isSerialPending, 0,                    0,    0},
+  {"LCD",      runLcdTask,          isNewSecond,     TASK_LCD_PERIOD,      3,    50}
+};
+
+const uint8_t LOOP_TASK_COUNT = sizeof(loopTasks) / sizeof(loopTasks[0]);
+TaskState loopTaskStates[LOOP_TASK_COUNT];
+TaskScheduler taskScheduler(loopTasks, loopTaskStates, LOOP_TASK_COUNT);
+
+// Parte del arranque que espera (el monitor serie, el DS3231): sigue
+// como corrutina desde loop() y termina dejando el sistema listo
+bool runBoot() {
+  CO_BEGIN(bootTask);
+  
+  // Dar tiempo a abrir el monitor serie
+  if (SERIAL_ENABLED) {
+    CO_DELAY(bootTask, 1000);
+    Serial.println(F("=== ALIMENTADOR DE PECES v3.8 ==="));
+  }
+  
+  // Inicializar RTC por el bus, sin esperarlo; sin él no hay horarios:
+  // reintentar cada segundo
+  rtcManager.startBegin();
+  CO_WAIT_UNTIL(bootTask, rtcManager.updateBegin());
+  if (!rtcManager.isStarted()) {
+    if (SERIAL_ENABLED) Serial.println(F(MSG_RTC_ERROR));
+    do {
+      CO_DELAY(bootTask, 1000);
+      rtcManager.startBegin();
+      CO_WAIT_UNTIL(bootTask, rtcManager.updateBegin());
+    } while (!rtcManager.isStarted());
+  }
+  
+  // Medir tiempo despierto y dormido desde aquí
+  powerManager.begin();
+  
+  systemInitialized = true;
+  
+  // Mostrar pantalla inicial
+  currentState = MENU_CLOCK;
+  updateActivity();
+  
+  // El reloj aparece cuando vence la pantalla de inicio (ver updateLCD)
+  updateLCD();
+  
+  // Debug: Verificar horarios configurados
+  debugSchedules();
+  
+  // Primeros vencimientos de las tareas, con su fase
+  taskScheduler.begin();
+  CO_END(bootTask);
+}
+
 void setup() {
   // Inicializar Serial si está habilitado
   if (SERIAL_ENABLED) {
     Serial.begin(SERIAL_BAUD_RATE);
-    delay(1000);
-    Serial.println("=== ALIMENTADOR DE PECES v3.8 ===");
   }
   
-  // Inicializar I2C
-  Wire.begin();
-  delay(100);
-  
-  // Inicializar RTC
-  if (!rtcManager.begin()) {
-    while(1) delay(1000);
-  }
+  // Inicializar I2C (una sola vez para el RTC y el LCD)
+  twiBus.begin();
   
   // Inicializar botones
   buttonManager.begin();
   
-  // Inicializar relay
+  // Inicializar relay (apagados desde el principio)
   relayController.begin();
   
   // Inicializar horarios
   scheduleManager.begin();
   
-  // Inicializar LCD
-  lcdDisplay.begin();
-  
-  systemInitialized = true;
-  
-  // Mostrar pantalla inicial
-  currentState = MENU_CLOCK;
-  updateActivity();
+  // La alarma del DS3231 arranca la dosis armada desde su interrupción
+  rtcManager.setAlarmHandler(feedAlarmFire);
   
-  // Mostrar reloj después de la pantalla de inicio
-  delay(1000);
-  updateLCD();
+  // Inicializar LCD: la pantalla de inicio aparece cuando termina de
+  // arrancar, en las primeras pasadas del loop
+  lcdDisplay.begin();
   
-  // Debug: Verificar horarios configurados
-  debugSchedules();
+  // El resto del arranque sigue desde loop() sin bloquear
+  bootTask.start();
+  runBoot();
 }
 
 void loop() {
+  // Arranque en curso: todavía sin tareas, pero el bus I2C y el LCD
+  // siguen avanzando
   if (!systemInitialized) {
-    delay(1000);
+    powerManager.idle();
+    twiBus.update();
+    runBoot();
+    lcdDisplay.flush();
     return;
   }
   
-  // Control de timing
-  unsigned long currentTime = millis();
-  if (currentTime - lastLoopTime < LOOP_DELAY) {
-    delay(LOOP_DELAY - (currentTime - lastLoopTime));
+  // Sin tareas vencidas, esperar durmiendo: en reposo en power-down
+  // hasta el próximo evento; si no, en modo idle hasta la próxima tarea
+  // o interrupción (también si solo falta terminar una transacción)
+  if (powerManager.canSleep() && isSystemIdle() && !isIoPending()) {
+    powerManager.sleep();
+  } else {
+    uint32_t wait = taskScheduler.getTimeToNextDue();
+    if (wait > 0) {
+      powerManager.idle(wait);
+    }
   }
-  lastLoopTime = millis();
   
-  // Verificar horarios
-  checkScheduledFeeding();
+  // Liberar el bus I2C si una transacción quedó colgada
+  twiBus.update();
   
-  // Actualizar relay
-  relayController.update();
+  // Refrescar la hora del RTC una sola vez para toda la pasada
+  rtcNewSecond = rtcManager.update();
   
-  // Actualizar botones
-  buttonManager.update();
+  // Correr las tareas vencidas o pedidas
+  taskScheduler.dispatch();
   
-  // Verificar timeout
-  checkMenuTimeout();
+  // Alarma del DS3231 con el próximo horario
+  armFeedAlarm();
   
-  // Procesar menú
-  processMenu();
+  // Guardados de horarios pendientes en EEPROM
+  scheduleManager.update();
   
-  // Actualizar LCD con control de tiempo para evitar parpadeo
-  if (millis() - lastLCDUpdate > 200) {  // Actualizar cada 200ms
-    updateLCD();
-    lastLCDUpdate = millis();
-  }
+  // Enviar al LCD una parte del frame pendiente (LCD_FLUSH_BUDGET bytes
+  // por pasada) para que un redibujado completo no bloquee el loop
+  lcdDisplay.flush();
 }
 
-// Verificar horarios programados
+// Verificar horarios programados. Se consulta también durante una
+// alimentación: cada horario pide su dosis a la cola, que la arranca en
+// los relays libres y la guarda para los que siguen ocupados
 void checkScheduledFeeding() {
-  if (relayController.isFeedingActive()) return;
-  
-  // Usar la función correcta del ScheduleManager
-  int scheduleToFeed = scheduleManager.checkFeedTime(rtcManager);
+  // Con la alarma, la dosis del primer horario ya arrancó en la
+  // interrupción en sus relays libres; los demás pasan por la cola
+  uint8_t alarmStarted = 0;
+  int scheduleToFeed;
+  if (rtcManager.takeAlarm()) {
+    alarmStarted = relayController.takeAlarmDose();
+    scheduleToFeed = scheduleManager.checkAlarm(rtcManager);
+  } else {
+    scheduleToFeed = scheduleManager.checkFeedTime(rtcManager);
+  }
   
   if (scheduleToFeed > 0) {
-    if (DEBUG_MODE && SERIAL_ENABLED) {
-      Serial.print("ACTIVANDO ALIMENTACIÓN - Horario ");
-      Serial.println(scheduleToFeed);
+    // Todos los horarios del mismo minuto (p. ej. uno por tanque)
+    for (int schedule = scheduleToFeed; schedule > 0; schedule = scheduleManager.getNextScheduleSameMinute(schedule)) {
+      FeedTime feed = scheduleManager.getSchedule(schedule);
+      uint8_t pending = (schedule == scheduleToFeed) ? feed.relays & ~alarmStarted : feed.relays;
+      FeedResult result = pending ? feedQueue.submit(FEED_SOURCE_SCHEDULE, pending, feed.duration, schedule) : FEED_STARTED;
+      
+      if (DEBUG_MODE && SERIAL_ENABLED) {
+        Serial.print(F("ACTIVANDO ALIMENTACIÓN - Horario "));
+        Serial.print(schedule);
+        Serial.print(F(", relays 0x"));
+        Serial.print(feed.relays, HEX);
+        Serial.println(result == FEED_STARTED ? F("") : (result == FEED_REJECTED ? F(" (rechazado)") : F(" (en cola)")));
+      }
     }
     
-    relayController.startFeeding(scheduleToFeed);
-    
     if (currentState != MENU_CLOCK) {
       currentState = MENU_CLOCK;
     }
   }
 }
 
-// Procesar menú
+// El sketch no tiene nada que hacer hasta la próxima interrupción:
+// reloj en pantalla, sin alimentar, sin botones ni guardados pendientes
+bool isSystemIdle() {
+  return currentState == MENU_CLOCK && !inMenu && !lcdDisplay.isOverlayActive() &&
+         !relayController.isFeedingActive() && feedQueue.isEmpty() &&
+         buttonManager.isIdle() && scheduleManager.getStore().isFlushed() &&
+         !(SERIAL_ENABLED && serialCommands.isPending());
+}
+
+// Quedan transacciones I2C o parte del frame del LCD por enviar
+bool isIoPending() {
+  return !twiBus.isIdle() || rtcManager.isReadPending() || lcdDisplay.getFramesPending() > 0;
+}
+
+// Programar la alarma 1 del DS3231 con el próximo horario y armar la
+// dosis que arranca su interrupción (solo cuando cambian). La escritura
+// sigue en el bus: lo armado se recuerda recién cuando el DS3231 la
+// confirma, y si falló se vuelve a escribir en la próxima llamada
+void armFeedAlarm() {
+  static uint32_t armedEpoch = 0;       // Alarma confirmada
+  static uint8_t armedRelays = 0;
+  static uint8_t armedDuration = 0;
+  static uint32_t writingEpoch = 0;     // Alarma en el bus
+  static uint8_t writingRelays = 0;
+  static uint8_t writingDuration = 0;
+  static bool writing = false;
+  
+  if (!rtcManager.isAlarmEnabled()) return;
+  
+  if (writing) {
+    if (rtcManager.isAlarmWritePending()) return;
+    writing = false;
+    if (rtcManager.isAlarmWritten()) {
+      relayController.armAlarmDose(writingRelays, writingDuration);
+      armedEpoch = writingEpoch;
+      armedRelays = writingRelays;
+      armedDuration = writingDuration;
+    }
+  }
+  
+  uint32_t next = scheduleManager.getNextFireEpoch(rtcManager);
+  FeedTime feed = scheduleManager.getSchedule(scheduleManager.getNextSchedule(rtcManager));
+  if (next == armedEpoch && feed.relays == armedRelays && feed.duration == armedDuration) return;
+  
+  if (next == 0) {
+    // Sin horarios no hay nada que escribir: la alarma vieja no arranca nada
+    relayController.disarmAlarmDose();
+    armedEpoch = 0;
+    armedRelays = feed.relays;
+    armedDuration = feed.duration;
+    return;
+  }
+  rtcManager.setAlarm((next % 86400UL) / 3600, (next % 3600UL) / 60);
+  writingEpoch = next;
+  writingRelays = feed.relays;
+  writingDuration = feed.duration;
+  writing = true;
+}
+
+// Procesar menú. Solo los botones (o una alimentación en pantalla)
+// renuevan el timeout: sin tocarlos el menú vuelve al reloj tras
+// MENU_TIMEOUT y el sketch puede dormir
 void processMenu() {
+  if (inMenu && (buttonManager.hasInput() || currentState == MENU_FEEDING)) {
+    updateActivity();
+  }
+  
   switch (currentState) {
     case MENU_CLOCK:
       handleClockMode();
@@ -206,11 +410,13 @@ void handleClockMode() {
     enterMainMenu();
   }
   
-  // Solo permitir alimentación manual en pantalla principal
+  // Solo permitir alimentación manual en pantalla principal; si los
+  // relays están ocupados el pedido espera en la cola
   if (buttonManager.confirmPressed() && currentState == MENU_CLOCK) {
-    if (!relayController.isFeedingActive()) {
-      relayController.startFeeding(0);
+    if (feedQueue.submit(FEED_SOURCE_BUTTON, RELAY_ALL) != FEED_REJECTED) {
       buttonManager.confirmBeep();
+    } else {
+      buttonManager.errorBeep();
     }
   }
 }
@@ -226,15 +432,13 @@ void enterMainMenu() {
 
 // Manejar menú principal
 void handleMainMenu() {
-  updateActivity();
-  
   if (buttonManager.upPressed()) {
-    selectedOption = (selectedOption > 1) ? selectedOption - 1 : 9;
+    selectedOption = (selectedOption > 1) ? selectedOption - 1 : MAIN_MENU_OPTIONS;
     buttonManager.beep();
   }
   
   if (buttonManager.downPressed()) {
-    selectedOption = (selectedOption < 9) ? selectedOption + 1 : 1;
+    selectedOption = (selectedOption < MAIN_MENU_OPTIONS) ? selectedOption + 1 : 1;
     buttonManager.beep();
   }
   
@@ -252,44 +456,49 @@ void executeMainMenuOption() {
   buttonManager.confirmBeep();
   
   switch (selectedOption) {
-    case 1: // Ver Horarios
+    case 1: // Horarios (lista con cursor, CONFIRM edita)
       currentState = MENU_VIEW_SCHEDULES;
       break;
       
-    case 2: // Editar Horario 1
-    case 3: // Editar Horario 2
-    case 4: // Editar Horario 3
-    case 5: // Editar Horario 4
-      editingSchedule = selectedOption - 1;
-      startScheduleEdit();
-      break;
-      
-    case 6: // Alimentar Ahora
-      if (!relayController.isFeedingActive()) {
-        relayController.startFeeding(0);
+    case 2: // Alimentar Ahora
+      if (feedQueue.submit(FEED_SOURCE_BUTTON, RELAY_ALL) != FEED_REJECTED) {
         currentState = MENU_FEEDING;
       }
       break;
       
-    case 7: // Ver Estado
+    case 3: // Ver Estado
       currentState = MENU_STATUS;
+      statusPage = 0;
       break;
       
-    case 8: // Ajustar Hora
+    case 4: // Ajustar Hora
       startTimeAdjust();
       break;
       
-    case 9: // Salir
+    case 5: // Salir
       returnToClock();
       break;
   }
 }
 
-// Manejar vista de horarios
+// Manejar vista de horarios (UP/DOWN mueven el cursor, CONFIRM edita)
 void handleViewSchedules() {
-  updateActivity();
+  if (buttonManager.upPressed() || buttonManager.upRepeating()) {
+    editingSchedule = (editingSchedule > 1) ? editingSchedule - 1 : MAX_FEED_TIMES;
+    buttonManager.beep();
+  }
   
-  if (buttonManager.selectPressed() || buttonManager.confirmPressed()) {
+  if (buttonManager.downPressed() || buttonManager.downRepeating()) {
+    editingSchedule = (editingSchedule < MAX_FEED_TIMES) ? editingSchedule + 1 : 1;
+    buttonManager.beep();
+  }
+  
+  if (buttonManager.confirmPressed()) {
+    buttonManager.confirmBeep();
+    startScheduleEdit();
+  }
+  
+  if (buttonManager.selectPressed()) {
     currentState = MENU_MAIN;
     buttonManager.beep();
   }
@@ -300,16 +509,26 @@ void startScheduleEdit() {
   currentState = MENU_EDIT_SCHEDULE;
   editState = EDIT_HOUR;
   
-  FeedTime current = scheduleManager.getSchedule(editingSchedule);
-  tempHour = current.hour;
-  tempMinute = current.minute;
-  tempEnabled = current.enabled;
+  // Un horario libre empieza en la hora predeterminada, habilitado y con
+  // todos los relays
+  if (scheduleManager.isScheduleConfigured(editingSchedule)) {
+    FeedTime current = scheduleManager.getSchedule(editingSchedule);
+    tempHour = current.hour;
+    tempMinute = current.minute;
+    tempDuration = current.duration;
+    tempEnabled = current.enabled;
+    tempRelays = current.relays;
+  } else {
+    tempHour = DEFAULT_SCHEDULE_1_HOUR;
+    tempMinute = DEFAULT_SCHEDULE_1_MINUTE;
+    tempDuration = FEED_DURATION;
+    tempEnabled = true;
+    tempRelays = RELAY_ALL;
+  }
 }
 
 // Manejar edición de horario
 void handleEditSchedule() {
-  updateActivity();
-  
   if (buttonManager.upPressed() || buttonManager.upRepeating()) {
     incrementEditValue();
     buttonManager.beep();
@@ -335,7 +554,7 @@ void handleEditSchedule() {
   }
   
   if (buttonManager.selectLongPressed()) {
-    currentState = MENU_MAIN;
+    currentState = MENU_VIEW_SCHEDULES;
     buttonManager.errorBeep();
   }
 }
@@ -349,9 +568,18 @@ void incrementEditValue() {
     case EDIT_MINUTE:
       tempMinute = (tempMinute < 59) ? tempMinute + 1 : 0;
       break;
+    case EDIT_DURATION:
+      tempDuration = (tempDuration < MAX_FEED_DURATION) ? tempDuration + 1 : MIN_FEED_DURATION;
+      break;
     case EDIT_ENABLED:
       tempEnabled = !tempEnabled;
       break;
+    case EDIT_RELAYS:
+      tempRelays = (tempRelays < RELAY_ALL) ? tempRelays + 1 : 1;
+      break;
+    case EDIT_SAVE:
+      // Guardar no tiene valor que cambiar
+      break;
   }
 }
 
@@ -364,9 +592,18 @@ void decrementEditValue() {
     case EDIT_MINUTE:
       tempMinute = (tempMinute > 0) ? tempMinute - 1 : 59;
       break;
+    case EDIT_DURATION:
+      tempDuration = (tempDuration > MIN_FEED_DURATION) ? tempDuration - 1 : MAX_FEED_DURATION;
+      break;
     case EDIT_ENABLED:
       tempEnabled = !tempEnabled;
       break;
+    case EDIT_RELAYS:
+      tempRelays = (tempRelays > 1) ? tempRelays - 1 : RELAY_ALL;
+      break;
+    case EDIT_SAVE:
+      // Guardar no tiene valor que cambiar
+      break;
   }
 }
 
@@ -377,9 +614,15 @@ void nextEditField() {
       editState = EDIT_MINUTE;
       break;
     case EDIT_MINUTE:
+      editState = EDIT_DURATION;
+      break;
+    case EDIT_DURATION:
       editState = EDIT_ENABLED;
       break;
     case EDIT_ENABLED:
+      editState = EDIT_RELAYS;
+      break;
+    case EDIT_RELAYS:
       editState = EDIT_SAVE;
       break;
     case EDIT_SAVE:
@@ -391,9 +634,11 @@ void nextEditField() {
 // Guardar horario editado
 void saveSchedule() {
   if (scheduleManager.setSchedule(editingSchedule, tempHour, tempMinute)) {
+    scheduleManager.setScheduleDose(editingSchedule, tempRelays, tempDuration);
     scheduleManager.enableSchedule(editingSchedule, tempEnabled);
+    scheduleManager.save();
     buttonManager.confirmBeep();
-    currentState = MENU_MAIN;
+    currentState = MENU_VIEW_SCHEDULES;
   } else {
     buttonManager.errorBeep();
   }
@@ -401,22 +646,30 @@ void saveSchedule() {
 
 // Manejar alimentación manual
 void handleFeeding() {
-  updateActivity();
-  
-  if (!relayController.isFeedingActive()) {
+  if (!relayController.isFeedingActive() && feedQueue.isEmpty()) {
     currentState = MENU_MAIN;
   }
   
   if (buttonManager.selectPressed()) {
+    feedQueue.clear();
     relayController.emergencyStop();
     currentState = MENU_MAIN;
     buttonManager.beep();
   }
 }
 
-// Manejar estado del sistema
+// Manejar estado del sistema (UP/DOWN cambian de página; en la del
+// perfil CONFIRM reinicia las mediciones)
 void handleStatus() {
-  updateActivity();
+  if (buttonManager.upPressed() || buttonManager.downPressed()) {
+    statusPage = 1 - statusPage;
+    buttonManager.beep();
+  }
+  
+  if (statusPage == 1 && buttonManager.confirmPressed()) {
+    loopProfiler.reset();
+    buttonManager.confirmBeep();
+  }
   
   if (buttonManager.selectPressed() || buttonManager.confirmPressed()) {
     currentState = MENU_MAIN;
@@ -426,8 +679,6 @@ void handleStatus() {
 
 // Manejar ajuste de hora
 void handleTimeAdjust() {
-  updateActivity();
-  
   if (buttonManager.upPressed() || buttonManager.upRepeating()) {
     incrementTimeValue();
     buttonManager.beep();
@@ -473,7 +724,9 @@ void updateLCD() {
   static EditState lastEditState = EDIT_HOUR;
   static int lastTempHour = 8;
   static int lastTempMinute = 0;
+  static int lastTempDuration = FEED_DURATION;
   static bool lastTempEnabled = true;
+  static uint8_t lastTempRelays = RELAY_ALL;
   static int lastRemainingTime = 0;
   static TimeEditState lastTimeEditState = TIME_EDIT_HOUR;
   static int lastTempTimeHour = 12;
@@ -481,9 +734,14 @@ void updateLCD() {
   static int lastTempTimeDay = 1;
   static int lastTempTimeMonth = 1;
   static int lastTempTimeYear = 2024;
+  static uint32_t lastClockEpoch = 0;
+  static int lastClockRemaining = 0;
+  static uint8_t lastStatusPage = 0;
+  static uint32_t lastProfileEpoch = 0;
   
-  // Solo actualizar si algo cambió o es el reloj
-  bool needsUpdate = false;
+  // Solo actualizar si algo cambió o es el reloj; al vencer un mensaje
+  // temporal se redibuja la pantalla que quedó debajo
+  bool needsUpdate = lcdDisplay.update();
   
   if (currentState != lastState) {
     needsUpdate = true;
@@ -495,18 +753,27 @@ void updateLCD() {
     lastSelectedOption = selectedOption;
   }
   
+  if (currentState == MENU_VIEW_SCHEDULES && editingSchedule != lastEditingSchedule) {
+    needsUpdate = true;
+    lastEditingSchedule = editingSchedule;
+  }
+  
   if (currentState == MENU_EDIT_SCHEDULE) {
     if (editingSchedule != lastEditingSchedule || 
         editState != lastEditState ||
         tempHour != lastTempHour ||
         tempMinute != lastTempMinute ||
-        tempEnabled != lastTempEnabled) {
+        tempDuration != lastTempDuration ||
+        tempEnabled != lastTempEnabled ||
+        tempRelays != lastTempRelays) {
       needsUpdate = true;
       lastEditingSchedule = editingSchedule;
       lastEditState = editState;
       lastTempHour = tempHour;
       lastTempMinute = tempMinute;
+      lastTempDuration = tempDuration;
       lastTempEnabled = tempEnabled;
+      lastTempRelays = tempRelays;
     }
   }
   
@@ -535,9 +802,25 @@ void updateLCD() {
     }
   }
   
-  // Para el reloj, actualizar siempre
+  // La página del perfil se refresca una vez por segundo
+  if (currentState == MENU_STATUS) {
+    uint32_t profileEpoch = rtcManager.getEpoch();
+    if (statusPage != lastStatusPage || (statusPage == 1 && profileEpoch != lastProfileEpoch)) {
+      needsUpdate = true;
+      lastStatusPage = statusPage;
+      lastProfileEpoch = profileEpoch;
+    }
+  }
+  
+  // Para el reloj, actualizar solo si cambió el segundo o el tiempo restante
   if (currentState == MENU_CLOCK) {
-    needsUpdate = true;
+    uint32_t clockEpoch = rtcManager.getEpoch();
+    int clockRemaining = relayController.getRemainingFeedTime();
+    if (clockEpoch != lastClockEpoch || clockRemaining != lastClockRemaining) {
+      needsUpdate = true;
+      lastClockEpoch = clockEpoch;
+      lastClockRemaining = clockRemaining;
+    }
   }
   
   if (needsUpdate) {
@@ -549,7 +832,7 @@ void updateLCD() {
         lcdDisplay.showMainMenu(selectedOption);
         break;
       case MENU_VIEW_SCHEDULES:
-        lcdDisplay.showSchedules();
+        lcdDisplay.showSchedules(editingSchedule);
         break;
       case MENU_EDIT_SCHEDULE:
         {
@@ -557,17 +840,24 @@ void updateLCD() {
           switch (editState) {
             case EDIT_HOUR: cursorPos = 0; break;
             case EDIT_MINUTE: cursorPos = 1; break;
-            case EDIT_ENABLED: cursorPos = 2; break;
-            case EDIT_SAVE: cursorPos = 3; break;
+            case EDIT_DURATION: cursorPos = 2; break;
+            case EDIT_ENABLED: cursorPos = 3; break;
+            case EDIT_RELAYS: cursorPos = 4; break;
+            case EDIT_SAVE: cursorPos = 5; break;
           }
-          lcdDisplay.showScheduleEditor(editingSchedule, tempHour, tempMinute, tempEnabled, cursorPos);
+          lcdDisplay.showScheduleEditor(editingSchedule, tempHour, tempMinute, tempDuration,
+                                        tempEnabled, tempRelays, cursorPos);
         }
         break;
       case MENU_FEEDING:
         lcdDisplay.showFeeding(relayController.getRemainingFeedTime());
         break;
       case MENU_STATUS:
-        lcdDisplay.showStatus();
+        if (statusPage == 1) {
+          lcdDisplay.showProfile(loopProfiler);
+        } else {
+          lcdDisplay.showStatus();
+        }
         break;
       case MENU_TIME_ADJUST:
         {
@@ -634,6 +924,9 @@ void incrementTimeValue() {
     case TIME_EDIT_YEAR:
       tempTimeYear = (tempTimeYear < 2099) ? tempTimeYear + 1 : 2024;
       break;
+    case TIME_EDIT_SAVE:
+      // Guardar no tiene valor que cambiar
+      break;
   }
 }
 
@@ -655,6 +948,9 @@ void decrementTimeValue() {
     case TIME_EDIT_YEAR:
       tempTimeYear = (tempTimeYear > 2024) ? tempTimeYear - 1 : 2099;
       break;
+    case TIME_EDIT_SAVE:
+      // Guardar no tiene valor que cambiar
+      break;
   }
 }
 
@@ -700,40 +996,76 @@ void saveTime() {
   currentState = MENU_MAIN;
 }
 
+// Leer comandos del puerto serie sin esperar (SerialCommands junta los
+// caracteres de cada pasada hasta el fin de línea)
+void checkSerialCommands() {
+  if (!SERIAL_ENABLED) return;
+  
+  serialCommands.processCommands();
+}
+    
+// Comandos de diagnóstico (el resto está en SerialCommands)
+bool runDiagnosticCommand(const char* command) {
+  if (strcmp(command, "power") == 0) {
+    powerManager.displayStats();
+  } else if (strcmp(command, "prof") == 0) {
+    loopProfiler.displayProfile();
+  } else if (strcmp(command, "prof reset") == 0) {
+    loopProfiler.reset();
+    Serial.println(F(MSG_PROFILE_RESET));
+  } else if (strcmp(command, "tasks") == 0) {
+    taskScheduler.displayTasks();
+  } else if (strcmp(command, "tasks reset") == 0) {
+    taskScheduler.resetStats();
+    Serial.println(F(MSG_TASKS_RESET));
+  } else {
+    return false;
+  }
+  return true;
+}
+
 // Función de debug para verificar horarios
 void debugSchedules() {
   // Solo mostrar en modo debug
   if (DEBUG_MODE && SERIAL_ENABLED) {
-    Serial.println("=== DEBUG HORARIOS ===");
+    Serial.println(F("=== DEBUG HORARIOS ==="));
+    // Solo los horarios con hora asignada, como displaySchedules()
+    int configured = 0;
     for (int i = 1; i <= MAX_FEED_TIMES; i++) {
+      if (!scheduleManager.isScheduleConfigured(i)) continue;
+      configured++;
+      
       FeedTime schedule = scheduleManager.getSchedule(i);
-      Serial.print("Horario ");
+      Serial.print(F("Horario "));
       Serial.print(i);
-      Serial.print(": ");
+      Serial.print(F(": "));
       if (schedule.enabled) {
         Serial.print(schedule.hour);
-        Serial.print(":");
-        if (schedule.minute < 10) Serial.print("0");
+        Serial.print(F(":"));
+        if (schedule.minute < 10) Serial.print(F("0"));
         Serial.print(schedule.minute);
-        Serial.println(" (HABILITADO)");
+        Serial.println(F(" (HABILITADO)"));
       } else {
-        Serial.println("DESHABILITADO");
+        Serial.println(F("DESHABILITADO"));
       }
     }
+    if (configured == 0) {
+      Serial.println(F(MSG_NO_SCHEDULES));
+    }
     
     DateTime now = rtcManager.now();
-    Serial.print("Hora actual: ");
+    Serial.print(F("Hora actual: "));
     Serial.print(now.hour());
-    Serial.print(":");
-    if (now.minute() < 10) Serial.print("0");
+    Serial.print(F(":"));
+    if (now.minute() < 10) Serial.print(F("0"));
     Serial.print(now.minute());
-    Serial.print(":");
-    if (now.second() < 10) Serial.print("0");
+    Serial.print(F(":"));
+    if (now.second() < 10) Serial.print(F("0"));
     Serial.println(now.second());
     
     int nextSchedule = scheduleManager.getNextSchedule(rtcManager);
-    Serial.print("Próximo horario: ");
+    Serial.print(F("Próximo horario: "));
     Serial.println(nextSchedule);
-    Serial.println("===================");
+    Serial.println(F("==================="));
   }
 }
\ No newline at end of file
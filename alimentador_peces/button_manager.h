@@ -6,6 +6,23 @@
   - Detección de pulsación larga
   - Repetición automática
   - Estados de botones
+  - Sonidos de retroalimentación sin bloquear el loop
+
+  Los botones no se leen en el loop: la interrupción de comparación A
+  del Timer0 (cada ~1 ms, sin afectar a millis()) lee PIND una vez cada
+  BUTTON_SAMPLE_TICKS ticks y filtra los rebotes de los cuatro botones
+  a la vez con contadores verticales (un contador de 2 bits por botón,
+  repartido en dos bytes): el estado de un botón cambia tras 4 muestras
+  seguidas distintas. Cada cambio entra con su millis() en una cola
+  circular de un productor (la interrupción) y un consumidor (update()),
+  que aplica la pulsación larga con esos instantes, así que dos
+  pulsaciones rápidas entre dos pasadas del loop no se pierden y la
+  latencia no depende del período de la tarea que llama a update().
+
+  Los sonidos son patrones de duraciones (ver BEEP_PATTERN_* en config.h)
+  que se encolan y se reproducen paso a paso. En AVR los avanza la misma
+  interrupción del Timer0 mientras suena algo; en otras plataformas los
+  avanza update() en cada pasada del loop.
 */
 
 #ifndef BUTTON_MANAGER_H
@@ -13,6 +30,135 @@
 
 #include "config.h"
 
+// Secuenciador del buzzer (compartido con la interrupción)
+static const uint16_t* volatile buzzerQueue[BEEP_QUEUE_SIZE];
+static volatile uint8_t buzzerQueueHead = 0;
+static volatile uint8_t buzzerQueueCount = 0;
+static const uint16_t* volatile buzzerStepPtr = 0;  // Paso actual del patrón en curso (0 = silencio)
+static volatile uint32_t buzzerStepStart = 0;
+
+// Avanzar el patrón en curso; al terminar, tomar el siguiente de la cola
+static void buzzerStep() {
+  uint32_t now = millis();
+  
+  if (buzzerStepPtr) {
+    // El 0 final cuenta como silencio antes del siguiente sonido
+    unsigned int duration = *buzzerStepPtr ? *buzzerStepPtr : BEEP_PATTERN_GAP;
+    if (now - buzzerStepStart < duration) return;
+    
+    if (*buzzerStepPtr) {
+      // Los pasos pares encienden y los impares apagan
+      buzzerStepPtr++;
+      buzzerStepStart = now;
+      bool on = *buzzerStepPtr && !((buzzerStepPtr - buzzerQueue[buzzerQueueHead]) & 1);
+      digitalWrite(BUZZER_PIN, on ? HIGH : LOW);
+      return;
+    }
+    
+    buzzerStepPtr = 0;
+    buzzerQueueHead = (buzzerQueueHead + 1) % BEEP_QUEUE_SIZE;
+    buzzerQueueCount--;
+  }
+  
+  if (buzzerQueueCount == 0) return;
+  
+  buzzerStepPtr = buzzerQueue[buzzerQueueHead];
+  buzzerStepStart = now;
+  digitalWrite(BUZZER_PIN, HIGH);
+}
+
+// Cambio de estado de los botones: bit del pin (PORTD) = presionado
+struct ButtonEvent {
+  uint8_t pressed;
+  uint32_t time;
+};
+
+// Cola de cambios: solo la interrupción escribe buttonEventHead y solo
+// update() escribe buttonEventTail, así que no hace falta bloquear
+static volatile ButtonEvent buttonEvents[BUTTON_EVENT_QUEUE_SIZE];
+static volatile uint8_t buttonEventHead = 0;
+static volatile uint8_t buttonEventTail = 0;
+static volatile uint8_t buttonEventsLost = 0;
+
+static const uint8_t buttonPins[4] = {BUTTON_SELECT_PIN, BUTTON_UP_PIN, BUTTON_DOWN_PIN, BUTTON_CONFIRM_PIN};
+
+static_assert(BUTTON_SELECT_PIN < 8 && BUTTON_UP_PIN < 8 && BUTTON_DOWN_PIN < 8 && BUTTON_CONFIRM_PIN < 8,
+              "Los botones se leen juntos de PIND: deben estar en los pines 0-7");
+const uint8_t BUTTON_PORT_MASK = bit(BUTTON_SELECT_PIN) | bit(BUTTON_UP_PIN) | bit(BUTTON_DOWN_PIN) | bit(BUTTON_CONFIRM_PIN);
+
+// Anti-rebote por contadores verticales: bit n de buttonCount1:buttonCount0
+// es el contador del pin n (3 en reposo, baja con cada muestra distinta
+// del estado filtrado)
+static volatile uint8_t buttonDebounced = 0;  // Bit del pin = presionado, sin rebotes
+static uint8_t buttonCount0 = 0xFF;
+static uint8_t buttonCount1 = 0xFF;
+static uint8_t buttonSampleTick = 0;
+
+#if defined(__AVR__)
+static inline uint8_t buttonReadPort() {
+  return PIND;
+}
+#else
+// Simulador: el mismo byte armado con digitalRead()
+static uint8_t buttonReadPort() {
+  uint8_t port = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (digitalRead(buttonPins[i]) == HIGH) {
+      port |= bit(buttonPins[i]);
+    }
+  }
+  return port;
+}
+#endif
+
+// Tomar una muestra de los cuatro botones y filtrarla
+static void buttonSample() {
+  // LOW = presionado por el pull-up
+  uint8_t changed = buttonDebounced ^ (~buttonReadPort() & BUTTON_PORT_MASK);
+  
+  // Los bits iguales al estado filtrado vuelven a 3; los distintos bajan,
+  // y los que pasan de 0 a 3 cambian de estado
+  buttonCount0 = ~(buttonCount0 & changed);
+  buttonCount1 = buttonCount0 ^ (buttonCount1 & changed);
+  changed &= buttonCount0 & buttonCount1;
+  if (!changed) return;
+  
+  uint8_t debounced = buttonDebounced ^ changed;
+  buttonDebounced = debounced;
+  
+  uint8_t head = buttonEventHead;
+  uint8_t next = (head + 1) % BUTTON_EVENT_QUEUE_SIZE;
+  if (next == buttonEventTail) {
+    // Cola llena: update() toma buttonDebounced al notar la pérdida
+    if (buttonEventsLost < 255) {
+      buttonEventsLost++;
+    }
+    return;
+  }
+  buttonEvents[head].pressed = debounced;
+  buttonEvents[head].time = millis();
+  buttonEventHead = next;
+}
+
+// Tick del Timer0: muestrear los botones y avanzar los sonidos
+static void buttonTimerTick() {
+  if (++buttonSampleTick >= BUTTON_SAMPLE_TICKS) {
+    buttonSampleTick = 0;
+    buttonSample();
+  }
+#if defined(__AVR__)
+  if (buzzerQueueCount) {
+    buzzerStep();
+  }
+#endif
+}
+
+#if defined(__AVR__)
+ISR(TIMER0_COMPA_vect) {
+  buttonTimerTick();
+}
+#endif
+
 // Estados de los botones
 enum ButtonState {
   BUTTON_RELEASED,
@@ -23,14 +169,11 @@ enum ButtonState {
 
 // Estructura para cada botón
 struct Button {
-  int pin;
   ButtonState state;
-  ButtonState lastState;
-  unsigned long lastPressTime;
-  unsigned long lastReleaseTime;
-  unsigned long lastRepeatTime;
+  uint32_t lastPressTime;
+  uint32_t lastRepeatTime;
   bool isPressed;
-  bool wasPressed;
+  uint8_t pressCount;             // Pulsaciones sin consultar con wasPressed()
   bool longPressDetected;
   bool repeatActive;
 };
@@ -38,15 +181,16 @@ struct Button {
 class ButtonManager {
 private:
   Button buttons[4];  // SELECT, UP, DOWN, CONFIRM
+  uint16_t customBeep[2];  // Patrón para beep() con otra duración
+  uint8_t eventsLostSeen;  // Valor de buttonEventsLost ya atendido
   
 public:
   // Constructor
-  ButtonManager() {
+  ButtonManager() : eventsLostSeen(0) {
     // Inicializar botones
-    buttons[0] = {BUTTON_SELECT_PIN, BUTTON_RELEASED, BUTTON_RELEASED, 0, 0, 0, false, false, false, false};
-    buttons[1] = {BUTTON_UP_PIN, BUTTON_RELEASED, BUTTON_RELEASED, 0, 0, 0, false, false, false, false};
-    buttons[2] = {BUTTON_DOWN_PIN, BUTTON_RELEASED, BUTTON_RELEASED, 0, 0, 0, false, false, false, false};
-    buttons[3] = {BUTTON_CONFIRM_PIN, BUTTON_RELEASED, BUTTON_RELEASED, 0, 0, 0, false, false, false, false};
+    for (int i = 0; i < 4; i++) {
+      buttons[i] = {BUTTON_RELEASED, 0, 0, false, 0, false, false};
+    }
   }
 
   // Inicializar botones
@@ -56,6 +200,15 @@ public:
     pinMode(BUTTON_DOWN_PIN, INPUT_PULLUP);
     pinMode(BUTTON_CONFIRM_PIN, INPUT_PULLUP);
     
+    // Muestreo de botones en la comparación A del Timer0
+#if defined(__AVR__)
+    OCR0A = 0x80;              // A mitad de cuenta, lejos del desborde que usa millis()
+    TIFR0 = bit(OCF0A);
+    TIMSK0 |= bit(OCIE0A);
+#else
+    attachTimer0CompareInterrupt(buttonTimerTick);
+#endif
+    
     // Inicializar buzzer si está configurado
     pinMode(BUZZER_PIN, OUTPUT);
     digitalWrite(BUZZER_PIN, LOW);
@@ -65,17 +218,38 @@ public:
 
   // Actualizar estado de todos los botones
   void update() {
+    // Aplicar los cambios en orden, cada uno con su instante
+    while (buttonEventTail != buttonEventHead) {
+      uint8_t tail = buttonEventTail;
+      applyState(buttonEvents[tail].pressed, buttonEvents[tail].time);
+      buttonEventTail = (tail + 1) % BUTTON_EVENT_QUEUE_SIZE;
+    }
+    
+    // Con la cola desbordada faltan cambios: tomar el estado filtrado actual
+    if (buttonEventsLost != eventsLostSeen) {
+      eventsLostSeen = buttonEventsLost;
+      applyState(buttonDebounced, millis());
+    }
+    
+    uint32_t currentTime = millis();
     for (int i = 0; i < 4; i++) {
-      updateButton(buttons[i]);
+      updateButton(buttons[i], currentTime);
     }
+    
+#if !defined(__AVR__)
+    // Sin Timer0: avanzar los sonidos desde el loop
+    noInterrupts();
+    buzzerStep();
+    interrupts();
+#endif
   }
 
   // Verificar si un botón fue presionado (una sola vez)
   bool wasPressed(int buttonIndex) {
     if (buttonIndex < 0 || buttonIndex > 3) return false;
     
-    if (buttons[buttonIndex].wasPressed) {
-      buttons[buttonIndex].wasPressed = false;
+    if (buttons[buttonIndex].pressCount > 0) {
+      buttons[buttonIndex].pressCount--;
       return true;
     }
     return false;
@@ -129,25 +303,67 @@ public:
     return wasPressed(0) || wasPressed(1) || wasPressed(2) || wasPressed(3);
   }
 
-  // Reproducir sonido de retroalimentación
-  void beep(int duration = 100) {
-    digitalWrite(BUZZER_PIN, HIGH);
-    delay(duration);
+  // Verificar si hay pulsaciones sin consultar o algún botón presionado
+  // (sin consumirlas, a diferencia de anyButtonPressed())
+  bool hasInput() {
+    for (int i = 0; i < 4; i++) {
+      if (buttons[i].pressCount > 0 || buttons[i].isPressed) return true;
+    }
+    return false;
+  }
+
+  // Encolar un patrón de sonido y retornar enseguida.
+  // Retorna false si la cola está llena (el sonido se descarta).
+  bool playPattern(const uint16_t* pattern) {
+    bool queued = false;
+    noInterrupts();
+    if (buzzerQueueCount < BEEP_QUEUE_SIZE) {
+      buzzerQueue[(buzzerQueueHead + buzzerQueueCount) % BEEP_QUEUE_SIZE] = pattern;
+      buzzerQueueCount++;
+      queued = true;
+      if (!buzzerStepPtr) {
+        buzzerStep();
+      }
+    }
+    interrupts();
+    return queued;
+  }
+
+  // Verificar si hay sonidos sonando o en espera
+  bool isBeeping() {
+    return buzzerQueueCount > 0;
+  }
+
+  // Cortar el sonido actual y vaciar la cola
+  void stopBeeps() {
+    noInterrupts();
+    buzzerQueueCount = 0;
+    buzzerStepPtr = 0;
     digitalWrite(BUZZER_PIN, LOW);
+    interrupts();
+  }
+
+  // Reproducir sonido de retroalimentación
+  void beep(int duration = BEEP_SHORT) {
+    if (duration == BEEP_SHORT) {
+      playPattern(BEEP_PATTERN_CLICK);
+      return;
+    }
+    
+    // Un único patrón a medida: si ya está en cola, suena con la última duración
+    customBeep[0] = duration;
+    customBeep[1] = 0;
+    playPattern(customBeep);
   }
 
   // Reproducir sonido de confirmación
   void confirmBeep() {
-    beep(50);
-    delay(50);
-    beep(50);
+    playPattern(BEEP_PATTERN_CONFIRM);
   }
 
   // Reproducir sonido de error
   void errorBeep() {
-    beep(200);
-    delay(100);
-    beep(200);
+    playPattern(BEEP_PATTERN_ERROR);
   }
 
   // Obtener estado de un botón como texto (para debug)
@@ -165,37 +381,53 @@ public:
 
   // Mostrar estado de todos los botones (para debug) - ELIMINADO PARA AHORRAR MEMORIA
 
+  // Verificar que no hay botones presionados, cambios por atender ni
+  // sonidos (el Timer0 que los avanza se detiene al dormir)
+  bool isIdle() {
+    if (buttonEventTail != buttonEventHead || buttonDebounced || isBeeping()) return false;
+    for (int i = 0; i < 4; i++) {
+      if (buttons[i].isPressed) return false;
+    }
+    return (~buttonReadPort() & BUTTON_PORT_MASK) == 0;
+  }
+
+  // Cambios descartados porque la cola estaba llena
+  uint8_t getLostEventCount() {
+    return buttonEventsLost;
+  }
+
 private:
-  // Actualizar estado de un botón individual
-  void updateButton(Button& button) {
-    bool currentReading = digitalRead(button.pin) == LOW; // LOW = presionado (pull-up)
-    unsigned long currentTime = millis();
-    
-    // Guardar estado anterior
-    button.lastState = button.state;
-    
-    // Anti-rebote
-    if (currentReading != button.isPressed) {
-      if (currentTime - button.lastReleaseTime > BUTTON_DEBOUNCE_DELAY) {
-        button.isPressed = currentReading;
-        
-        if (button.isPressed) {
-          // Botón fue presionado
-          button.lastPressTime = currentTime;
-          button.state = BUTTON_PRESSED;
-          button.wasPressed = true;
-          button.longPressDetected = false;
-          button.repeatActive = false;
-        } else {
-          // Botón fue liberado
-          button.lastReleaseTime = currentTime;
-          button.state = BUTTON_RELEASED;
-          button.longPressDetected = false;
-          button.repeatActive = false;
-        }
+  // Aplicar un estado sin rebotes (bit del pin = presionado) ocurrido en time
+  void applyState(uint8_t pressed, uint32_t time) {
+    for (int i = 0; i < 4; i++) {
+      bool isPressed = pressed & bit(buttonPins[i]);
+      if (isPressed != buttons[i].isPressed) {
+        acceptChange(buttons[i], isPressed, time);
       }
     }
+  }
+
+  // Aceptar un cambio de estado ocurrido en time
+  void acceptChange(Button& button, bool pressed, uint32_t time) {
+    button.isPressed = pressed;
+    button.longPressDetected = false;
+    button.repeatActive = false;
     
+    if (pressed) {
+      // Botón fue presionado
+      button.lastPressTime = time;
+      button.state = BUTTON_PRESSED;
+      if (button.pressCount < 255) {
+        button.pressCount++;
+      }
+    } else {
+      // Botón fue liberado
+      button.state = BUTTON_RELEASED;
+    }
+  }
+
+  // Actualizar estado de un botón individual
+  void updateButton(Button& button, uint32_t currentTime) {
     // Detectar pulsación larga
     if (button.isPressed && !button.longPressDetected && 
         (currentTime - button.lastPressTime > BUTTON_LONG_PRESS_TIME)) {
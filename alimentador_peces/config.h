@@ -1,6 +1,6 @@
 /*
   config.h - Configuración global del alimentador de peces
-  
+
   Este archivo contiene todas las configuraciones del sistema:
   - Pines de conexión
   - Tiempos y delays
@@ -17,7 +17,10 @@ const int RELAY_1_PIN = 7;              // Pin del relay
 const int RELAY_2_PIN = 8;              // Pin del relay
 const int RELAY_3_PIN = 9;              // Pin del relay
 const int RELAY_4_PIN = 10;              // Pin del relay
+const uint8_t RELAY_CHANNELS = 4;      // Canales de relay (un tanque por canal)
+const uint8_t RELAY_ALL = 0x0F;        // Todos los canales (bit i = relay i + 1)
 const int BUZZER_PIN = 13;             // Pin del buzzer
+const int RTC_SQW_PIN = A0;            // Pin INT/SQW del DS3231 (A0-A3 usan PCINT1)
 
 // Pines de botones
 const int BUTTON_SELECT_PIN = 2;      // Botón SELECT
@@ -30,21 +33,66 @@ const int LCD_ADDRESS = 0x27;         // Dirección I2C del LCD (cambiar si es n
 const int LCD_COLUMNS = 20;           // Columnas del LCD
 const int LCD_ROWS = 4;               // Filas del LCD
 const bool USE_LCD = true;            // Habilitar LCD
+const uint32_t LCD_BOOT_SCREEN_TIME = 2000;      // Pantalla de inicio visible (ms)
+const unsigned int LCD_FLUSH_BUDGET = 24;   // Bytes al HD44780 por pasada (caben en las tandas del driver)
+
+// === CONFIGURACIÓN DEL BUS I2C ===
+const int RTC_ADDRESS = 0x68;                  // Dirección I2C del DS3231
+const uint32_t TWI_FREQUENCY = 100000;         // Reloj SCL (Hz)
+const uint32_t TWI_TIMEOUT = 20;               // Transacción colgada: liberar el bus (ms)
+const uint8_t TWI_MAX_DEVICES = 2;             // Dispositivos con estadísticas (RTC y LCD)
 
 // === CONFIGURACIÓN DE TIEMPOS ===
 const int FEED_DURATION = 10;          // Duración de alimentación en segundos
-const unsigned long LOOP_DELAY = 100; // Delay del loop principal (ms)
-const unsigned long TIME_DISPLAY_INTERVAL = 30000; // Mostrar hora cada 30s
+const uint16_t FEED_PULSE_ON_MS = 500;  // Tren de pulsos (tornillo sin fin): relays encendidos (ms)
+const uint16_t FEED_PULSE_OFF_MS = 0;   // Relays apagados entre pulsos (ms); 0 = encendidos toda la alimentación
+const uint16_t RELAY_STAGGER_MS = 250;  // Separación entre arranques de canales (corriente de arranque); 0 = juntos
+const uint32_t TIME_DISPLAY_INTERVAL = 30000;      // Mostrar hora cada 30s
+const uint32_t RTC_SNAPSHOT_MAX_AGE = 250;         // Antigüedad máxima de la copia de la hora del RTC (ms)
+
+// === CONFIGURACIÓN DEL RELOJ POR SQW ===
+const bool USE_RTC_SQW = false;                    // Contar segundos con la onda de 1 Hz del DS3231
+const uint32_t RTC_RESYNC_INTERVAL = 300000;       // Relectura del DS3231 por I2C (5 min)
+const uint32_t RTC_SQW_TIMEOUT = 2500;             // Sin flancos en este tiempo: volver a leer por I2C (ms)
+
+// === CONFIGURACIÓN DE LA ALARMA DEL DS3231 ===
+// INT/SQW es un solo pin: con la alarma no hay onda de 1 Hz y los segundos
+// se cuentan con millis() entre lecturas. Elegir uno de los dos modos
+const bool USE_RTC_ALARM = true;                   // Disparar los horarios con la alarma 1 del DS3231
+static_assert(!(USE_RTC_SQW && USE_RTC_ALARM), "USE_RTC_SQW y USE_RTC_ALARM usan el mismo pin INT/SQW");
+const uint32_t RTC_ALARM_RESYNC_INTERVAL = 60000;      // Relectura del DS3231 por I2C entre alarmas (ms)
+const uint32_t RTC_ALARM_GRACE = 2;                // Alarma que no llegó: disparar por software tras estos segundos
+
+// === AHORRO DE ENERGÍA ===
+// En reposo el loop duerme en power-down: lo despiertan los botones, RX
+// del puerto serie, INT/SQW del DS3231 y, sin onda cuadrada, el watchdog
+const bool USE_POWER_SAVE = true;                  // Dormir entre eventos en lugar de esperar con delay()
+const unsigned int POWER_WATCHDOG_MS = 1000;       // Despertar periódico para el reloj del LCD (se redondea a 16 ms x 2^n, hasta 8 s; 0 = no)
+const uint32_t POWER_PIN_HOLD = 3000;              // Despierto tras un botón o un carácter serie (ms)
+
+// === TAREAS DEL LOOP ===
+const uint16_t TASK_BUTTONS_PERIOD = 5;            // Botones, timeout y menú (ms)
+const uint16_t TASK_RELAY_PERIOD = 10;             // Cola de alimentación y relays (ms)
+const uint16_t TASK_SCHEDULE_PERIOD = 1000;        // Horarios (ms; además a cada segundo nuevo y con la alarma)
+const uint16_t TASK_LCD_PERIOD = 200;              // Pantalla (ms; además a cada segundo nuevo)
+
+// === PERFIL DEL LOOP ===
+const bool USE_LOOP_PROFILER = true;               // Medir con micros() cada etapa del loop
+const uint8_t PROFILE_BUCKETS = 10;                // Histograma: < 16 us, < 32 us... < 4096 us y el resto
+const uint8_t PROFILE_FIRST_BUCKET_SHIFT = 4;      // Límite del primer tramo: 2^4 = 16 us
 
 // === CONFIGURACIÓN DE BOTONES ===
-const unsigned long BUTTON_DEBOUNCE_DELAY = 50;    // Debounce de botones (ms)
-const unsigned long BUTTON_LONG_PRESS_TIME = 1000; // Tiempo para pulsación larga (ms)
-const unsigned long BUTTON_REPEAT_DELAY = 200;     // Delay para repetición (ms)
+const uint8_t BUTTON_SAMPLE_TICKS = 2;             // Ticks del Timer0 (~1 ms) entre muestras; anti-rebote = 4 muestras (~8 ms)
+const uint32_t BUTTON_LONG_PRESS_TIME = 1000;      // Tiempo para pulsación larga (ms)
+const uint32_t BUTTON_REPEAT_DELAY = 200;          // Delay para repetición (ms)
+const uint8_t BUTTON_EVENT_QUEUE_SIZE = 16;        // Cambios de botones en espera de update()
 
 // === CONFIGURACIÓN DE MENÚS ===
-const unsigned long MENU_TIMEOUT = 30000;          // Timeout del menú (30s)
-const unsigned long DISPLAY_UPDATE_INTERVAL = 1000; // Actualización display (ms)
-const unsigned long CLOCK_UPDATE_INTERVAL = 5000;   // Actualización reloj (ms)
+const uint32_t MENU_TIMEOUT = 30000;               // Timeout del menú (30s)
+const uint32_t DISPLAY_UPDATE_INTERVAL = 1000;      // Actualización display (ms)
+const uint32_t CLOCK_UPDATE_INTERVAL = 5000;        // Actualización reloj (ms)
+const int MAIN_MENU_OPTIONS = 5;                    // Opciones del menú principal
+const int SCHEDULE_LIST_ROWS = 3;                   // Horarios por pantalla en la lista
 
 // === HORARIOS PREDETERMINADOS ===
 // Horario 1: 8:00 AM
@@ -75,6 +123,11 @@ const unsigned long CLOCK_UPDATE_INTERVAL = 5000;   // Actualización reloj (ms)
 #define MSG_FEED_COMPLETED "Alimentación completada"
 #define MSG_FEED_MANUAL "Alimentación manual iniciada"
 #define MSG_FEED_STOPPED "Alimentación detenida"
+#define MSG_FEED_QUEUED "Relays ocupados: pedido en cola"
+#define MSG_FEED_MERGED "Pedido unido a otro en curso o en cola"
+#define MSG_FEED_REJECTED "Cola de alimentación llena"
+#define MSG_PROFILE_RESET "Perfil del loop reiniciado"
+#define MSG_TASKS_RESET "Estadísticas de tareas reiniciadas"
 #define MSG_SCHEDULE_UPDATED "Horario actualizado"
 #define MSG_SCHEDULE_DISABLED "Horario deshabilitado"
 #define MSG_SCHEDULE_ENABLED "Horario habilitado"
@@ -89,6 +142,10 @@ const unsigned long CLOCK_UPDATE_INTERVAL = 5000;   // Actualización reloj (ms)
 #define MSG_COMMAND_SCHEDULES "schedules - Ver horarios"
 #define MSG_COMMAND_FEED "feed - Alimentar manualmente"
 #define MSG_COMMAND_STOP "stop - Parar alimentación"
+#define MSG_COMMAND_QUEUE "queue - Ver pedidos de alimentación en cola"
+#define MSG_COMMAND_POWER "power - Ver tiempo despierto y dormido"
+#define MSG_COMMAND_PROF "prof [reset] - Ver (o reiniciar) tiempos del loop"
+#define MSG_COMMAND_TASKS "tasks [reset] - Ver (o reiniciar) plazos y atrasos de las tareas"
 #define MSG_COMMAND_NEXT "next - Ver próximo horario"
 #define MSG_COMMAND_SET "set X HH:MM - Configurar horario X"
 #define MSG_COMMAND_SET_OFF "set X off - Deshabilitar horario X"
@@ -114,13 +171,26 @@ const bool SERIAL_ENABLED = true;     // Habilitar comunicación serial
 
 // === CONFIGURACIÓN DE MEMORIA EEPROM ===
 const int EEPROM_SCHEDULE_START = 0;  // Dirección inicial para horarios
-const int EEPROM_SCHEDULE_SIZE = 3;   // Tamaño de cada horario (hora, minuto, enabled)
+const int EEPROM_SCHEDULE_SIZE = 3;   // Tamaño de cada horario (entrada empaquetada + duración)
+const int EEPROM_STORE_SIZE = 1024;   // Bytes del anillo de registros (toda la EEPROM del Uno)
+const uint8_t EEPROM_RECORD_VERSION = 2; // Versión del formato de registro (1 = sin relays ni duración)
 
 // === CONFIGURACIÓN DE ALIMENTACIÓN ===
 const int MIN_FEED_DURATION = 1;      // Duración mínima (segundos)
 const int MAX_FEED_DURATION = 30;     // Duración máxima (segundos)
 const int EMERGENCY_STOP_DURATION = 1; // Duración para parada de emergencia
 
+// Cola de pedidos de alimentación (feed_queue.h)
+const uint8_t FEED_QUEUE_SIZE = 8;         // Pedidos en espera como máximo
+const uint8_t FEED_PRIORITY_SCHEDULE = 2;  // Los horarios salen antes...
+const uint8_t FEED_PRIORITY_MANUAL = 1;    // ...que el botón y el comando "feed"
+
+// Reglas para juntar pedidos que se solapan (combinar con |)
+const uint8_t FEED_COALESCE_MANUAL = 0x01;    // Un pedido manual se une al manual que espera con algún relay en común
+const uint8_t FEED_COALESCE_ACTIVE = 0x02;    // Un pedido manual no incluye los relays que ya alimentan
+const uint8_t FEED_COALESCE_SCHEDULE = 0x04;  // Un horario se une al horario que espera con algún relay en común
+const uint8_t FEED_COALESCE_RULES = FEED_COALESCE_MANUAL | FEED_COALESCE_ACTIVE;
+
 // === CONFIGURACIÓN DE VALIDACIÓN ===
 const int MIN_HOUR = 0;               // Hora mínima
 const int MAX_HOUR = 23;              // Hora máxima
@@ -134,20 +204,38 @@ const int BEEP_SHORT = 100;           // Duración beep corto (ms)
 const int BEEP_LONG = 300;            // Duración beep largo (ms)
 const int BEEP_ERROR = 500;           // Duración beep de error (ms)
 const int BEEP_FREQUENCY = 1000;      // Frecuencia del beep (Hz)
+const int BEEP_QUEUE_SIZE = 4;        // Sonidos en espera (los que sobran se descartan)
+const int BEEP_PATTERN_GAP = 50;      // Silencio entre dos sonidos seguidos (ms)
+
+// Patrones de sonido: duraciones en ms alternando encendido y apagado, terminados en 0
+const uint16_t BEEP_PATTERN_CLICK[] = {BEEP_SHORT, 0};
+const uint16_t BEEP_PATTERN_CONFIRM[] = {50, 50, 50, 0};
+const uint16_t BEEP_PATTERN_ERROR[] = {200, 100, 200, 0};
 
 // === CONFIGURACIÓN DE COMUNICACIÓN SERIAL ===
 const int SERIAL_BAUD_RATE = 9600;    // Velocidad del puerto serie
+const uint8_t SERIAL_COMMAND_SIZE = 16;  // Caracteres de un comando serial (los que sobran se descartan)
 
 // === ESTRUCTURAS DE DATOS ===
-// Estructura para horarios de alimentación
+// Estructura para horarios de alimentación (vista desempaquetada)
 struct FeedTime {
-  int hour;      // Hora (0-23)
-  int minute;    // Minuto (0-59)
-  bool enabled;  // Habilitado/deshabilitado
+  int hour;          // Hora (0-23)
+  int minute;        // Minuto (0-59)
+  bool enabled;      // Habilitado/deshabilitado
+  uint8_t relays;    // Canales que alimenta (bit i = relay i + 1)
+  uint8_t duration;  // Duración de la alimentación (segundos)
 };
 
 // === CONSTANTES DE HORARIOS ===
-const int MAX_FEED_TIMES = 4;         // Número máximo de horarios
+const int MAX_FEED_TIMES = 64;        // Número máximo de horarios
+const int MINUTES_PER_DAY = 24 * 60;  // Minutos del día (bits del mapa de horarios)
+
+// Horario empaquetado en 2 bytes: minuto del día (11 bits), relays y habilitado.
+// Un horario sin relays está libre
+const uint16_t SCHEDULE_MINUTE_MASK = 0x07FF;   // Minuto del día (0-1439)
+const uint16_t SCHEDULE_RELAY_MASK = 0x7800;    // Relays del horario (bit 11 = relay 1)
+const uint8_t SCHEDULE_RELAY_SHIFT = 11;
+const uint16_t SCHEDULE_FLAG_ENABLED = 0x8000;  // Horario habilitado
 
 // === MENSAJES FALTANTES ===
 #define MSG_ALREADY_FEEDING "Ya se está alimentando"
@@ -0,0 +1,82 @@
+/*
+  coroutine.h - Corrutinas sin pila para secuencias largas
+  
+  Una secuencia que antes esperaba con delay() (parpadear el LED, probar
+  los relays, arrancar el LCD) se escribe como una función que se llama
+  en cada pasada del loop y retorna enseguida: cada espera guarda en la
+  corrutina la línea donde quedó, y la llamada siguiente sigue desde ahí
+  (un switch sobre __LINE__, como las protothreads). Mientras tanto el
+  loop sigue revisando horarios, botones y la parada de emergencia.
+
+  La función retorna bool: false mientras la secuencia sigue, true
+  cuando terminó (y en cada llamada posterior, hasta el próximo start()).
+  Como no hay pila propia, las variables locales no sobreviven a una
+  espera: lo que haga falta entre esperas va en miembros de la clase.
+  Dentro de la secuencia no se puede usar otro switch, y no puede haber
+  dos esperas en la misma línea.
+
+    bool runBlink() {
+      CO_BEGIN(blinkTask);
+      for (blinkCount = 0; blinkCount < blinkTimes; blinkCount++) {
+        writeLed(true);
+        CO_DELAY(blinkTask, blinkMs);
+        writeLed(false);
+        CO_DELAY(blinkTask, blinkMs);
+      }
+      CO_END(blinkTask);
+    }
+*/
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include "config.h"
+
+const uint16_t COROUTINE_IDLE = 0xFFFF;   // Sin empezar o terminada
+
+// Estado de una corrutina: dónde sigue y desde cuándo espera
+struct Coroutine {
+  uint16_t line;              // Línea de la espera en curso (0 = desde el principio)
+  uint32_t waitStart;         // millis() (o micros()) al empezar la espera
+
+  Coroutine() : line(COROUTINE_IDLE), waitStart(0) {}
+
+  // Empezar (o volver a empezar) desde el principio
+  void start() {
+    line = 0;
+  }
+
+  // Abandonar la secuencia donde esté
+  void stop() {
+    line = COROUTINE_IDLE;
+  }
+
+  bool isRunning() const {
+    return line != COROUTINE_IDLE;
+  }
+};
+
+// Principio del cuerpo: sigue desde la última espera
+#define CO_BEGIN(co) switch ((co).line) { case 0:
+
+// Fin del cuerpo: la corrutina queda terminada y retorna true
+#define CO_END(co) } (co).line = COROUTINE_IDLE; return true
+
+// Terminar antes de llegar al final (retorna true, como CO_END)
+#define CO_EXIT(co) do { (co).line = COROUTINE_IDLE; return true; } while (0)
+
+// Ceder el loop una pasada
+#define CO_YIELD(co) do { (co).line = __LINE__; return false; case __LINE__:; } while (0)
+
+// Ceder el loop hasta que se cumpla la condición. El case queda dentro
+// de un if (0): solo se llega a él desde el switch, así el código de
+// antes no "cae" en la etiqueta (sin -Wimplicit-fallthrough)
+#define CO_WAIT_UNTIL(co, condition) do { (co).line = __LINE__; if (0) { case __LINE__:; } if (!(condition)) return false; } while (0)
+
+// Ceder el loop durante 'ms' milisegundos
+#define CO_DELAY(co, ms) do { (co).waitStart = millis(); CO_WAIT_UNTIL(co, millis() - (co).waitStart >= (uint32_t)(ms)); } while (0)
+
+// Ceder el loop durante 'us' microsegundos (esperas cortas de periféricos)
+#define CO_DELAY_US(co, us) do { (co).waitStart = micros(); CO_WAIT_UNTIL(co, micros() - (co).waitStart >= (uint32_t)(us)); } while (0)
+
+#endif // COROUTINE_H
@@ -0,0 +1,123 @@
+/*
+  date_time.h - Fecha y hora (subconjunto de DateTime de RTClib)
+  
+  Misma interfaz que la clase DateTime de RTClib que usaba el sketch:
+  campos año/mes/día/hora/minuto/segundo, conversión a y desde segundos
+  Unix y construcción desde __DATE__/__TIME__. RTClib ya no se incluye
+  porque arrastra la librería Wire, cuya ISR del TWI choca con la de
+  twi_engine.h.
+
+  Como en RTClib, el constructor por campos no normaliza: unixtime()
+  cuenta los días de más o de menos (por ejemplo, día 32 de enero es el
+  1 de febrero) y DateTime(unixtime()) da la fecha normalizada.
+*/
+
+#ifndef DATE_TIME_H
+#define DATE_TIME_H
+
+#include <Arduino.h>
+
+#define SECONDS_FROM_1970_TO_2000 946684800UL
+
+class DateTime {
+private:
+  uint8_t yOff, m, d, hh, mm, ss;
+
+  // Días del año antes del primer día de month (válido de 2000 a 2099)
+  static uint16_t dayOfYearBefore(uint16_t year, uint8_t month) {
+    static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+    uint16_t days = 0;
+    for (uint8_t i = 1; i < month; i++) days += daysInMonth[i - 1];
+    if (month > 2 && year % 4 == 0) days++;
+    return days;
+  }
+
+  // Dos dígitos decimales; un espacio inicial cuenta como 0
+  static uint8_t conv2d(const char* p) {
+    uint8_t v = 0;
+    if ('0' <= *p && *p <= '9') v = *p - '0';
+    return 10 * v + *++p - '0';
+  }
+
+public:
+  // Desde segundos Unix
+  DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000) {
+    t -= SECONDS_FROM_1970_TO_2000;
+    ss = t % 60; t /= 60;
+    mm = t % 60; t /= 60;
+    hh = t % 24;
+    uint16_t days = t / 24;
+    uint8_t leap;
+    for (yOff = 0;; ++yOff) {
+      leap = yOff % 4 == 0;
+      if (days < 365U + leap) break;
+      days -= 365 + leap;
+    }
+    static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+    for (m = 1; m < 12; ++m) {
+      uint8_t daysPerMonth = daysInMonth[m - 1];
+      if (leap && m == 2) ++daysPerMonth;
+      if (days < daysPerMonth) break;
+      days -= daysPerMonth;
+    }
+    d = days + 1;
+  }
+
+  // Desde campos (year admite 2024 o 24)
+  DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0) {
+    if (year >= 2000) year -= 2000;
+    yOff = year; m = month; d = day; hh = hour; mm = min; ss = sec;
+  }
+
+  // Formato de __DATE__ ("Jan  1 2024") y __TIME__ ("12:34:56")
+  DateTime(const char* date, const char* time) {
+    yOff = conv2d(date + 9);
+    switch (date[0]) {
+      case 'J': m = (date[1] == 'a') ? 1 : ((date[2] == 'n') ? 6 : 7); break;
+      case 'F': m = 2; break;
+      case 'A': m = date[2] == 'r' ? 4 : 8; break;
+      case 'M': m = date[2] == 'r' ? 3 : 5; break;
+      case 'S': m = 9; break;
+      case 'O': m = 10; break;
+      case 'N': m = 11; break;
+      case 'D': m = 12; break;
+      default: m = 1; break;
+    }
+    d = conv2d(date + 4);
+    hh = conv2d(time);
+    mm = conv2d(time + 3);
+    ss = conv2d(time + 6);
+  }
+
+#if defined(__AVR__)
+  // Lo mismo con las cadenas en flash: DateTime(F(__DATE__), F(__TIME__))
+  DateTime(const __FlashStringHelper* date, const __FlashStringHelper* time) {
+    char dateText[11];
+    char timeText[8];
+    memcpy_P(dateText, date, sizeof(dateText));
+    memcpy_P(timeText, time, sizeof(timeText));
+    *this = DateTime(dateText, timeText);
+  }
+#endif
+
+  uint16_t year() const { return 2000U + yOff; }
+  uint8_t month() const { return m; }
+  uint8_t day() const { return d; }
+  uint8_t hour() const { return hh; }
+  uint8_t minute() const { return mm; }
+  uint8_t second() const { return ss; }
+
+  // 0 = domingo
+  uint8_t dayOfTheWeek() const {
+    uint32_t days = (unixtime() - SECONDS_FROM_1970_TO_2000) / 86400UL;
+    return (days + 6) % 7;  // 1/1/2000 fue sábado
+  }
+
+  uint32_t unixtime() const {
+    uint16_t days = d - 1 + dayOfYearBefore(yOff, m);
+    days += 365 * yOff + (yOff + 3) / 4;
+    return ((days * 24UL + hh) * 60 + mm) * 60 + ss + SECONDS_FROM_1970_TO_2000;
+  }
+};
+
+#endif // DATE_TIME_H
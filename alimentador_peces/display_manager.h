@@ -29,8 +29,9 @@ enum DisplayMode {
 class DisplayManager {
 private:
   DisplayMode currentMode;
-  unsigned long lastUpdate;
+  uint32_t lastUpdate;
   bool needsUpdate;
+  bool lcdRedrawPending;   // Venció un mensaje temporal del LCD
   
   // LCD Display
   LCDDisplayAVR lcdDisplay;
@@ -43,7 +44,7 @@ private:
 public:
   // Constructor
   DisplayManager(RTCManager* rtc, ScheduleManager* schedule, RelayController* relay) 
-    : currentMode(DISPLAY_CLOCK), lastUpdate(0), needsUpdate(true),
+    : currentMode(DISPLAY_CLOCK), lastUpdate(0), needsUpdate(true), lcdRedrawPending(false),
       lcdDisplay(rtc, schedule, relay),
       rtcManager(rtc), scheduleManager(schedule), relayController(relay) {}
 
@@ -68,11 +69,20 @@ public:
 
   // Actualizar display si es necesario
   void update() {
+    // Al vencer un mensaje temporal hay que redibujar el LCD
+    if (lcdDisplay.update()) {
+      lcdRedrawPending = true;
+      needsUpdate = true;
+    }
+    
     if (needsUpdate || (millis() - lastUpdate > DISPLAY_UPDATE_INTERVAL)) {
       refreshDisplay();
       lastUpdate = millis();
       needsUpdate = false;
     }
+    
+    // Enviar al LCD un tramo del frame pendiente
+    lcdDisplay.flush();
   }
 
   // Forzar actualización
@@ -93,6 +103,14 @@ public:
     return currentMode;
   }
 
+  // Verificar (y consumir) si el LCD quedó libre tras un mensaje temporal;
+  // el menú debe volver a dibujar su pantalla
+  bool takeLCDRedraw() {
+    bool pending = lcdRedrawPending;
+    lcdRedrawPending = false;
+    return pending;
+  }
+
   // Mostrar pantalla de bienvenida
   void showWelcomeScreen() {
     Serial.println(MSG_SYSTEM_START);
@@ -209,14 +227,11 @@ public:
     Serial.println("UP/DOWN: Cambiar selección");
     Serial.println("CONFIRM: Confirmar");
     Serial.println("");
-    Serial.println("1. Ver Horarios");
-    Serial.println("2. Editar Horario 1");
-    Serial.println("3. Editar Horario 2");
-    Serial.println("4. Editar Horario 3");
-    Serial.println("5. Editar Horario 4");
-    Serial.println("6. Alimentar Ahora");
-    Serial.println("7. Ver Estado");
-    Serial.println("8. Salir");
+    Serial.println("1. Horarios (CONFIRM edita)");
+    Serial.println("2. Alimentar Ahora");
+    Serial.println("3. Ver Estado");
+    Serial.println("4. Ajustar Hora");
+    Serial.println("5. Salir");
     Serial.println("=====================\n");
   }
 
@@ -226,6 +241,7 @@ public:
     
     Serial.println("\n=== HORARIOS PROGRAMADOS ===");
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
+      if (!scheduleManager->isScheduleConfigured(i + 1)) continue;
       FeedTime schedule = scheduleManager->getSchedule(i + 1);
       
       Serial.print("Horario ");
@@ -284,18 +300,17 @@ public:
     Serial.println("=====================\n");
   }
 
-  // Mostrar mensaje temporal
+  // Mostrar mensaje temporal (en el LCD queda encima hasta que vence)
   void showMessage(String message, int duration = 2000) {
-    Serial.println("");
-    Serial.println("*** " + message + " ***");
-    Serial.println("");
-    
-    // En una implementación con LCD, aquí se mostraría el mensaje
-    // y se restauraría la pantalla anterior después del tiempo
+    showMessage("*** AVISO ***", message, duration);
   }
 
   // Mostrar mensaje temporal con título
   void showMessage(String title, String message, int duration = 2000) {
+    if (lcdDisplay.isReady()) {
+      lcdDisplay.showMessage(title, message, duration);
+    }
+    
     Serial.println("");
     Serial.println("*** " + title + " ***");
     Serial.println(message);
@@ -304,9 +319,7 @@ public:
 
   // Mostrar mensaje de error
   void showError(String error) {
-    Serial.println("");
-    Serial.println("❌ ERROR: " + error);
-    Serial.println("");
+    showErrorLCD(error);
   }
 
   // Mostrar mensaje de confirmación
@@ -331,17 +344,21 @@ public:
     }
   }
   
-  // Mostrar horarios en LCD
-  void showSchedulesLCD() {
+  // Mostrar horarios en LCD (con el cursor en selected)
+  void showSchedulesLCD(int selected) {
     if (lcdDisplay.isReady()) {
-      lcdDisplay.showSchedules();
+      lcdDisplay.showSchedules(selected);
     }
   }
   
-  // Mostrar editor de horario en LCD
+  // Mostrar editor de horario en LCD. Este editor no cambia relays ni
+  // duración: se muestran los del horario guardado
   void showScheduleEditorLCD(int scheduleNumber, int hour, int minute, bool enabled, int cursorPos) {
     if (lcdDisplay.isReady()) {
-      lcdDisplay.showScheduleEditor(scheduleNumber, hour, minute, enabled, cursorPos);
+      static const int lcdCursor[4] = {0, 1, 3, 5};
+      FeedTime current = scheduleManager->getSchedule(scheduleNumber);
+      lcdDisplay.showScheduleEditor(scheduleNumber, hour, minute, current.duration, enabled,
+                                    current.relays ? current.relays : RELAY_ALL, lcdCursor[cursorPos & 3]);
     }
   }
   
@@ -419,6 +436,7 @@ private:
         showSchedules();
         break;
       case DISPLAY_SCHEDULE_EDIT:
+      case DISPLAY_TIME_ADJUST:
         // Se actualiza desde el menú system
         break;
     }
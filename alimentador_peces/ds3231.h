@@ -0,0 +1,296 @@
+/*
+  ds3231.h - Driver mínimo del DS3231 por registros
+
+  Lee los 7 registros de hora (0x00-0x06) en una sola ráfaga I2C
+  (puntero + START repetido + 7 bytes) y los decodifica con una tabla
+  de decenas BCD a una estructura de 6 bytes y a segundos Unix, sin
+  pasar por DateTime. Las escrituras también son en ráfaga y solo tocan
+  los registros que cambian: writeTime() escribe segundos, minutos y
+  hora; writeDate() escribe día de la semana, día, mes y año. Así
+  ajustar la hora no necesita leer antes la fecha (ni al revés), y no
+  hay carrera si el DS3231 cambia de minuto o de día entre la lectura y
+  la escritura. Cada escritura limpia además la bandera OSF.
+
+  La alarma 1 se programa como alarma diaria (hora, minutos y segundos;
+  el día no se compara). Con INTCN = 1 y A1IE = 1 el pin INT/SQW baja
+  cuando coincide y sigue en bajo hasta limpiar la bandera A1F.
+
+  Todo pasa por trabajos de prioridad alta de twi_engine.h: las
+  funciones retornan enseguida. Las que terminan en Now esperan la
+  respuesta y son solo para setup().
+*/
+
+#ifndef DS3231_H
+#define DS3231_H
+
+#include "config.h"
+#include "date_time.h"
+#include "twi_engine.h"
+
+// Registros del DS3231
+const uint8_t DS3231_REG_TIME = 0x00;      // Segundos, minutos, hora
+const uint8_t DS3231_REG_DATE = 0x03;      // Día de la semana, día, mes, año
+const uint8_t DS3231_REG_ALARM1 = 0x07;    // Segundos, minutos, hora, día de la alarma 1
+const uint8_t DS3231_REG_CONTROL = 0x0E;
+const uint8_t DS3231_REG_STATUS = 0x0F;
+const uint8_t DS3231_CONTROL_INTCN = 0x04; // 0 = onda cuadrada en INT/SQW
+const uint8_t DS3231_CONTROL_RATE = 0x18;  // RS2:RS1 = 0 -> 1 Hz
+const uint8_t DS3231_CONTROL_A1IE = 0x01;  // La alarma 1 baja INT/SQW (con INTCN = 1)
+const uint8_t DS3231_CONTROL_A2IE = 0x02;  // La alarma 2 baja INT/SQW (con INTCN = 1)
+const uint8_t DS3231_STATUS_OSF = 0x80;    // El oscilador se detuvo (hora perdida)
+const uint8_t DS3231_STATUS_A1F = 0x01;    // Sonó la alarma 1 (se limpia escribiendo 0)
+const uint8_t DS3231_STATUS_A2F = 0x02;    // Sonó la alarma 2
+const uint8_t DS3231_ALARM_ANY = 0x80;     // Bit AxMy: no comparar este registro de la alarma
+
+// Hora decodificada de los registros 0x00-0x06 (el día de la semana se descarta)
+struct DS3231Time {
+  uint8_t second;
+  uint8_t minute;
+  uint8_t hour;      // 0-23
+  uint8_t day;       // 1-31
+  uint8_t month;     // 1-12
+  uint8_t year;      // 0-99 (2000-2099)
+};
+
+// Decenas de cada nibble alto BCD (las entradas 10-15 solo evitan
+// leer fuera de la tabla si llega basura del bus)
+static const uint8_t ds3231BcdTens[16] PROGMEM = {
+  0, 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120, 130, 140, 150
+};
+
+// Días del año antes del primer día de cada mes (año no bisiesto)
+static const uint16_t ds3231DaysBeforeMonth[12] PROGMEM = {
+  0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+class DS3231 {
+private:
+  TWIJob readJob;              // Puntero a 0x00 + lectura de 7 bytes
+  TWIJob writeJob;             // Puntero + hasta 7 bytes de hora nueva
+  TWIJob registerJob;          // Un registro suelto (control o estado)
+  TWIJob alarmJob;             // Puntero + registros de la alarma 1
+  uint8_t readPointer;
+  uint8_t timeData[7];
+  uint8_t writeData[8];
+  uint8_t registerData[2];
+  uint8_t alarmData[5];
+  uint8_t statusRegister;      // Último valor conocido del registro de estado
+  uint32_t transactions;       // Trabajos entregados al bus
+
+  static uint8_t fromBcd(uint8_t value) {
+    return pgm_read_byte(&ds3231BcdTens[value >> 4]) + (value & 0x0F);
+  }
+
+  static uint8_t toBcd(uint8_t value) {
+    return value + 6 * (value / 10);
+  }
+
+  static void setupJob(TWIJob& job, const uint8_t* tx, uint8_t txLength, uint8_t* rx, uint8_t rxLength) {
+    job.address = RTC_ADDRESS;
+    job.priority = TWI_PRIORITY_HIGH;
+    job.txData = tx;
+    job.txLength = txLength;
+    job.rxData = rx;
+    job.rxLength = rxLength;
+    job.onComplete = 0;
+    job.status = TWI_JOB_IDLE;
+    job.next = 0;
+  }
+
+  // Entregar un trabajo al bus y contarlo
+  void submit(TWIJob& job) {
+    transactions++;
+    twiBus.submit(&job);
+  }
+
+  // Escribir length bytes desde el registro first y después limpiar OSF
+  void writeBurst(uint8_t first, uint8_t length) {
+    writeData[0] = first;
+    writeJob.txLength = length + 1;
+    submit(writeJob);
+    
+    statusRegister &= ~DS3231_STATUS_OSF;
+    writeRegister(DS3231_REG_STATUS, statusRegister);
+  }
+
+public:
+  // Constructor; onTimeRead se llama desde la interrupción TWI al
+  // terminar cada lectura de la hora
+  DS3231(TWICallback onTimeRead = 0) : readPointer(DS3231_REG_TIME), statusRegister(0), transactions(0) {
+    setupJob(readJob, &readPointer, 1, timeData, sizeof(timeData));
+    readJob.onComplete = onTimeRead;
+    setupJob(writeJob, writeData, sizeof(writeData), 0, 0);
+    setupJob(registerJob, registerData, 2, 0, 0);
+    setupJob(alarmJob, alarmData, sizeof(alarmData), 0, 0);
+  }
+
+  // === LECTURA DE LA HORA ===
+
+  // Pedir los 7 registros de hora; retorna false si ya hay una lectura en curso
+  bool requestTime() {
+    if (twiBus.isPending(&readJob)) return false;
+    submit(readJob);
+    return true;
+  }
+
+  // Verificar si la última lectura sigue en el bus
+  bool isReadPending() {
+    return twiBus.isPending(&readJob);
+  }
+
+  // Verificar si la última lectura terminó bien
+  bool isReadValid() {
+    return readJob.status == TWI_JOB_DONE;
+  }
+
+  // Decodificar la última lectura
+  void getTime(DS3231Time& time) {
+    time.second = fromBcd(timeData[0] & 0x7F);
+    time.minute = fromBcd(timeData[1]);
+    time.hour = fromBcd(timeData[2] & 0x3F);
+    time.day = fromBcd(timeData[4]);
+    time.month = fromBcd(timeData[5] & 0x1F);
+    time.year = fromBcd(timeData[6]);
+  }
+
+  // Leer la hora esperando la respuesta (solo en setup()); después usar getTime()
+  bool readTimeNow() {
+    twiBus.waitFor(&readJob);
+    submit(readJob);
+    return twiBus.waitFor(&readJob) == TWI_JOB_DONE;
+  }
+
+  // Segundos Unix de una hora decodificada (2000-2099)
+  static uint32_t toEpoch(const DS3231Time& time) {
+    uint16_t days = time.year * 365U + (time.year + 3) / 4;
+    days += pgm_read_word(&ds3231DaysBeforeMonth[time.month - 1]);
+    if (time.month > 2 && (time.year & 3) == 0) {
+      days++;
+    }
+    days += time.day - 1;
+    return ((days * 24UL + time.hour) * 60 + time.minute) * 60 + time.second + SECONDS_FROM_1970_TO_2000;
+  }
+
+  // === ESCRITURA ===
+
+  // Escribir segundos, minutos y hora (la fecha no cambia)
+  void writeTime(uint8_t hour, uint8_t minute, uint8_t second) {
+    twiBus.waitFor(&writeJob);
+    writeData[1] = toBcd(second);
+    writeData[2] = toBcd(minute);
+    writeData[3] = toBcd(hour);
+    writeBurst(DS3231_REG_TIME, 3);
+  }
+
+  // Escribir la fecha; dayOfWeek 0 = domingo, como DateTime (la hora no cambia)
+  void writeDate(uint8_t day, uint8_t month, uint8_t year, uint8_t dayOfWeek) {
+    twiBus.waitFor(&writeJob);
+    writeData[1] = toBcd(dayOfWeek ? dayOfWeek : 7);
+    writeData[2] = toBcd(day);
+    writeData[3] = toBcd(month);
+    writeData[4] = toBcd(year);
+    writeBurst(DS3231_REG_DATE, 4);
+  }
+
+  // Escribir hora y fecha en una sola ráfaga
+  void writeDateTime(const DS3231Time& time, uint8_t dayOfWeek) {
+    twiBus.waitFor(&writeJob);
+    writeData[1] = toBcd(time.second);
+    writeData[2] = toBcd(time.minute);
+    writeData[3] = toBcd(time.hour);
+    writeData[4] = toBcd(dayOfWeek ? dayOfWeek : 7);
+    writeData[5] = toBcd(time.day);
+    writeData[6] = toBcd(time.month);
+    writeData[7] = toBcd(time.year);
+    writeBurst(DS3231_REG_TIME, 7);
+  }
+
+  // === ALARMA 1 ===
+
+  // Programar la alarma 1 para todos los días a la hora dada (sin limpiar
+  // OSF: la hora no cambia). Trabajo propio, para saber si llegó al DS3231
+  void writeAlarm1(uint8_t hour, uint8_t minute, uint8_t second) {
+    twiBus.waitFor(&alarmJob);
+    alarmData[0] = DS3231_REG_ALARM1;
+    alarmData[1] = toBcd(second);
+    alarmData[2] = toBcd(minute);
+    alarmData[3] = toBcd(hour);
+    alarmData[4] = DS3231_ALARM_ANY | 1;
+    submit(alarmJob);
+  }
+
+  // Verificar si la escritura de la alarma sigue en el bus
+  bool isAlarmWritePending() {
+    return twiBus.isPending(&alarmJob);
+  }
+
+  // Verificar si la última escritura de la alarma terminó bien
+  bool isAlarmWritten() {
+    return alarmJob.status == TWI_JOB_DONE;
+  }
+
+  // Limpiar las banderas de las alarmas; INT/SQW vuelve a alto
+  void clearAlarmFlags() {
+    statusRegister &= ~(DS3231_STATUS_A1F | DS3231_STATUS_A2F);
+    writeRegister(DS3231_REG_STATUS, statusRegister);
+  }
+
+  // === REGISTROS SUELTOS ===
+
+  // Escribir un registro sin esperar
+  void writeRegister(uint8_t reg, uint8_t value) {
+    twiBus.waitFor(&registerJob);
+    registerData[0] = reg;
+    registerData[1] = value;
+    setupJob(registerJob, registerData, 2, 0, 0);
+    submit(registerJob);
+  }
+
+  // Pedir un registro; retorna false si el anterior sigue en el bus
+  bool requestRegister(uint8_t reg) {
+    if (twiBus.isPending(&registerJob)) return false;
+    registerData[0] = reg;
+    setupJob(registerJob, registerData, 1, &registerData[1], 1);
+    submit(registerJob);
+    return true;
+  }
+
+  // Verificar si el registro pedido (o una escritura) sigue en el bus
+  bool isRegisterPending() {
+    return twiBus.isPending(&registerJob);
+  }
+
+  // Verificar si la lectura del registro terminó bien
+  bool isRegisterValid() {
+    return registerJob.status == TWI_JOB_DONE;
+  }
+
+  // Valor del registro pedido; el de estado queda además para lostPower()
+  uint8_t getRegister() {
+    if (registerData[0] == DS3231_REG_STATUS) {
+      statusRegister = registerData[1];
+    }
+    return registerData[1];
+  }
+
+  // Leer un registro esperando la respuesta (solo en setup())
+  bool readRegisterNow(uint8_t reg, uint8_t& value) {
+    twiBus.waitFor(&registerJob);
+    requestRegister(reg);
+    if (twiBus.waitFor(&registerJob) != TWI_JOB_DONE) return false;
+    value = getRegister();
+    return true;
+  }
+
+  // Verificar si el oscilador se detuvo (según la última lectura del registro de estado)
+  bool lostPower() {
+    return statusRegister & DS3231_STATUS_OSF;
+  }
+
+  // Trabajos I2C entregados desde el arranque (una lectura de hora = 1)
+  uint32_t getTransactionCount() {
+    return transactions;
+  }
+};
+
+#endif // DS3231_H
@@ -0,0 +1,356 @@
+/*
+  eeprom_manager.h - Persistencia de datos en la EEPROM interna
+  
+  Guarda un bloque de datos (los horarios) como registro versionado y
+  protegido con CRC-16, en un anillo de ranuras que ocupa toda el área
+  reservada de la EEPROM:
+  - Cada guardado usa la ranura siguiente (nivelación de desgaste)
+  - El CRC se escribe al final: si se corta la luz a mitad de escritura,
+    esa ranura queda inválida y al arrancar se usa el registro anterior
+  - Solo se escriben los bytes que cambian, y un guardado idéntico al
+    último registro no escribe nada
+  - Al arrancar se recorren las ranuras una sola vez y se carga el
+    registro válido con la secuencia más alta
+
+  save() no espera a la EEPROM: arma la imagen del registro en una cola
+  y retorna. La interrupción EE_READY escribe un byte cada vez que la
+  EEPROM queda libre (3,3 ms por byte), así el loop nunca se detiene.
+  Si se guarda con una escritura en curso, el nuevo registro se arma en
+  update() cuando la cola queda vacía (varios guardados seguidos se
+  juntan en uno).
+
+  Formato de cada ranura:
+  [magic][versión][longitud][secuencia lo][secuencia hi][datos...][CRC lo][CRC hi]
+  El CRC cubre desde la versión hasta el último byte de datos.
+*/
+
+#ifndef EEPROM_MANAGER_H
+#define EEPROM_MANAGER_H
+
+#include <EEPROM.h>
+#include "config.h"
+
+const uint8_t EEPROM_RECORD_MAGIC = 0xA5;    // Marca de ranura escrita
+const int EEPROM_RECORD_HEADER_SIZE = 5;     // magic + versión + longitud + secuencia
+const int EEPROM_RECORD_CRC_SIZE = 2;
+const int EEPROM_QUEUE_SIZE = EEPROM_RECORD_HEADER_SIZE + MAX_FEED_TIMES * EEPROM_SCHEDULE_SIZE +
+                              EEPROM_RECORD_CRC_SIZE;   // Un registro completo
+static_assert(EEPROM_QUEUE_SIZE <= 255, "La cola de EEPROM se indexa con uint8_t");
+
+// Cola de escritura: imagen del registro en curso, atendida por EE_READY
+static uint8_t eepromQueue[EEPROM_QUEUE_SIZE];
+static int eepromQueueAddress = 0;                // Dirección del primer byte de la imagen
+static volatile uint8_t eepromQueueLength = 0;
+static volatile uint8_t eepromQueueHead = 0;      // Próximo byte a escribir
+static volatile uint32_t eepromQueueWrites = 0;
+
+static void eepromQueueService();
+
+#if defined(__AVR__)
+// Iniciar la escritura de un byte sin esperar a que termine
+static inline void eepromStartWrite(int address, uint8_t value) {
+  EEAR = address;
+  EEDR = value;
+  EECR |= bit(EEMPE);
+  EECR |= bit(EEPE);
+}
+
+// EEPE sigue en 1 hasta que el último byte quedó escrito (~3,3 ms)
+static inline bool eepromWriteBusy() {
+  return EECR & bit(EEPE);
+}
+
+static inline void eepromReadyInterrupt(bool enabled) {
+  if (enabled) {
+    EECR |= bit(EERIE);
+  } else {
+    EECR &= ~bit(EERIE);
+  }
+}
+
+// Se dispara mientras la EEPROM está libre y EERIE habilitada
+ISR(EE_READY_vect) {
+  eepromQueueService();
+}
+#else
+// Simulador: misma interfaz sobre el HAL de EEPROM
+static inline void eepromStartWrite(int address, uint8_t value) {
+  EEPROM.startWrite(address, value);
+}
+
+static inline bool eepromWriteBusy() {
+  return !EEPROM.isReady();
+}
+
+static inline void eepromReadyInterrupt(bool enabled) {
+  EEPROM.setReadyInterrupt(enabled ? eepromQueueService : 0);
+}
+#endif
+
+// Escribir el próximo byte que cambia; al vaciarse la cola, apagar la interrupción
+static void eepromQueueService() {
+  while (eepromQueueHead < eepromQueueLength) {
+    int address = eepromQueueAddress + eepromQueueHead;
+    uint8_t value = eepromQueue[eepromQueueHead];
+    eepromQueueHead++;
+    if (EEPROM.read(address) != value) {
+      eepromStartWrite(address, value);
+      eepromQueueWrites++;
+      return;
+    }
+  }
+  eepromReadyInterrupt(false);
+}
+
+class EEPROMManager {
+private:
+  int startAddress;
+  int areaSize;
+  uint8_t dataLength;
+  uint8_t recordVersion;          // Versión que acepta load() (se guarda siempre la actual)
+  uint8_t slotCount;
+  int8_t latestSlot;              // Ranura del último registro válido (-1 = ninguno)
+  uint8_t firstSlot;              // Ranura del primer registro con el anillo vacío
+  uint16_t latestSequence;
+  const uint8_t* pendingData;     // Guardado a la espera de que se vacíe la cola
+
+  int slotSize() {
+    return EEPROM_RECORD_HEADER_SIZE + dataLength + EEPROM_RECORD_CRC_SIZE;
+  }
+
+  int slotAddress(uint8_t slot) {
+    return startAddress + slot * slotSize();
+  }
+
+  // CRC-16 (polinomio 0xA001, el mismo que _crc16_update de avr-libc)
+  static uint16_t crc16Update(uint16_t crc, uint8_t data) {
+    crc ^= data;
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+    }
+    return crc;
+  }
+
+  // Comparar secuencias teniendo en cuenta el desborde de 16 bits
+  static bool isNewer(uint16_t a, uint16_t b) {
+    return (int16_t)(a - b) > 0;
+  }
+
+  // Verificar cabecera y CRC de una ranura; retorna su secuencia
+  bool readSlotHeader(uint8_t slot, uint16_t& sequence) {
+    int address = slotAddress(slot);
+    if (EEPROM.read(address) != EEPROM_RECORD_MAGIC ||
+        EEPROM.read(address + 1) != recordVersion ||
+        EEPROM.read(address + 2) != dataLength) {
+      return false;
+    }
+    
+    uint16_t crc = 0xFFFF;
+    int crcAddress = address + EEPROM_RECORD_HEADER_SIZE + dataLength;
+    for (int i = address + 1; i < crcAddress; i++) {
+      crc = crc16Update(crc, EEPROM.read(i));
+    }
+    uint16_t stored = EEPROM.read(crcAddress) | (EEPROM.read(crcAddress + 1) << 8);
+    if (crc != stored) {
+      return false;
+    }
+    
+    sequence = EEPROM.read(address + 3) | (EEPROM.read(address + 4) << 8);
+    return true;
+  }
+
+  // Bytes de la cola todavía sin escribir
+  uint8_t queueDepth() {
+    return eepromQueueLength - eepromQueueHead;
+  }
+
+  // Armar la imagen del registro en la cola y arrancar la escritura.
+  // Solo con la cola vacía: la interrupción no toca la imagen.
+  void startSave(const uint8_t* data) {
+    uint8_t* image = eepromQueue + EEPROM_RECORD_HEADER_SIZE;
+    
+    // Sin cambios respecto al último registro (la imagen lo conserva): no escribir
+    if (latestSlot >= 0) {
+      bool same = true;
+      for (uint8_t i = 0; i < dataLength && same; i++) {
+        same = image[i] == data[i];
+      }
+      if (same) {
+        return;
+      }
+    }
+    
+    uint8_t slot = (latestSlot < 0) ? firstSlot : (latestSlot + 1) % slotCount;
+    uint16_t sequence = latestSequence + 1;
+    
+    eepromQueue[0] = EEPROM_RECORD_MAGIC;
+    eepromQueue[1] = EEPROM_RECORD_VERSION;
+    eepromQueue[2] = dataLength;
+    eepromQueue[3] = sequence & 0xFF;
+    eepromQueue[4] = sequence >> 8;
+    
+    // El CRC va al final de la imagen: se escribe último y confirma el registro
+    uint16_t crc = 0xFFFF;
+    for (int i = 1; i < EEPROM_RECORD_HEADER_SIZE; i++) {
+      crc = crc16Update(crc, eepromQueue[i]);
+    }
+    for (uint8_t i = 0; i < dataLength; i++) {
+      image[i] = data[i];
+      crc = crc16Update(crc, data[i]);
+    }
+    image[dataLength] = crc & 0xFF;
+    image[dataLength + 1] = crc >> 8;
+    
+    eepromQueueAddress = slotAddress(slot);
+    eepromQueueHead = 0;
+    eepromQueueLength = slotSize();
+    eepromReadyInterrupt(true);
+    
+    latestSlot = slot;
+    latestSequence = sequence;
+  }
+
+public:
+  // Constructor
+  EEPROMManager(int start, int size)
+    : startAddress(start), areaSize(size), dataLength(0), recordVersion(EEPROM_RECORD_VERSION), slotCount(0),
+      latestSlot(-1), firstSlot(0), latestSequence(0), pendingData(0) {}
+
+  // Buscar el registro más reciente y copiar sus datos (una pasada al arrancar).
+  // Retorna false si no hay ningún registro válido; data no se modifica.
+  // Con version anterior lee un formato viejo: llamar a startCurrentFormat()
+  // antes de guardar.
+  bool load(uint8_t* data, uint8_t length, uint8_t version = EEPROM_RECORD_VERSION) {
+    dataLength = length;
+    recordVersion = version;
+    slotCount = (slotSize() <= EEPROM_QUEUE_SIZE) ? areaSize / slotSize() : 0;
+    latestSlot = -1;
+    firstSlot = 0;
+    latestSequence = 0;
+    
+    for (uint8_t slot = 0; slot < slotCount; slot++) {
+      uint16_t sequence;
+      if (!readSlotHeader(slot, sequence)) continue;
+      
+      if (latestSlot < 0 || isNewer(sequence, latestSequence)) {
+        latestSlot = slot;
+        latestSequence = sequence;
+      }
+    }
+    
+    if (latestSlot < 0) {
+      return false;
+    }
+    
+    // Copiar el registro a la imagen de la cola (ya escrita: cola vacía)
+    int address = slotAddress(latestSlot);
+    for (int i = 0; i < slotSize(); i++) {
+      eepromQueue[i] = EEPROM.read(address + i);
+    }
+    for (uint8_t i = 0; i < dataLength; i++) {
+      data[i] = eepromQueue[EEPROM_RECORD_HEADER_SIZE + i];
+    }
+    return true;
+  }
+
+  // Pasar al formato actual con el anillo vacío, después de leer con load()
+  // un registro de una versión anterior. El primer registro nuevo va en la
+  // primera ranura que no pisa al viejo (la siguiente a su final): si se
+  // corta la luz antes de escribir su CRC, el registro viejo sigue intacto
+  // y el próximo arranque vuelve a migrarlo.
+  void startCurrentFormat(uint8_t length) {
+    int oldStart = (latestSlot >= 0) ? slotAddress(latestSlot) : startAddress;
+    int oldEnd = (latestSlot >= 0) ? oldStart + slotSize() : startAddress;
+    
+    dataLength = length;
+    recordVersion = EEPROM_RECORD_VERSION;
+    slotCount = (slotSize() <= EEPROM_QUEUE_SIZE) ? areaSize / slotSize() : 0;
+    latestSlot = -1;
+    firstSlot = 0;
+    
+    // La secuencia sigue desde la del registro viejo
+    int after = (oldEnd - startAddress + slotSize() - 1) / slotSize();
+    for (uint8_t i = 0; i < slotCount; i++) {
+      uint8_t slot = (after + i) % slotCount;
+      int address = slotAddress(slot);
+      if (address >= oldEnd || address + slotSize() <= oldStart) {
+        firstSlot = slot;
+        return;
+      }
+    }
+  }
+
+  // Guardar un nuevo registro en la ranura siguiente sin esperar a la EEPROM.
+  // Llamar antes a load() para fijar la longitud y encontrar la última ranura.
+  // Con una escritura en curso, data se lee al vaciarse la cola (ver update()),
+  // así que debe seguir siendo válido.
+  bool save(const uint8_t* data) {
+    if (slotCount == 0) {
+      return false;
+    }
+    
+    if (queueDepth() > 0) {
+      pendingData = data;
+    } else {
+      startSave(data);
+    }
+    return true;
+  }
+
+  // Llamar en cada pasada del loop: arrancar el guardado pendiente
+  void update() {
+    if (pendingData && queueDepth() == 0) {
+      const uint8_t* data = pendingData;
+      pendingData = 0;
+      startSave(data);
+    }
+  }
+
+  // Bytes en cola sin escribir (0 = nada en curso)
+  int getQueueDepth() {
+    return queueDepth();
+  }
+
+  // Verificar si todo lo guardado ya está en la EEPROM (incluido el último byte)
+  bool isFlushed() {
+    return !pendingData && queueDepth() == 0 && !eepromWriteBusy();
+  }
+
+  // Esperar a que terminen las escrituras (p. ej. antes de reiniciar)
+  void flush() {
+    while (!isFlushed()) {
+      update();
+      delay(1);
+    }
+  }
+
+  // Verificar si hay un registro válido cargado o guardado
+  bool hasRecord() {
+    return latestSlot >= 0;
+  }
+
+  // Secuencia del último registro (cuenta de guardados)
+  uint16_t getSequence() {
+    return latestSequence;
+  }
+
+  // Ranura del último registro (-1 si no hay)
+  int getCurrentSlot() {
+    return latestSlot;
+  }
+
+  // Número de ranuras del anillo
+  int getSlotCount() {
+    return slotCount;
+  }
+
+  // Bytes escritos en la EEPROM desde el arranque
+  uint32_t getBytesWritten() {
+    noInterrupts();
+    uint32_t writes = eepromQueueWrites;
+    interrupts();
+    return writes;
+  }
+};
+
+#endif // EEPROM_MANAGER_H
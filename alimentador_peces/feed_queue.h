@@ -0,0 +1,264 @@
+/*
+  feed_queue.h - Cola de pedidos de alimentación
+  
+  Los pedidos de alimentación (horarios, botón CONFIRM y comando serial
+  "feed") ya no se pierden si los relays que piden están ocupados: cada
+  pedido es un trabajo con sus relays y su dosis que espera en una cola
+  acotada hasta que sus canales quedan libres.
+
+  Los trabajos salen por prioridad (los horarios antes que los pedidos
+  manuales) y, con la misma prioridad, en orden de llegada. Un trabajo
+  que espera un relay lo reserva: uno posterior puede arrancar con otros
+  relays libres, pero no quitarle ese relay cuando se libere. Un trabajo
+  con varios relays arranca los que están libres y sigue esperando los
+  demás, así cada relay recibe su dosis completa.
+
+  Las reglas de FEED_COALESCE_RULES deciden qué pasa con un pedido que
+  se solapa con otro: unirse al que espera (relays sumados, la dosis más
+  larga) o dejar fuera los relays que ya están alimentando. Con la
+  cola llena, un pedido de más prioridad desplaza al último de menos
+  prioridad; si no, se rechaza. Todo corre en el loop: la interrupción
+  del Timer1 solo libera los canales, y la de la alarma del DS3231 solo
+  arranca relays que ningún trabajo en espera reservó.
+*/
+
+#ifndef FEED_QUEUE_H
+#define FEED_QUEUE_H
+
+#include "config.h"
+#include "relay_controller.h"
+
+// Origen de un pedido
+enum FeedSource {
+  FEED_SOURCE_SCHEDULE,   // Horario programado
+  FEED_SOURCE_BUTTON,     // Botón CONFIRM o "Alimentar Ahora"
+  FEED_SOURCE_SERIAL      // Comando serial "feed"
+};
+
+// Resultado de submit()
+enum FeedResult {
+  FEED_STARTED,    // Todos sus relays arrancaron enseguida
+  FEED_QUEUED,     // Espera (del todo o en parte) a que se liberen sus relays
+  FEED_MERGED,     // Se unió a un trabajo en espera o a una dosis en curso
+  FEED_REJECTED    // Cola llena con trabajos de igual o más prioridad
+};
+
+// Pedido en espera
+struct FeedJob {
+  uint8_t id;              // Número de pedido (para saber si ya salió)
+  uint8_t source;          // FeedSource
+  uint8_t relays;          // Relays que faltan por arrancar (bit i = relay i + 1)
+  uint8_t duration;        // Dosis en segundos
+  uint8_t schedule;        // Horario que lo pidió (0 = manual)
+  uint32_t queuedAt;       // millis() al entrar a la cola
+};
+
+class FeedQueue {
+private:
+  RelayController* relayController;
+  FeedJob jobs[FEED_QUEUE_SIZE];   // Ordenados por prioridad y llegada
+  uint8_t count;
+  uint8_t nextId;
+  uint32_t submitted;
+  uint32_t merged;
+  uint32_t rejected;
+
+  static uint8_t priorityOf(uint8_t source) {
+    return source == FEED_SOURCE_SCHEDULE ? FEED_PRIORITY_SCHEDULE : FEED_PRIORITY_MANUAL;
+  }
+
+  static bool isManual(uint8_t source) {
+    return source != FEED_SOURCE_SCHEDULE;
+  }
+
+  // Buscar un trabajo en espera con el que se pueda unir el pedido
+  int findMergeTarget(uint8_t source, uint8_t relays) {
+    uint8_t rule = isManual(source) ? FEED_COALESCE_MANUAL : FEED_COALESCE_SCHEDULE;
+    if (!(FEED_COALESCE_RULES & rule)) return -1;
+    
+    for (uint8_t i = 0; i < count; i++) {
+      if (isManual(jobs[i].source) == isManual(source) && (jobs[i].relays & relays)) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  void removeAt(uint8_t index) {
+    count--;
+    for (uint8_t i = index; i < count; i++) {
+      jobs[i] = jobs[i + 1];
+    }
+  }
+
+  // Insertar detrás de los trabajos de igual o más prioridad
+  void insert(const FeedJob& job) {
+    uint8_t priority = priorityOf(job.source);
+    uint8_t index = count;
+    while (index > 0 && priorityOf(jobs[index - 1].source) < priority) {
+      jobs[index] = jobs[index - 1];
+      index--;
+    }
+    jobs[index] = job;
+    count++;
+  }
+
+  bool isPending(uint8_t id) {
+    for (uint8_t i = 0; i < count; i++) {
+      if (jobs[i].id == id) return true;
+    }
+    return false;
+  }
+
+public:
+  // Constructor
+  FeedQueue(RelayController* relay)
+    : relayController(relay), count(0), nextId(0), submitted(0), merged(0), rejected(0) {}
+
+  // Pedir una dosis de 'duration' segundos para los relays de 'relays'
+  FeedResult submit(FeedSource source, uint8_t relays, int duration = FEED_DURATION, int scheduleNumber = 0) {
+    relays &= RELAY_ALL;
+    if (!relays) return FEED_REJECTED;
+    submitted++;
+    duration = constrain(duration, MIN_FEED_DURATION, MAX_FEED_DURATION);
+    
+    // Un pedido manual no da otra dosis a los relays que ya están
+    // alimentando: sigue solo con los demás, y si no queda ninguno se une
+    if ((FEED_COALESCE_RULES & FEED_COALESCE_ACTIVE) && isManual(source)) {
+      relays &= ~feedChannelsBusy;
+      if (!relays) {
+        merged++;
+        return FEED_MERGED;
+      }
+    }
+    
+    int target = findMergeTarget(source, relays);
+    if (target >= 0) {
+      jobs[target].relays |= relays;
+      if (duration > jobs[target].duration) {
+        jobs[target].duration = duration;
+      }
+      merged++;
+      update();
+      return FEED_MERGED;
+    }
+    
+    if (count == FEED_QUEUE_SIZE) {
+      // El último es el más nuevo de la prioridad más baja
+      if (priorityOf(jobs[count - 1].source) >= priorityOf(source)) {
+        rejected++;
+        return FEED_REJECTED;
+      }
+      count--;
+      rejected++;
+    }
+    
+    FeedJob job;
+    job.id = ++nextId;
+    job.source = source;
+    job.relays = relays;
+    job.duration = duration;
+    job.schedule = scheduleNumber;
+    job.queuedAt = millis();
+    insert(job);
+    
+    update();
+    return isPending(job.id) ? FEED_QUEUED : FEED_STARTED;
+  }
+
+  // Arrancar los trabajos cuyos relays quedaron libres (cada pasada del loop)
+  void update() {
+    uint8_t reserved = 0;
+    uint8_t i = 0;
+    
+    while (i < count) {
+      FeedJob& job = jobs[i];
+      uint8_t ready = job.relays & ~reserved & ~feedChannelsBusy;
+      if (ready) {
+        job.relays &= ~relayController->startFeedingWithRelays(ready, job.duration);
+      }
+      
+      if (!job.relays) {
+        removeAt(i);
+        continue;
+      }
+      reserved |= job.relays;
+      i++;
+    }
+    
+    // La interrupción de la alarma no arranca estos relays
+    feedRelaysReserved = reserved;
+  }
+
+  // Descartar todos los trabajos en espera (parada de emergencia)
+  void clear() {
+    count = 0;
+    feedRelaysReserved = 0;
+  }
+
+  // Trabajos en espera
+  uint8_t getCount() {
+    return count;
+  }
+
+  bool isEmpty() {
+    return count == 0;
+  }
+
+  // Trabajo en espera número index (0 = el próximo en salir)
+  const FeedJob* getJob(uint8_t index) {
+    return index < count ? &jobs[index] : 0;
+  }
+
+  uint32_t getSubmittedCount() {
+    return submitted;
+  }
+
+  uint32_t getMergedCount() {
+    return merged;
+  }
+
+  uint32_t getRejectedCount() {
+    return rejected;
+  }
+
+  // Mostrar los trabajos en espera por Serial
+  void displayQueue() {
+    Serial.println(F("\n=== Cola de Alimentación ==="));
+    if (count == 0) {
+      Serial.println(F("Sin pedidos en espera"));
+    }
+    
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < count; i++) {
+      const FeedJob& job = jobs[i];
+      Serial.print(i + 1);
+      Serial.print(F(": "));
+      if (job.source == FEED_SOURCE_SCHEDULE) {
+        Serial.print(F("Horario "));
+        Serial.print(job.schedule);
+      } else {
+        Serial.print(job.source == FEED_SOURCE_BUTTON ? F("Boton") : F("Serial"));
+      }
+      Serial.print(F(" R"));
+      for (uint8_t r = 0; r < RELAY_CHANNELS; r++) {
+        Serial.print(job.relays & (1 << r) ? (char)('1' + r) : '-');
+      }
+      Serial.print(F(" "));
+      Serial.print(job.duration);
+      Serial.print(F("s, espera "));
+      Serial.print((now - job.queuedAt) / 1000);
+      Serial.println(F("s"));
+    }
+    
+    Serial.print(F("Pedidos: "));
+    Serial.print(submitted);
+    Serial.print(F(", unidos: "));
+    Serial.print(merged);
+    Serial.print(F(", rechazados: "));
+    Serial.println(rejected);
+    Serial.println(F("============================"));
+  }
+};
+
+#endif // FEED_QUEUE_H
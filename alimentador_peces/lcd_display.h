@@ -26,7 +26,7 @@ class LCDDisplay {
 private:
   LiquidCrystal_I2C lcd;
   bool isInitialized;
-  unsigned long lastUpdate;
+  uint32_t lastUpdate;
   
   // Referencias a otros módulos
   RTCManager* rtcManager;
@@ -477,7 +477,7 @@ private:
   }
 
   // Centrar texto en una línea
-  String centerText(String text, int width) {
+  String centerText(String text, unsigned int width) {
     if (text.length() >= width) {
       return text.substring(0, width);
     }
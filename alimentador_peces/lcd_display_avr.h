@@ -1,23 +1,42 @@
 /*
   lcd_display_avr.h - Controlador para LCD 20x4 I2C compatible con AVR
   Versión optimizada para Arduino Uno/Nano
+
+  Las pantallas se dibujan en un LCDFrameBuffer y present() cierra el
+  frame; flush(), llamado en cada pasada del loop, envía al LCD solo las
+  celdas que cambiaron, hasta LCD_FLUSH_BUDGET bytes por pasada. Cada
+  pantalla empieza borrando el buffer sin que el LCD parpadee, y un
+  redibujado completo no bloquea el loop de una sola vez.
+
+  Los mensajes temporales (y la pantalla de inicio) son una capa que
+  tapa la pantalla actual hasta que vence su tiempo; no usan delay().
+  Mientras la capa está activa las demás pantallas no dibujan, y update()
+  avisa cuando vence para que quien llama redibuje la pantalla actual.
 */
 
 #ifndef LCD_DISPLAY_AVR_H
 #define LCD_DISPLAY_AVR_H
 
-#include <LiquidCrystal_I2C.h>
 #include "config.h"
+#include "lcd_pcf8574.h"
+#include "lcd_framebuffer.h"
 #include "rtc_manager.h"
 #include "schedule_manager.h"
 #include "relay_controller.h"
+#include "loop_profiler.h"
 
 class LCDDisplayAVR {
 private:
-  LiquidCrystal_I2C lcd;
+  LCDPCF8574 lcd;
+  LCDFrameBuffer screen;
   bool isInitialized;
-  unsigned long lastUpdate;
-  
+  uint32_t lastUpdate;
+
+  // Capa de mensaje temporal
+  bool overlayActive;
+  uint32_t overlayStart;
+  uint32_t overlayDuration;
+
   // Referencias a otros módulos
   RTCManager* rtcManager;
   ScheduleManager* scheduleManager;
@@ -27,25 +46,23 @@ public:
   // Constructor
   LCDDisplayAVR(RTCManager* rtc, ScheduleManager* schedule, RelayController* relay) 
     : lcd(LCD_ADDRESS, LCD_COLUMNS, LCD_ROWS), isInitialized(false), lastUpdate(0),
-      rtcManager(rtc), scheduleManager(schedule), relayController(relay) {}
+      overlayActive(false), overlayStart(0), overlayDuration(0), rtcManager(rtc), scheduleManager(schedule), relayController(relay) {}
 
   // Inicializar LCD
   bool begin() {
     if (!USE_LCD) return false;
     
-    // Inicialización específica para AVR
-    Wire.begin();
-    delay(100);
-    
-    lcd.init();
+    // El bus ya está configurado desde setup(). El arranque del HD44780
+    // (más de un segundo) sigue en flush(); termina con el LCD borrado
+    lcd.start();
     lcd.backlight();
-    lcd.clear();
+    screen.markCleared();
+    isInitialized = true;
     
-    // Mostrar pantalla de inicio
+    // Pantalla de inicio: queda visible sin detener el arranque
     showBootScreen();
-    delay(2000);
+    startOverlay(LCD_BOOT_SCREEN_TIME);
     
-    isInitialized = true;
     return true;
   }
 
@@ -54,269 +71,341 @@ public:
     return isInitialized && USE_LCD;
   }
 
+  // Llamar en cada pasada del loop; retorna true cuando un mensaje
+  // temporal acaba de vencer y hay que redibujar la pantalla actual
+  bool update() {
+    if (overlayActive && millis() - overlayStart >= overlayDuration) {
+      overlayActive = false;
+      screen.clear();
+      return true;
+    }
+    return false;
+  }
+
+  // Llamar en cada pasada del loop: envía al LCD parte del frame
+  // pendiente; retorna true si el LCD ya muestra el último frame
+  bool flush() {
+    if (!isReady()) return true;
+    if (!lcd.update()) {
+      // El HD44780 sigue arrancando: la pantalla de inicio cuenta desde
+      // que se puede ver
+      overlayStart = millis();
+      return false;
+    }
+    return screen.flush(lcd, LCD_FLUSH_BUDGET);
+  }
+
+  // Verificar si hay un mensaje temporal en pantalla
+  bool isOverlayActive() {
+    return overlayActive;
+  }
+
+  // Quitar el mensaje temporal (la próxima llamada a update() retorna true)
+  void dismissOverlay() {
+    overlayDuration = 0;
+  }
+
   // Limpiar pantalla
   void clear() {
-    if (!isReady()) return;
-    lcd.clear();
+    if (!canDraw()) return;
+    screen.clear();
+    present();
+  }
+
+  // Bytes enviados al LCD en el último frame con cambios
+  unsigned int getLastFrameBytes() {
+    return screen.getLastFrameBytes();
+  }
+
+  // Bytes enviados al LCD desde el arranque
+  uint32_t getTotalBytes() {
+    return screen.getTotalBytes();
+  }
+
+  // Frames con cambios enviados al LCD
+  uint32_t getFrameCount() {
+    return screen.getFrameCount();
+  }
+
+  // Frames dibujados que aún no terminaron de enviarse
+  uint8_t getFramesPending() {
+    return screen.getFramesPending();
+  }
+
+  // Pasadas del loop que tardó en enviarse el último frame
+  unsigned int getLastFramePasses() {
+    return screen.getLastFramePasses();
   }
 
   // Mostrar pantalla de inicio
   void showBootScreen() {
     if (!isReady()) return;
     
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("   ALIMENTADOR DE   ");
-    lcd.setCursor(0, 1);
-    lcd.print("    PECES v3.0      ");
-    lcd.setCursor(0, 2);
-    lcd.print("  Con LCD y Botones ");
-    lcd.setCursor(0, 3);
-    lcd.print("   Iniciando...     ");
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("   ALIMENTADOR DE   ");
+    screen.setCursor(0, 1);
+    screen.print("    PECES v3.0      ");
+    screen.setCursor(0, 2);
+    screen.print("  Con LCD y Botones ");
+    screen.setCursor(0, 3);
+    screen.print("   Iniciando...     ");
+    present();
   }
 
   // Mostrar reloj principal
   void showClock() {
-    if (!isReady()) return;
+    if (!canDraw()) return;
     
     DateTime now = rtcManager->now();
+    screen.clear();
     
     // Línea 1: Título
-    lcd.setCursor(0, 0);
-    lcd.print("    ALIMENTADOR     ");
+    screen.setCursor(0, 0);
+    screen.print("    ALIMENTADOR     ");
     
     // Línea 2: Hora grande
-    lcd.setCursor(0, 1);
-    lcd.print("    ");
+    screen.setCursor(0, 1);
+    screen.print("    ");
     printTwoDigits(now.hour());
-    lcd.print(":");
+    screen.print(":");
     printTwoDigits(now.minute());
-    lcd.print(":");
+    screen.print(":");
     printTwoDigits(now.second());
-    lcd.print("    ");
+    screen.print("    ");
     
     // Línea 3: Fecha
-    lcd.setCursor(0, 2);
-    lcd.print("   ");
+    screen.setCursor(0, 2);
+    screen.print("   ");
     printTwoDigits(now.day());
-    lcd.print("/");
+    screen.print("/");
     printTwoDigits(now.month());
-    lcd.print("/");
-    lcd.print(now.year());
-    lcd.print("   ");
+    screen.print("/");
+    screen.print(now.year());
+    screen.print("   ");
     
     // Línea 4: Estado o próximo horario
-    lcd.setCursor(0, 3);
+    screen.setCursor(0, 3);
     if (relayController->isFeedingActive()) {
-      lcd.print("  ALIMENTANDO ");
-      lcd.print(relayController->getRemainingFeedTime());
-      lcd.print("s  ");
+      screen.print("  ALIMENTANDO ");
+      screen.print(relayController->getRemainingFeedTime());
+      screen.print("s  ");
     } else {
       int nextSchedule = scheduleManager->getNextSchedule(*rtcManager);
       if (nextSchedule > 0) {
         FeedTime next = scheduleManager->getSchedule(nextSchedule);
-        lcd.print("Proximo: ");
+        screen.print("Proximo: ");
         printTwoDigits(next.hour);
-        lcd.print(":");
+        screen.print(":");
         printTwoDigits(next.minute);
-        lcd.print(" H");
-        lcd.print(nextSchedule);
+        screen.print(" H");
+        screen.print(nextSchedule);
       } else {
-        lcd.print("  Sin horarios      ");
+        screen.print("  Sin horarios      ");
       }
     }
+    present();
   }
 
   // Mostrar menú principal
   void showMainMenu(int selectedOption) {
-    if (!isReady()) return;
+    if (!canDraw()) return;
     
-    String options[] = {"", "Ver Horarios", "Editar Horario 1", "Editar Horario 2", 
-                       "Editar Horario 3", "Editar Horario 4", "Alimentar Ahora", 
-                       "Ver Estado", "Ajustar Hora", "Salir"};
+    String options[] = {"", "Horarios", "Alimentar Ahora", "Ver Estado",
+                       "Ajustar Hora", "Salir"};
     
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("===== MENU =====");
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("===== MENU =====");
     
     // Mostrar 3 opciones centradas alrededor de la seleccionada
-    int startOption = max(1, min(selectedOption - 1, 7));
+    int startOption = max(1, min(selectedOption - 1, MAIN_MENU_OPTIONS - 2));
     
-    for (int i = 0; i < 3 && (startOption + i) <= 9; i++) {
-      lcd.setCursor(0, i + 1);
+    for (int i = 0; i < 3 && (startOption + i) <= MAIN_MENU_OPTIONS; i++) {
+      screen.setCursor(0, i + 1);
       
       if (startOption + i == selectedOption) {
-        lcd.print(">");
+        screen.print(">");
       } else {
-        lcd.print(" ");
+        screen.print(" ");
       }
       
       String option = options[startOption + i];
       if (option.length() > 18) {
         option = option.substring(0, 18);
       }
-      lcd.print(option);
-      
-      // Limpiar resto de la línea
-      for (int j = option.length() + 1; j < 20; j++) {
-        lcd.print(" ");
-      }
+      screen.print(option);
     }
+    present();
   }
 
-  // Mostrar horarios
-  void showSchedules() {
-    if (!isReady()) return;
+  // Mostrar horarios (página de SCHEDULE_LIST_ROWS con el cursor en selected)
+  void showSchedules(int selected) {
+    if (!canDraw()) return;
+    
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("== HORARIOS ");
+    printTwoDigits(selected);
+    screen.print("/");
+    printTwoDigits(MAX_FEED_TIMES);
+    screen.print(" ==");
     
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("==== HORARIOS ====");
+    int nextSchedule = scheduleManager->getNextSchedule(*rtcManager);
+    int first = selected - (selected - 1) % SCHEDULE_LIST_ROWS;
     
-    for (int i = 0; i < min(3, MAX_FEED_TIMES); i++) {
-      FeedTime schedule = scheduleManager->getSchedule(i + 1);
+    for (int row = 0; row < SCHEDULE_LIST_ROWS && first + row <= MAX_FEED_TIMES; row++) {
+      int number = first + row;
+      FeedTime schedule = scheduleManager->getSchedule(number);
       
-      lcd.setCursor(0, i + 1);
-      lcd.print("H");
-      lcd.print(i + 1);
-      lcd.print(": ");
-      
-      if (schedule.enabled) {
-        printTwoDigits(schedule.hour);
-        lcd.print(":");
-        printTwoDigits(schedule.minute);
-        lcd.print(" ON ");
-      } else {
-        lcd.print("--:-- OFF");
-      }
+      screen.setCursor(0, row + 1);
+      screen.print(number == selected ? ">" : " ");
+      screen.print("H");
+      printTwoDigits(number);
+      screen.print(": ");
       
-      // Mostrar próximo indicador si es el siguiente
-      int nextSchedule = scheduleManager->getNextSchedule(*rtcManager);
-      if (nextSchedule == i + 1) {
-        lcd.print(" <");
+      if (!scheduleManager->isScheduleConfigured(number)) {
+        screen.print("--:-- ---");
       } else {
-        lcd.print("  ");
-      }
-    }
-    
-    // Mostrar horario 4 en la línea 4 si existe
-    if (MAX_FEED_TIMES > 3) {
-      FeedTime schedule = scheduleManager->getSchedule(4);
-      lcd.setCursor(0, 3);
-      lcd.print("H4: ");
-      
-      if (schedule.enabled) {
         printTwoDigits(schedule.hour);
-        lcd.print(":");
+        screen.print(":");
         printTwoDigits(schedule.minute);
-        lcd.print(" ON ");
-      } else {
-        lcd.print("--:-- OFF");
+        screen.print(schedule.enabled ? " ON " : " OFF");
       }
       
-      int nextSchedule = scheduleManager->getNextSchedule(*rtcManager);
-      if (nextSchedule == 4) {
-        lcd.print(" <");
-      }
+      // Mostrar próximo indicador si es el siguiente
+      screen.print(nextSchedule == number ? " <" : "  ");
     }
+    present();
   }
 
-  // Mostrar editor de horario
-  void showScheduleEditor(int scheduleNumber, int hour, int minute, bool enabled, int cursorPos) {
-    if (!isReady()) return;
-    
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("=== EDITAR H");
-    lcd.print(scheduleNumber);
-    lcd.print(" ===");
-    
-    // Línea 2: Hora
-    lcd.setCursor(0, 1);
-    lcd.print("Hora: ");
-    if (cursorPos == 0) lcd.print("[");
+  // Mostrar editor de horario (relays: bit i = relay i + 1)
+  void showScheduleEditor(int scheduleNumber, int hour, int minute, int duration, bool enabled, uint8_t relays, int cursorPos) {
+    if (!canDraw()) return;
+    
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("=== EDITAR H");
+    screen.print(scheduleNumber);
+    screen.print(" ===");
+    
+    // Línea 2: Hora y duración
+    screen.setCursor(0, 1);
+    screen.print("Hora: ");
+    if (cursorPos == 0) screen.print("[");
     printTwoDigits(hour);
-    if (cursorPos == 0) lcd.print("]"); else lcd.print(" ");
-    lcd.print(":");
-    if (cursorPos == 1) lcd.print("[");
+    if (cursorPos == 0) screen.print("]"); else screen.print(" ");
+    screen.print(":");
+    if (cursorPos == 1) screen.print("[");
     printTwoDigits(minute);
-    if (cursorPos == 1) lcd.print("]"); else lcd.print(" ");
-    
-    // Línea 3: Estado
-    lcd.setCursor(0, 2);
-    lcd.print("Estado: ");
-    if (cursorPos == 2) lcd.print("[");
-    lcd.print(enabled ? "ON " : "OFF");
-    if (cursorPos == 2) lcd.print("]"); else lcd.print(" ");
+    if (cursorPos == 1) screen.print("]"); else screen.print(" ");
+    screen.print(" ");
+    if (cursorPos == 2) screen.print("[");
+    printTwoDigits(duration);
+    if (cursorPos == 2) screen.print("]");
+    screen.print("s");
+    
+    // Línea 3: Estado y relays ("R1-3-": guion = relay sin usar)
+    screen.setCursor(0, 2);
+    screen.print("Estado: ");
+    if (cursorPos == 3) screen.print("[");
+    screen.print(enabled ? "ON " : "OFF");
+    if (cursorPos == 3) screen.print("]"); else screen.print(" ");
+    screen.print("R");
+    if (cursorPos == 4) screen.print("[");
+    for (uint8_t i = 0; i < RELAY_CHANNELS; i++) {
+      screen.print(relays & (1 << i) ? (char)('1' + i) : '-');
+    }
+    if (cursorPos == 4) screen.print("]");
     
     // Línea 4: Instrucciones
-    lcd.setCursor(0, 3);
-    if (cursorPos == 3) {
-      lcd.print("CONFIRM: Guardar    ");
+    screen.setCursor(0, 3);
+    if (cursorPos == 5) {
+      screen.print("CONFIRM: Guardar    ");
     } else {
-      lcd.print("UP/DOWN SELECT CONF ");
+      screen.print("UP/DOWN SELECT CONF ");
     }
+    present();
   }
 
   // Mostrar estado del sistema
   void showStatus() {
-    if (!isReady()) return;
+    if (!canDraw()) return;
     
     DateTime now = rtcManager->now();
     
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("===== ESTADO =====");
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("===== ESTADO =====");
     
     // Línea 2: Hora actual
-    lcd.setCursor(0, 1);
-    lcd.print("Hora: ");
+    screen.setCursor(0, 1);
+    screen.print("Hora: ");
     printTwoDigits(now.hour());
-    lcd.print(":");
+    screen.print(":");
     printTwoDigits(now.minute());
-    lcd.print(":");
+    screen.print(":");
     printTwoDigits(now.second());
     
     // Línea 3: Estado del relay
-    lcd.setCursor(0, 2);
+    screen.setCursor(0, 2);
     if (relayController->isFeedingActive()) {
-      lcd.print("Alimentando ");
-      lcd.print(relayController->getRemainingFeedTime());
-      lcd.print("s");
+      screen.print("Alimentando ");
+      screen.print(relayController->getRemainingFeedTime());
+      screen.print("s");
     } else {
-      lcd.print("Relay: ");
-      lcd.print(relayController->getRelayState() ? "ON " : "OFF");
+      screen.print("Relay: ");
+      screen.print(relayController->getRelayState() ? "ON " : "OFF");
     }
     
     // Línea 4: Horarios activos
-    lcd.setCursor(0, 3);
-    lcd.print("Activos: ");
-    lcd.print(scheduleManager->getEnabledSchedulesCount());
-    lcd.print("/");
-    lcd.print(MAX_FEED_TIMES);
+    screen.setCursor(0, 3);
+    screen.print("Activos: ");
+    screen.print(scheduleManager->getEnabledSchedulesCount());
+    screen.print("/");
+    screen.print(MAX_FEED_TIMES);
     
+    // Con 64 horarios no cabe también la hora: solo el número del próximo
     int nextSchedule = scheduleManager->getNextSchedule(*rtcManager);
     if (nextSchedule > 0) {
-      FeedTime next = scheduleManager->getSchedule(nextSchedule);
-      lcd.print(" H");
-      lcd.print(nextSchedule);
-      lcd.print(":");
-      printTwoDigits(next.hour);
-      printTwoDigits(next.minute);
+      screen.print(" H");
+      screen.print(nextSchedule);
     }
+    present();
   }
 
-  // Mostrar mensaje temporal
+  // Segunda página del estado: media y máximo de cada etapa del loop
+  // ("H 12 340": horarios, media 12 us, máximo 340 us), dos por línea
+  void showProfile(LoopProfiler& profiler) {
+    if (!canDraw()) return;
+    
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("PERFIL med/max R");
+    screen.print(profiler.getResetCount());
+    
+    for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+      screen.setCursor((i % 2) * 10, 1 + i / 2);
+      screen.print(LoopProfiler::getStageCode(i));
+      printMicros(profiler.getMeanUs(i));
+      printMicros(profiler.getStage(i).maxUs);
+    }
+    present();
+  }
+
+  // Mostrar mensaje temporal durante duration ms (retorna enseguida)
   void showMessage(String title, String message, int duration = 2000) {
     if (!isReady()) return;
     
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print(centerText(title, 20));
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print(centerText(title, 20));
     
-    lcd.setCursor(0, 2);
-    lcd.print(centerText(message, 20));
+    screen.setCursor(0, 2);
+    screen.print(centerText(message, 20));
+    present();
     
-    delay(duration);
+    startOverlay(duration);
   }
 
   // Mostrar mensaje de confirmación
@@ -331,65 +420,67 @@ public:
 
   // Mostrar pantalla de alimentación
   void showFeeding(int remainingTime) {
-    if (!isReady()) return;
+    if (!canDraw()) return;
     
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("==== ALIMENTANDO ===");
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("==== ALIMENTANDO ===");
     
-    lcd.setCursor(0, 1);
-    lcd.print("                    ");
+    screen.setCursor(0, 1);
+    screen.print("                    ");
     
-    lcd.setCursor(0, 2);
-    lcd.print("   Tiempo: ");
-    lcd.print(remainingTime);
-    lcd.print("s     ");
+    screen.setCursor(0, 2);
+    screen.print("   Tiempo: ");
+    screen.print(remainingTime);
+    screen.print("s     ");
     
-    lcd.setCursor(0, 3);
-    lcd.print("  SELECT: Parar     ");
+    screen.setCursor(0, 3);
+    screen.print("  SELECT: Parar     ");
+    present();
   }
 
   // Mostrar pantalla de ajuste de hora/fecha
   void showTimeAdjust(int hour, int minute, int day, int month, int year, int cursorPos) {
-    if (!isReady()) return;
+    if (!canDraw()) return;
     
-    lcd.clear();
-    lcd.setCursor(0, 0);
-    lcd.print("=== AJUSTAR HORA ===");
+    screen.clear();
+    screen.setCursor(0, 0);
+    screen.print("=== AJUSTAR HORA ===");
     
     // Línea 2: Hora
-    lcd.setCursor(0, 1);
-    lcd.print("Hora: ");
-    if (cursorPos == 0) lcd.print("[");
+    screen.setCursor(0, 1);
+    screen.print("Hora: ");
+    if (cursorPos == 0) screen.print("[");
     printTwoDigits(hour);
-    if (cursorPos == 0) lcd.print("]"); else lcd.print(" ");
-    lcd.print(":");
-    if (cursorPos == 1) lcd.print("[");
+    if (cursorPos == 0) screen.print("]"); else screen.print(" ");
+    screen.print(":");
+    if (cursorPos == 1) screen.print("[");
     printTwoDigits(minute);
-    if (cursorPos == 1) lcd.print("]"); else lcd.print(" ");
+    if (cursorPos == 1) screen.print("]"); else screen.print(" ");
     
     // Línea 3: Fecha
-    lcd.setCursor(0, 2);
-    lcd.print("Fecha: ");
-    if (cursorPos == 2) lcd.print("[");
+    screen.setCursor(0, 2);
+    screen.print("Fecha: ");
+    if (cursorPos == 2) screen.print("[");
     printTwoDigits(day);
-    if (cursorPos == 2) lcd.print("]"); else lcd.print(" ");
-    lcd.print("/");
-    if (cursorPos == 3) lcd.print("[");
+    if (cursorPos == 2) screen.print("]"); else screen.print(" ");
+    screen.print("/");
+    if (cursorPos == 3) screen.print("[");
     printTwoDigits(month);
-    if (cursorPos == 3) lcd.print("]"); else lcd.print(" ");
-    lcd.print("/");
-    if (cursorPos == 4) lcd.print("[");
-    lcd.print(year);
-    if (cursorPos == 4) lcd.print("]"); else lcd.print(" ");
+    if (cursorPos == 3) screen.print("]"); else screen.print(" ");
+    screen.print("/");
+    if (cursorPos == 4) screen.print("[");
+    screen.print(year);
+    if (cursorPos == 4) screen.print("]"); else screen.print(" ");
     
     // Línea 4: Instrucciones
-    lcd.setCursor(0, 3);
+    screen.setCursor(0, 3);
     if (cursorPos == 5) {
-      lcd.print("CONFIRM: Guardar    ");
+      screen.print("CONFIRM: Guardar    ");
     } else {
-      lcd.print("UP/DOWN SELECT CONF ");
+      screen.print("UP/DOWN SELECT CONF ");
     }
+    present();
   }
 
   // Crear caracteres personalizados
@@ -426,22 +517,53 @@ public:
 
   // Mostrar caracteres personalizados
   void showCustomChar(int charIndex, int col, int row) {
-    if (!isReady()) return;
-    lcd.setCursor(col, row);
-    lcd.write(charIndex);
+    if (!canDraw()) return;
+    screen.setCursor(col, row);
+    screen.write(charIndex);
+    present();
   }
 
 private:
+  // Se puede dibujar una pantalla (LCD listo y sin mensaje encima)
+  bool canDraw() {
+    return isReady() && !overlayActive;
+  }
+
+  // Cerrar el frame dibujado; flush() lo envía en las próximas pasadas
+  void present() {
+    screen.commit();
+  }
+
+  // Mantener lo que hay en pantalla durante duration ms
+  void startOverlay(uint32_t duration) {
+    overlayActive = true;
+    overlayStart = millis();
+    overlayDuration = duration;
+  }
+
   // Función auxiliar para imprimir números con dos dígitos
   void printTwoDigits(int number) {
     if (number < 10) {
-      lcd.print("0");
+      screen.print("0");
+    }
+    screen.print(number);
+  }
+
+  // Tiempo en 4 columnas: hasta 9999 us, después en ms ("125m")
+  void printMicros(uint32_t us) {
+    uint32_t value = us < 10000 ? us : min(us / 1000, 999UL);
+    uint8_t width = us < 10000 ? 4 : 3;
+    uint32_t limit = 10;
+    for (uint8_t digits = 1; digits < width; digits++) {
+      if (value < limit) screen.print(" ");
+      limit *= 10;
     }
-    lcd.print(number);
+    screen.print(value);
+    if (us >= 10000) screen.print("m");
   }
 
   // Centrar texto en una línea
-  String centerText(String text, int width) {
+  String centerText(String text, unsigned int width) {
     if (text.length() >= width) {
       return text.substring(0, width);
     }
@@ -0,0 +1,224 @@
+/*
+  lcd_framebuffer.h - Copia en RAM de la pantalla del LCD 20x4
+
+  Las pantallas se dibujan en un buffer de LCD_ROWS x LCD_COLUMNS en vez
+  de ir directo al LCD; borrar el buffer no cuesta nada. flush() compara
+  el buffer con lo que el LCD ya muestra y envía solo los tramos de
+  celdas que cambiaron: un setCursor por tramo y un byte por carácter.
+  Dos tramos separados por una sola celda igual se envían juntos.
+
+  El envío es un trabajo reanudable: commit() cierra un frame y cada
+  llamada a flush() envía como máximo el presupuesto de bytes que se le
+  pasa y guarda dónde quedó, así un redibujado completo se reparte en
+  varias pasadas del loop. Si llega otro frame a mitad de envío, el
+  barrido sigue hasta el final y vuelve a empezar para no dejar celdas
+  viejas; los frames que se juntan así cuentan como uno. Cada pasada
+  entrega sus tramos al driver en una sola tanda y la siguiente espera
+  a que el bus la haya enviado, sin bloquear el loop. Si el bus pierde
+  una tanda, el LCD se vuelve a sincronizar y se redibuja completo.
+
+  Lleva la cuenta de bytes enviados al HD44780 (comandos + caracteres)
+  por frame y en total, y de cuántas pasadas tardó el último frame.
+*/
+
+#ifndef LCD_FRAMEBUFFER_H
+#define LCD_FRAMEBUFFER_H
+
+#include "config.h"
+#include "lcd_pcf8574.h"
+
+class LCDFrameBuffer : public Print {
+private:
+  uint8_t frame[LCD_ROWS][LCD_COLUMNS];   // Pantalla a mostrar
+  uint8_t shown[LCD_ROWS][LCD_COLUMNS];   // Lo que muestra el LCD ahora
+  uint8_t cursorCol;
+  uint8_t cursorRow;
+
+  // Estado del envío en curso
+  bool flushing;          // Hay un frame sin terminar de enviar
+  bool rescan;            // Llegó otro frame durante el barrido actual
+  uint8_t scanRow;        // Próxima celda a comparar
+  uint8_t scanCol;
+  uint8_t framesPending;  // Frames cerrados con commit() aún no enviados
+  unsigned int framePasses;
+  unsigned int frameBytes;
+
+  // Estadísticas de envío
+  unsigned int lastFrameBytes;
+  unsigned int lastFramePasses;
+  uint32_t totalBytes;
+  uint32_t frameCount;
+
+  // Verificar si una celda difiere de lo que muestra el LCD
+  bool changed(uint8_t row, uint8_t col) {
+    return frame[row][col] != shown[row][col];
+  }
+
+public:
+  // Constructor
+  LCDFrameBuffer() : cursorCol(0), cursorRow(0), flushing(false), rescan(false), scanRow(0), scanCol(0),
+    framesPending(0), framePasses(0), frameBytes(0), lastFrameBytes(0), lastFramePasses(0), totalBytes(0), frameCount(0) {
+    clear();
+    markCleared();
+  }
+
+  // Borrar el buffer (el LCD no cambia hasta flush())
+  void clear() {
+    memset(frame, ' ', sizeof(frame));
+    cursorCol = 0;
+    cursorRow = 0;
+  }
+
+  // Indicar que el LCD se borró por hardware (lcd.clear())
+  void markCleared() {
+    memset(shown, ' ', sizeof(shown));
+  }
+
+  // Mover el cursor de escritura del buffer
+  void setCursor(uint8_t col, uint8_t row) {
+    cursorCol = col;
+    cursorRow = row;
+  }
+
+  // Escribir un carácter en el buffer; lo que pasa del borde se descarta
+  using Print::write;
+  size_t write(uint8_t value) {
+    if (cursorRow >= LCD_ROWS || cursorCol >= LCD_COLUMNS) {
+      return 0;
+    }
+    frame[cursorRow][cursorCol++] = value;
+    return 1;
+  }
+
+  // Cerrar el frame dibujado en el buffer para que flush() lo envíe
+  void commit() {
+    if (framesPending < 255) {
+      framesPending++;
+    }
+    if (flushing) {
+      // Las celdas ya barridas pueden haber cambiado otra vez
+      rescan = true;
+      return;
+    }
+    flushing = true;
+    scanRow = 0;
+    scanCol = 0;
+    framePasses = 0;
+    frameBytes = 0;
+  }
+
+  // Enviar al LCD hasta budget bytes de celdas cambiadas, retomando
+  // donde quedó la llamada anterior; retorna true si ya se entregó todo
+  // al bus. Siempre avanza al menos un carácter por llamada salvo que el
+  // bus siga ocupado con la pasada anterior.
+  bool flush(LCDPCF8574& lcd, unsigned int budget) {
+    // Una tanda perdida en el bus deja el LCD distinto de shown:
+    // sincronizarlo, borrarlo y volver a enviar la pantalla entera
+    if (lcd.isIdle() && lcd.checkLostBatches()) {
+      lcd.resync();
+      markCleared();
+      commit();
+    }
+    
+    if (!flushing) return true;
+    
+    framePasses++;
+    if (!lcd.isIdle()) return false;
+    
+    unsigned int bytes = 0;
+    lcd.beginBatch();
+    for (;;) {
+      if (scanRow >= LCD_ROWS) {
+        if (!rescan) break;
+        rescan = false;
+        scanRow = 0;
+        scanCol = 0;
+      }
+      if (scanCol >= LCD_COLUMNS) {
+        scanRow++;
+        scanCol = 0;
+        continue;
+      }
+      if (!changed(scanRow, scanCol)) {
+        scanCol++;
+        continue;
+      }
+      
+      // Extender el tramo; un hueco de una celda igual se reescribe
+      // porque cuesta lo mismo que otro setCursor
+      unsigned int start = scanCol;
+      unsigned int end = scanCol + 1;
+      while (end < LCD_COLUMNS) {
+        if (changed(scanRow, end)) {
+          end++;
+        } else if (end + 1 < LCD_COLUMNS && changed(scanRow, end + 1)) {
+          end += 2;
+        } else {
+          break;
+        }
+      }
+      
+      // Recortar el tramo al presupuesto que queda (setCursor + caracteres)
+      unsigned int room = bytes + 2 <= budget ? budget - bytes - 1 : 0;
+      if (room == 0) {
+        if (bytes > 0) {
+          lcd.endBatch();
+          frameBytes += bytes;
+          totalBytes += bytes;
+          return false;
+        }
+        room = 1;
+      }
+      if (end - start > room) {
+        end = start + room;
+      }
+      
+      // Todos los tramos de la pasada van en la misma tanda del driver
+      lcd.setCursor(start, scanRow);
+      lcd.write(&frame[scanRow][start], end - start);
+      memcpy(&shown[scanRow][start], &frame[scanRow][start], end - start);
+      bytes += 1 + end - start;
+      scanCol = end;
+    }
+    lcd.endBatch();
+    
+    // Frame terminado
+    frameBytes += bytes;
+    totalBytes += bytes;
+    flushing = false;
+    framesPending = 0;
+    if (frameBytes > 0) {
+      lastFrameBytes = frameBytes;
+      lastFramePasses = framePasses;
+      frameCount++;
+    }
+    return true;
+  }
+
+  // Frames cerrados con commit() que aún no terminaron de enviarse
+  uint8_t getFramesPending() {
+    return framesPending;
+  }
+
+  // Pasadas de flush() que tardó el último frame con cambios
+  unsigned int getLastFramePasses() {
+    return lastFramePasses;
+  }
+
+  // Bytes enviados en el último frame con cambios
+  unsigned int getLastFrameBytes() {
+    return lastFrameBytes;
+  }
+
+  // Bytes enviados desde el arranque
+  uint32_t getTotalBytes() {
+    return totalBytes;
+  }
+
+  // Frames con cambios enviados desde el arranque
+  uint32_t getFrameCount() {
+    return frameCount;
+  }
+};
+
+#endif // LCD_FRAMEBUFFER_H
@@ -0,0 +1,321 @@
+/*
+  lcd_pcf8574.h - Driver del LCD HD44780 detrás del adaptador I2C PCF8574
+  
+  Sustituye a LiquidCrystal_I2C con la misma API (init, backlight, clear,
+  setCursor, createChar, print...), pero agrupa el tráfico: la librería
+  abre una transmisión Wire por cada nibble y por cada flanco de Enable
+  (6 transacciones por carácter); aquí los nibbles se escriben en tandas
+  de hasta 32 bytes que se entregan a twi_engine.h como trabajos de baja
+  prioridad, así que escribir en el LCD no espera al bus.
+
+  Hay LCD_I2C_SLOTS tandas; cada operación envía la suya al terminar, y
+  entre beginBatch() y endBatch() varias operaciones comparten tandas.
+  Solo si se escribe más de lo que cabe en todas las tandas, put() espera
+  a que se libere la más vieja. Si una tanda se pierde (por ejemplo, el
+  motor aborta un bus colgado), checkLostBatches() lo informa y resync()
+  vuelve a poner el HD44780 en modo 4 bits sin detener el loop.
+
+  Cada nibble son dos escrituras al PCF8574 (EN alto con el dato, EN bajo)
+  y RS se prepara con una escritura aparte solo cuando cambia entre
+  comando y dato. A 100 kHz cada byte I2C dura ~90 us, más que los 37 us
+  que tarda el HD44780 en ejecutar un carácter, así que no hacen falta
+  esperas entre nibbles; solo clear() y home() esperan 2 ms (el loop usa
+  el framebuffer, que no los llama).
+
+  El arranque espera más de un segundo a que el HD44780 se encienda, y
+  después entre los nibbles de la secuencia de 8 a 4 bits y tras borrar.
+  init() y begin() esperan ahí como LiquidCrystal_I2C; start() y
+  resync() solo empiezan la secuencia, que sigue como corrutina
+  (coroutine.h) en cada llamada a update(). Hasta que termina, isIdle()
+  retorna false y no se debe escribir en el LCD.
+*/
+
+#ifndef LCD_PCF8574_H
+#define LCD_PCF8574_H
+
+#include <Arduino.h>
+#include "twi_engine.h"
+#include "coroutine.h"
+
+const uint8_t LCD_I2C_BATCH = 32;   // Bytes por transacción (como el búfer de Wire)
+const uint8_t LCD_I2C_SLOTS = 4;    // Tandas que pueden estar en el bus a la vez
+
+// Espera tras cada nibble de la secuencia 0x3, 0x3, 0x3, 0x2 (us)
+const uint16_t LCD_INIT_WAITS[] = {4500, 4500, 150, 100};
+const uint8_t LCD_INIT_STEPS = sizeof(LCD_INIT_WAITS) / sizeof(LCD_INIT_WAITS[0]);
+
+class LCDPCF8574 : public Print {
+private:
+  // Bits del puerto del PCF8574 (D4-D7 en los 4 bits altos)
+  static const uint8_t PIN_RS = 0x01;
+  static const uint8_t PIN_EN = 0x04;
+  static const uint8_t PIN_BACKLIGHT = 0x08;
+
+  // Comandos HD44780
+  static const uint8_t CMD_CLEAR = 0x01;
+  static const uint8_t CMD_HOME = 0x02;
+  static const uint8_t CMD_ENTRY_LEFT = 0x06;
+  static const uint8_t CMD_DISPLAY_ON = 0x0C;
+  static const uint8_t CMD_FUNCTION_4BIT_2LINE = 0x28;
+  static const uint8_t CMD_SET_CGRAM = 0x40;
+  static const uint8_t CMD_SET_DDRAM = 0x80;
+
+  uint8_t address;
+  uint8_t columns;
+  uint8_t rows;
+  uint8_t backlightBit;
+  uint8_t port;          // Último valor escrito en el PCF8574 (sin backlight)
+
+  // Tandas de bytes para el PCF8574
+  TWIJob jobs[LCD_I2C_SLOTS];
+  uint8_t slots[LCD_I2C_SLOTS][LCD_I2C_BATCH];
+  uint8_t fillSlot;      // Tanda que se está llenando
+  uint8_t fillLength;    // Bytes en esa tanda
+  bool batching;         // Entre beginBatch() y endBatch()
+  Coroutine startup;     // Secuencia de arranque (start() y resync())
+  bool powerOnWait;      // Esperar el encendido del HD44780 (solo start())
+  uint8_t initStep;      // Nibble de la secuencia de 8 a 4 bits
+
+  // Añadir un byte a la tanda que se está llenando
+  void put(uint8_t value) {
+    if (fillLength == 0) {
+      // La tanda vuelve a usarse: si sigue en el bus, esperarla
+      twiBus.waitFor(&jobs[fillSlot]);
+    }
+    slots[fillSlot][fillLength++] = value | backlightBit;
+  }
+
+  // Entregar la tanda llena (o a medio llenar) al bus
+  void sendSlot() {
+    if (fillLength == 0) return;
+    jobs[fillSlot].txLength = fillLength;
+    twiBus.submit(&jobs[fillSlot]);
+    fillSlot = (fillSlot + 1) % LCD_I2C_SLOTS;
+    fillLength = 0;
+  }
+
+  // Fin de una operación: fuera de beginBatch() se envía enseguida
+  void endOperation() {
+    if (!batching) {
+      sendSlot();
+    }
+  }
+
+  // Verificar si todas las tandas ya llegaron al LCD
+  bool slotsSent() {
+    for (uint8_t i = 0; i < LCD_I2C_SLOTS; i++) {
+      if (twiBus.isPending(&jobs[i])) return false;
+    }
+    return fillLength == 0;
+  }
+
+  // Esperar a que el LCD reciba todo (clear() y home())
+  void sync() {
+    sendSlot();
+    for (uint8_t i = 0; i < LCD_I2C_SLOTS; i++) {
+      twiBus.waitFor(&jobs[i]);
+    }
+  }
+
+  // Añadir un nibble (4 bits altos de value) con RS = mode
+  void putNibble(uint8_t value, uint8_t mode) {
+    // RS y el pulso necesitan hasta 3 bytes en la misma transmisión
+    if (fillLength + 3 > LCD_I2C_BATCH) {
+      sendSlot();
+    }
+    
+    // RS debe estar estable antes del flanco de subida de EN
+    if ((port & PIN_RS) != mode) {
+      port = (port & 0xF0) | mode;
+      put(port);
+    }
+    
+    // El HD44780 captura D4-D7 en el flanco de bajada de EN
+    port = (value & 0xF0) | mode;
+    put(port | PIN_EN);
+    put(port);
+  }
+
+  // Añadir un byte completo (nibble alto y luego bajo)
+  void putByte(uint8_t value, uint8_t mode) {
+    putNibble(value, mode);
+    putNibble(value << 4, mode);
+  }
+
+public:
+  // Constructor (mismos parámetros que LiquidCrystal_I2C)
+  LCDPCF8574(uint8_t lcdAddress, uint8_t lcdColumns, uint8_t lcdRows)
+    : address(lcdAddress), columns(lcdColumns), rows(lcdRows), backlightBit(0), port(0),
+      fillSlot(0), fillLength(0), batching(false), powerOnWait(false), initStep(0) {
+    for (uint8_t i = 0; i < LCD_I2C_SLOTS; i++) {
+      jobs[i].address = lcdAddress;
+      jobs[i].priority = TWI_PRIORITY_LOW;
+      jobs[i].txData = slots[i];
+      jobs[i].txLength = 0;
+      jobs[i].rxData = 0;
+      jobs[i].rxLength = 0;
+      jobs[i].onComplete = 0;
+      jobs[i].status = TWI_JOB_IDLE;
+      jobs[i].next = 0;
+    }
+  }
+
+  // Inicializar el bus y el LCD (espera el arranque)
+  void init() {
+    twiBus.begin();
+    begin();
+  }
+
+  // Secuencia de arranque del HD44780 en modo 4 bits, esperando a que termine
+  void begin() {
+    start();
+    while (!update()) {
+      delay(1);
+    }
+  }
+
+  // Empezar la secuencia de arranque sin esperar; update() la avanza
+  void start() {
+    powerOnWait = true;
+    startup.start();
+    update();
+  }
+
+  // Pasar el HD44780 a 4 bits desde cualquier estado y borrarlo; después
+  // de perder una tanda en el bus vuelve a alinear los nibbles. Sigue en
+  // update() como el arranque, pero sin esperar el encendido
+  void resync() {
+    powerOnWait = false;
+    startup.start();
+    update();
+  }
+
+  // Avanzar el arranque; retorna true cuando el LCD está listo
+  bool update() {
+    CO_BEGIN(startup);
+    if (powerOnWait) {
+      CO_DELAY(startup, 50);
+      port = 0;
+      put(port);
+      sendSlot();
+      CO_WAIT_UNTIL(startup, slotsSent());
+      CO_DELAY(startup, 1000);
+    }
+    
+    // 0x3 tres veces y 0x2: llega a 4 bits desde 8 bits o a medio byte.
+    // Cada nibble tiene que llegar al LCD antes de contar su espera
+    for (initStep = 0; initStep < LCD_INIT_STEPS; initStep++) {
+      putNibble(initStep + 1 < LCD_INIT_STEPS ? 0x30 : 0x20, 0);
+      sendSlot();
+      CO_WAIT_UNTIL(startup, slotsSent());
+      CO_DELAY_US(startup, LCD_INIT_WAITS[initStep]);
+    }
+    
+    // Borrar también lleva el cursor al inicio (el HD44780 tarda 1.52 ms)
+    command(CMD_FUNCTION_4BIT_2LINE);
+    command(CMD_DISPLAY_ON);
+    command(CMD_CLEAR);
+    CO_WAIT_UNTIL(startup, slotsSent());
+    CO_DELAY_US(startup, 2000);
+    command(CMD_ENTRY_LEFT);
+    CO_END(startup);
+  }
+
+  // Borrar pantalla (el HD44780 tarda 1.52 ms)
+  void clear() {
+    command(CMD_CLEAR);
+    sync();
+    delayMicroseconds(2000);
+  }
+
+  // Cursor al inicio (el HD44780 tarda 1.52 ms)
+  void home() {
+    command(CMD_HOME);
+    sync();
+    delayMicroseconds(2000);
+  }
+
+  // Posicionar cursor
+  void setCursor(uint8_t col, uint8_t row) {
+    static const uint8_t rowOffsets[] = {0x00, 0x40, 0x14, 0x54};
+    if (row >= rows) row = rows - 1;
+    command(CMD_SET_DDRAM | (col + rowOffsets[row]));
+  }
+
+  // Encender luz de fondo
+  void backlight() {
+    backlightBit = PIN_BACKLIGHT;
+    put(port);
+    endOperation();
+  }
+
+  // Apagar luz de fondo
+  void noBacklight() {
+    backlightBit = 0;
+    put(port);
+    endOperation();
+  }
+
+  // Definir un carácter personalizado (0-7) en una sola tanda
+  void createChar(uint8_t location, uint8_t charmap[]) {
+    putByte(CMD_SET_CGRAM | ((location & 0x7) << 3), 0);
+    for (uint8_t i = 0; i < 8; i++) {
+      putByte(charmap[i], PIN_RS);
+    }
+    endOperation();
+  }
+
+  // Enviar un comando al HD44780
+  void command(uint8_t value) {
+    putByte(value, 0);
+    endOperation();
+  }
+
+  // Escribir un carácter
+  using Print::write;
+  size_t write(uint8_t value) {
+    putByte(value, PIN_RS);
+    endOperation();
+    return 1;
+  }
+
+  // Escribir una cadena agrupando sus nibbles en tandas de 32 bytes
+  size_t write(const uint8_t* buffer, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+      putByte(buffer[i], PIN_RS);
+    }
+    endOperation();
+    return size;
+  }
+
+  // Agrupar las operaciones siguientes en las mismas tandas
+  void beginBatch() {
+    batching = true;
+  }
+
+  // Enviar lo agrupado desde beginBatch()
+  void endBatch() {
+    batching = false;
+    sendSlot();
+  }
+
+  // Verificar si alguna tanda terminó con error (NACK, bus o timeout)
+  // desde la llamada anterior; el LCD puede haber quedado a medio byte
+  bool checkLostBatches() {
+    bool lost = false;
+    for (uint8_t i = 0; i < LCD_I2C_SLOTS; i++) {
+      if (!twiBus.isPending(&jobs[i]) && jobs[i].status >= TWI_JOB_NACK) {
+        jobs[i].status = TWI_JOB_IDLE;
+        lost = true;
+      }
+    }
+    return lost;
+  }
+
+  // Verificar si el LCD terminó de arrancar y recibió todas las tandas
+  bool isIdle() {
+    return !startup.isRunning() && slotsSent();
+  }
+};
+
+#endif // LCD_PCF8574_H
@@ -0,0 +1,190 @@
+/*
+  loop_profiler.h - Tiempo de cada etapa del loop
+  
+  Mide con micros() cuánto tarda cada etapa de una pasada del loop
+  (horarios, relays, botones, timeout del menú, menú y LCD) y guarda por
+  etapa el mínimo, el máximo, la media y un histograma en tramos que
+  doblan su ancho: < 16 us, < 32 us, ... < 4096 us y el resto. Así se ve
+  tanto el costo típico como las pasadas raras que tardan mucho.
+
+  micros() avanza de a 4 us en el Uno a 16 MHz y leerlo cuesta unos
+  pocos us: los tiempos por debajo de 8 us caen todos en el primer
+  tramo. El Timer1 daría ciclos exactos, pero lo usa el corte de las
+  alimentaciones. Los datos se ven con el comando serial "prof" y en la
+  segunda página de "Ver Estado" en el LCD; "prof reset" y CONFIRM en
+  esa página vuelven a empezar y suman un reinicio.
+*/
+
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include "config.h"
+
+// Etapas medidas del loop
+enum ProfileStageId {
+  PROFILE_SCHEDULE,   // checkScheduledFeeding()
+  PROFILE_RELAY,      // relayController.update()
+  PROFILE_BUTTONS,    // buttonManager.update()
+  PROFILE_TIMEOUT,    // checkMenuTimeout()
+  PROFILE_MENU,       // processMenu()
+  PROFILE_LCD,        // updateLCD()
+  PROFILE_STAGES
+};
+
+// Estadísticas de una etapa (26 bytes: son seis en la RAM del Uno)
+struct ProfileStage {
+  uint32_t count;                     // Veces medida
+  uint16_t minUs;                     // Se saturan en 65535 us
+  uint16_t maxUs;
+  uint32_t sumUs;                     // Suma para la media (ver add())
+  uint32_t sumCount;                  // Mediciones en sumUs
+  uint8_t buckets[PROFILE_BUCKETS];   // Histograma relativo (ver add())
+};
+
+class LoopProfiler {
+private:
+  ProfileStage stages[PROFILE_STAGES];
+  uint32_t stageStart;                // micros() al empezar la etapa en curso
+  uint16_t resets;
+
+  // Tramo del histograma: 0 = menos de 2^PROFILE_FIRST_BUCKET_SHIFT us,
+  // y cada uno siguiente llega al doble
+  static uint8_t bucketOf(uint32_t us) {
+    us >>= PROFILE_FIRST_BUCKET_SHIFT;
+    uint8_t bucket = 0;
+    while (us && bucket < PROFILE_BUCKETS - 1) {
+      us >>= 1;
+      bucket++;
+    }
+    return bucket;
+  }
+
+  void add(ProfileStage& stage, uint32_t us) {
+    uint8_t bucket = bucketOf(us);
+    uint16_t savedUs = us > 0xFFFF ? 0xFFFF : us;
+    
+    if (stage.count == 0 || savedUs < stage.minUs) stage.minUs = savedUs;
+    if (savedUs > stage.maxUs) stage.maxUs = savedUs;
+    stage.count++;
+    
+    // Antes de desbordar la suma (más de una hora medida en la etapa) se
+    // parte a la mitad con su cuenta: la media sigue siendo correcta y
+    // pesa un poco más lo reciente
+    if (stage.sumUs > 0xFFFFFFFFUL - us) {
+      stage.sumUs >>= 1;
+      stage.sumCount >>= 1;
+    }
+    stage.sumUs += us;
+    stage.sumCount++;
+    
+    // Al llenarse un tramo se parten todos a la mitad: el histograma
+    // guarda la forma (qué parte de las pasadas cae en cada tramo)
+    if (stage.buckets[bucket] == 0xFF) {
+      for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+        stage.buckets[b] >>= 1;
+      }
+    }
+    stage.buckets[bucket]++;
+  }
+
+  // Número alineado a la derecha en 'width' columnas (Serial)
+  static void printPadded(uint32_t value, uint8_t width) {
+    uint32_t limit = 10;
+    for (uint8_t digits = 1; digits < width; digits++) {
+      if (value < limit) Serial.print(' ');
+      limit *= 10;
+    }
+    Serial.print(value);
+  }
+
+public:
+  // Constructor
+  LoopProfiler() : stageStart(0), resets(0) {
+    clear();
+  }
+
+  // Empezar a medir una etapa
+  void start() {
+    if (!USE_LOOP_PROFILER) return;
+    stageStart = micros();
+  }
+
+  // Terminar la etapa empezada con start()
+  void stop(ProfileStageId stage) {
+    if (!USE_LOOP_PROFILER) return;
+    add(stages[stage], micros() - stageStart);
+  }
+
+  // Borrar las estadísticas y contar un reinicio
+  void reset() {
+    clear();
+    resets++;
+  }
+
+  void clear() {
+    memset(stages, 0, sizeof(stages));
+  }
+
+  uint16_t getResetCount() {
+    return resets;
+  }
+
+  const ProfileStage& getStage(uint8_t stage) {
+    return stages[stage];
+  }
+
+  uint32_t getMeanUs(uint8_t stage) {
+    const ProfileStage& s = stages[stage];
+    return s.sumCount ? s.sumUs / s.sumCount : 0;
+  }
+
+  // Nombre de la etapa (Serial) y su letra (LCD)
+  static const char* getStageName(uint8_t stage) {
+    static const char* const names[PROFILE_STAGES] = {"Horarios", "Relays", "Botones", "Timeout", "Menu", "LCD"};
+    return stage < PROFILE_STAGES ? names[stage] : "?";
+  }
+
+  static char getStageCode(uint8_t stage) {
+    return stage < PROFILE_STAGES ? "HRBTML"[stage] : '?';
+  }
+
+  // Mostrar tiempos e histogramas por Serial
+  void displayProfile() {
+    Serial.println(F("\n=== Perfil del Loop (us) ==="));
+    Serial.print(F("Reinicios: "));
+    Serial.println(resets);
+    Serial.println(F("Etapa       Veces   Min   Med   Max"));
+    for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+      const ProfileStage& stage = stages[i];
+      Serial.print(getStageName(i));
+      for (uint8_t pad = strlen(getStageName(i)); pad < 9; pad++) {
+        Serial.print(' ');
+      }
+      printPadded(stage.count, 8);
+      printPadded(stage.minUs, 6);
+      printPadded(getMeanUs(i), 6);
+      printPadded(stage.maxUs, 6);
+      Serial.println();
+    }
+    
+    // Histograma: una columna por tramo, con su límite superior
+    Serial.print(F("Tramo <us "));
+    for (uint8_t b = 0; b < PROFILE_BUCKETS - 1; b++) {
+      printPadded(1UL << (PROFILE_FIRST_BUCKET_SHIFT + b), 6);
+    }
+    Serial.println(F("   mas"));
+    for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+      Serial.print(getStageName(i));
+      for (uint8_t pad = strlen(getStageName(i)); pad < 10; pad++) {
+        Serial.print(' ');
+      }
+      for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+        printPadded(stages[i].buckets[b], 6);
+      }
+      Serial.println();
+    }
+    Serial.println(F("============================"));
+  }
+};
+
+#endif // LOOP_PROFILER_H
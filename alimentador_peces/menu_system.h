@@ -49,7 +49,7 @@ private:
   MenuState currentState;
   MenuState previousState;
   int selectedOption;
-  int editingSchedule;    // Horario que se está editando (1-4)
+  int editingSchedule;    // Horario seleccionado o en edición (1-MAX_FEED_TIMES)
   EditState editState;
   
   // Variables de edición temporal
@@ -66,7 +66,7 @@ private:
   int tempAdjustYear;
   
   // Control de timeout
-  unsigned long lastActivity;
+  uint32_t lastActivity;
   bool inMenu;
   
   // Referencias a módulos
@@ -134,9 +134,38 @@ public:
     
     // Actualizar display
     displayManager->update();
+    
+    // Redibujar la pantalla del menú cuando vence un mensaje temporal
+    if (displayManager->takeLCDRedraw()) {
+      redrawLCD();
+    }
   }
 
 private:
+  // Volver a dibujar en el LCD la pantalla del estado actual
+  // (el reloj lo redibuja DisplayManager y la alimentación, handleFeeding)
+  void redrawLCD() {
+    switch (currentState) {
+      case MENU_MAIN:
+        displayManager->showMainMenuLCD(selectedOption);
+        break;
+      case MENU_VIEW_SCHEDULES:
+        displayManager->showSchedulesLCD(editingSchedule);
+        break;
+      case MENU_EDIT_SCHEDULE:
+        updateScheduleEditor();
+        break;
+      case MENU_STATUS:
+        displayManager->showStatusLCD();
+        break;
+      case MENU_TIME_ADJUST:
+        updateTimeAdjustDisplay();
+        break;
+      default:
+        break;
+    }
+  }
+
   // Actualizar tiempo de última actividad
   void updateActivity() {
     lastActivity = millis();
@@ -178,7 +207,7 @@ private:
     if (buttonManager->confirmPressed()) {
       // Alimentar manualmente desde el reloj
       if (!relayController->isFeedingActive()) {
-        relayController->startFeeding(0);
+        relayController->startFeeding();
         buttonManager->confirmBeep();
         displayManager->showMessage("Alimentando manualmente");
       }
@@ -190,13 +219,13 @@ private:
     updateActivity();
     
     if (buttonManager->upPressed()) {
-      selectedOption = (selectedOption > 1) ? selectedOption - 1 : 9;
+      selectedOption = (selectedOption > 1) ? selectedOption - 1 : MAIN_MENU_OPTIONS;
       buttonManager->beep();
       showMainMenuOption();
     }
     
     if (buttonManager->downPressed()) {
-      selectedOption = (selectedOption < 9) ? selectedOption + 1 : 1;
+      selectedOption = (selectedOption < MAIN_MENU_OPTIONS) ? selectedOption + 1 : 1;
       buttonManager->beep();
       showMainMenuOption();
     }
@@ -216,9 +245,8 @@ private:
     displayManager->showMainMenuLCD(selectedOption);
     
     // También en Serial para compatibilidad
-    String options[] = {"", "Ver Horarios", "Editar Horario 1", "Editar Horario 2", 
-                       "Editar Horario 3", "Editar Horario 4", "Alimentar Ahora", 
-                       "Ver Estado", "Ajustar Hora", "Salir"};
+    String options[] = {"", "Horarios", "Alimentar Ahora", "Ver Estado",
+                       "Ajustar Hora", "Salir"};
     
     Serial.print("► ");
     Serial.println(options[selectedOption]);
@@ -229,55 +257,62 @@ private:
     buttonManager->confirmBeep();
     
     switch (selectedOption) {
-      case 1: // Ver Horarios
+      case 1: // Horarios (lista con cursor, CONFIRM edita)
         currentState = MENU_VIEW_SCHEDULES;
         displayManager->setMode(DISPLAY_SCHEDULE_VIEW);
         displayManager->showSchedules();
-        displayManager->showSchedulesLCD();
+        displayManager->showSchedulesLCD(editingSchedule);
         break;
         
-      case 2: // Editar Horario 1
-      case 3: // Editar Horario 2
-      case 4: // Editar Horario 3
-      case 5: // Editar Horario 4
-        editingSchedule = selectedOption - 1;
-        startScheduleEdit();
-        break;
-        
-      case 6: // Alimentar Ahora
+      case 2: // Alimentar Ahora
         if (!relayController->isFeedingActive()) {
-          relayController->startFeeding(0);
-          displayManager->showMessage("Alimentando manualmente");
+          relayController->startFeeding();
           displayManager->showConfirmation("Alimentando");
           currentState = MENU_FEEDING;
         } else {
-          displayManager->showError("Ya se está alimentando");
-          displayManager->showErrorLCD("Ya alimentando");
+          displayManager->showError("Ya alimentando");
         }
         break;
         
-      case 7: // Ver Estado
+      case 3: // Ver Estado
         currentState = MENU_STATUS;
         displayManager->setMode(DISPLAY_STATUS);
         displayManager->showStatus();
         displayManager->showStatusLCD();
         break;
         
-      case 8: // Ajustar Hora
+      case 4: // Ajustar Hora
         startTimeAdjust();
         break;
         
-      case 9: // Salir
+      case 5: // Salir
         returnToClock();
         break;
     }
   }
 
-  // Manejar vista de horarios
+  // Manejar vista de horarios (UP/DOWN mueven el cursor, CONFIRM edita)
   void handleViewSchedules() {
     updateActivity();
     
-    if (buttonManager->selectPressed() || buttonManager->confirmPressed()) {
+    if (buttonManager->upPressed() || buttonManager->upRepeating()) {
+      editingSchedule = (editingSchedule > 1) ? editingSchedule - 1 : MAX_FEED_TIMES;
+      buttonManager->beep();
+      displayManager->showSchedulesLCD(editingSchedule);
+    }
+    
+    if (buttonManager->downPressed() || buttonManager->downRepeating()) {
+      editingSchedule = (editingSchedule < MAX_FEED_TIMES) ? editingSchedule + 1 : 1;
+      buttonManager->beep();
+      displayManager->showSchedulesLCD(editingSchedule);
+    }
+    
+    if (buttonManager->confirmPressed()) {
+      buttonManager->confirmBeep();
+      startScheduleEdit();
+    }
+    
+    if (buttonManager->selectPressed()) {
       currentState = MENU_MAIN;
       displayManager->setMode(DISPLAY_MENU);
       displayManager->showMainMenu();
@@ -291,11 +326,17 @@ private:
     displayManager->setMode(DISPLAY_SCHEDULE_EDIT);
     editState = EDIT_HOUR;
     
-    // Cargar valores actuales
-    FeedTime current = scheduleManager->getSchedule(editingSchedule);
-    tempHour = current.hour;
-    tempMinute = current.minute;
-    tempEnabled = current.enabled;
+    // Cargar valores actuales (un horario libre empieza en la hora predeterminada)
+    if (scheduleManager->isScheduleConfigured(editingSchedule)) {
+      FeedTime current = scheduleManager->getSchedule(editingSchedule);
+      tempHour = current.hour;
+      tempMinute = current.minute;
+      tempEnabled = current.enabled;
+    } else {
+      tempHour = DEFAULT_SCHEDULE_1_HOUR;
+      tempMinute = DEFAULT_SCHEDULE_1_MINUTE;
+      tempEnabled = true;
+    }
     
     updateScheduleEditor();
   }
@@ -353,6 +394,9 @@ private:
       case EDIT_ENABLED:
         tempEnabled = !tempEnabled;
         break;
+      case EDIT_SAVE:
+        // Guardar no tiene valor que cambiar
+        break;
     }
   }
 
@@ -368,6 +412,9 @@ private:
       case EDIT_ENABLED:
         tempEnabled = !tempEnabled;
         break;
+      case EDIT_SAVE:
+        // Guardar no tiene valor que cambiar
+        break;
     }
   }
 
@@ -412,6 +459,7 @@ private:
   void saveSchedule() {
     if (scheduleManager->setSchedule(editingSchedule, tempHour, tempMinute)) {
       scheduleManager->enableSchedule(editingSchedule, tempEnabled);
+      scheduleManager->save();
       
       buttonManager->confirmBeep();
       displayManager->showConfirmation("Horario guardado correctamente");
@@ -450,7 +498,6 @@ private:
       // Alimentación terminada, volver al menú
       currentState = MENU_MAIN;
       displayManager->setMode(DISPLAY_MENU);
-      displayManager->showMessage("Alimentación completada");
       displayManager->showConfirmation("Completado");
     }
     
@@ -459,7 +506,6 @@ private:
       relayController->emergencyStop();
       currentState = MENU_MAIN;
       displayManager->setMode(DISPLAY_MENU);
-      displayManager->showMessage("Alimentación detenida");
       displayManager->showConfirmation("Detenido");
       buttonManager->beep();
     }
@@ -555,6 +601,9 @@ private:
       case ADJUST_YEAR:
         tempAdjustYear = (tempAdjustYear < 2099) ? tempAdjustYear + 1 : 2000;
         break;
+      case ADJUST_SAVE:
+        // Guardar no tiene valor que cambiar
+        break;
     }
   }
 
@@ -576,6 +625,9 @@ private:
       case ADJUST_YEAR:
         tempAdjustYear = (tempAdjustYear > 2000) ? tempAdjustYear - 1 : 2099;
         break;
+      case ADJUST_SAVE:
+        // Guardar no tiene valor que cambiar
+        break;
     }
   }
 
@@ -0,0 +1,93 @@
+/*
+  pin_map.h - Pines del Arduino Uno resueltos al compilar
+  
+  Convierte los números de pin de config.h en su puerto (PORTD, PORTB o
+  PORTC) y su máscara de bit con funciones constexpr, para escribir
+  varios pines del mismo puerto con un solo acceso al registro en lugar
+  de un digitalWrite() por pin.
+
+  digitalWrite() busca el puerto y la máscara en tablas de flash, apaga
+  el PWM si el pin tiene temporizador y deshabilita las interrupciones
+  en cada llamada. Con el pin conocido al compilar todo eso desaparece:
+  un bit constante queda en una instrucción sbi/cbi y varios bits en
+  in/or/out. Los pines que se escriben así no deben usarse con
+  analogWrite().
+
+  En el simulador no hay registros de puerto: las mismas funciones
+  escriben los pines de la máscara con digitalWrite(), uno por uno.
+*/
+
+#ifndef PIN_MAP_H
+#define PIN_MAP_H
+
+#include <Arduino.h>
+
+// Puertos del ATmega328P
+const uint8_t PIN_PORT_D = 0;   // Pines 0-7
+const uint8_t PIN_PORT_B = 1;   // Pines 8-13
+const uint8_t PIN_PORT_C = 2;   // Pines 14-19 (A0-A5)
+
+constexpr uint8_t pinPort(int pin) {
+  return pin < 8 ? PIN_PORT_D : (pin < 14 ? PIN_PORT_B : PIN_PORT_C);
+}
+
+constexpr uint8_t pinMask(int pin) {
+  return 1 << (pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14));
+}
+
+// Máscara en 'port' de los pines elegidos por 'select' (bit i = i-ésimo pin)
+constexpr uint8_t pinGroupMask(uint8_t, uint8_t) {
+  return 0;
+}
+
+template <typename... Pins>
+constexpr uint8_t pinGroupMask(uint8_t port, uint8_t select, int pin, Pins... pins) {
+  return ((select & 1) && pinPort(pin) == port ? pinMask(pin) : 0) | pinGroupMask(port, select >> 1, pins...);
+}
+
+#if defined(__AVR__)
+static inline volatile uint8_t& pinPortRegister(uint8_t port) {
+  return port == PIN_PORT_D ? PORTD : (port == PIN_PORT_B ? PORTB : PORTC);
+}
+
+// Poner en high o low los bits de 'mask' en 'port' con un solo acceso.
+// Con varios bits es lectura-modificación-escritura: llamar con las
+// interrupciones deshabilitadas si una interrupción escribe el mismo puerto
+static inline void pinPortWrite(uint8_t port, uint8_t mask, bool high) {
+  if (!mask) return;
+  volatile uint8_t& reg = pinPortRegister(port);
+  if (high) {
+    reg |= mask;
+  } else {
+    reg &= ~mask;
+  }
+}
+#else
+// Simulador: el mismo efecto pin por pin
+static inline void pinPortWrite(uint8_t port, uint8_t mask, bool high) {
+  static const uint8_t firstPin[3] = {0, 8, 14};
+  for (uint8_t i = 0; i < 8; i++) {
+    if (mask & (1 << i)) {
+      digitalWrite(firstPin[port] + i, high ? HIGH : LOW);
+    }
+  }
+}
+#endif
+
+// Pin de salida fijo al compilar
+template <int PIN>
+struct FastPin {
+  static const uint8_t port = pinPort(PIN);
+  static const uint8_t mask = pinMask(PIN);
+
+  static inline void output() {
+    pinMode(PIN, OUTPUT);
+  }
+
+  // Un solo bit constante: sbi/cbi, atómico aunque una interrupción use el puerto
+  static inline void write(bool high) {
+    pinPortWrite(port, mask, high);
+  }
+};
+
+#endif // PIN_MAP_H
@@ -0,0 +1,307 @@
+/*
+  power_manager.h - Sueño profundo entre eventos
+  
+  Entre una alimentación y otra el loop no tiene nada que hacer durante
+  horas. Cuando el sketch está en reposo (reloj en pantalla, fuera de
+  los menús, sin alimentar, sin mensajes temporales, sin botones ni
+  escrituras pendientes) sleep() pone el ATmega328P en power-down en
+  lugar de esperar la próxima tarea: el oscilador se detiene y el MCU
+  solo despierta con una interrupción externa:
+  - PCINT2 (puerto D): los botones y RX del puerto serie (D0)
+  - PCINT1: INT/SQW del DS3231, con la onda de 1 Hz o la alarma 1
+  - El watchdog cada POWER_WATCHDOG_MS si el reloj no avanza con la
+    onda cuadrada, para que la hora del LCD siga al día
+
+  En power-down también se detiene el Timer0, así que millis() no avanza
+  mientras se duerme: lo que mide intervalos con millis() no ve el
+  sueño. Al despertar por el watchdog RTCManager::wakeUp() adelanta el
+  reloj por millis() un período; con otro despertar relee el DS3231.
+  Por lo mismo, el tiempo despierto es el que avanzó millis() y el total
+  sale de la hora del DS3231; getDutyCycle() es la proporción despierto.
+
+  Fuera del reposo, o si solo faltan transacciones I2C o el envío del
+  frame al LCD, idle() detiene la CPU en modo idle hasta la próxima
+  interrupción (la del TWI o el tick de 1 ms del Timer0) mientras no
+  vence ninguna tarea de task_scheduler.h.
+  Tras despertar por un pin el sketch queda despierto POWER_PIN_HOLD ms.
+  El primer carácter que llega por el puerto serie con el MCU dormido
+  solo lo despierta (el oscilador tarda ~1 ms en arrancar) y se pierde:
+  conviene mandar un Enter antes del comando.
+*/
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include "config.h"
+#include "button_manager.h"
+#include "relay_controller.h"
+#include "rtc_manager.h"
+
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#endif
+
+// Motivo del último despertar (lo marcan las interrupciones)
+const uint8_t POWER_WAKE_PIN = 0x01;        // Botón o RX del puerto serie
+const uint8_t POWER_WAKE_WATCHDOG = 0x02;
+
+static volatile uint8_t powerWakeFlags = 0;
+
+static void powerPinWakeISR() {
+  powerWakeFlags |= POWER_WAKE_PIN;
+}
+
+static void powerWatchdogISR() {
+  powerWakeFlags |= POWER_WAKE_WATCHDOG;
+}
+
+// Divisor del watchdog: el 16 ms x 2^n más cercano a ms (n = 0-9; 1000 -> 1024 ms)
+constexpr uint8_t powerWatchdogPrescaler(unsigned int ms, uint8_t n = 0) {
+  return (n < 9 && (24U << n) <= ms) ? powerWatchdogPrescaler(ms, n + 1) : n;
+}
+
+const uint8_t POWER_WATCHDOG_PRESCALER = powerWatchdogPrescaler(POWER_WATCHDOG_MS);
+const uint32_t POWER_WATCHDOG_PERIOD = 16UL << POWER_WATCHDOG_PRESCALER;   // ms
+
+#if defined(__AVR__)
+ISR(PCINT2_vect) {
+  powerPinWakeISR();
+}
+
+ISR(WDT_vect) {
+  powerWatchdogISR();
+}
+#endif
+
+class PowerManager {
+private:
+  RTCManager* rtcManager;
+  uint32_t startEpoch;             // Hora del DS3231 al empezar a medir
+  unsigned int timeChangesSeen;
+  uint32_t awakeSeconds;           // Tiempo despierto (el que avanzó millis())
+  unsigned int awakeMillis;        // Resto en ms (< 1000)
+  uint32_t accountedMillis;        // millis() ya sumado
+  bool pinHold;                    // Despierto por un pin hace menos de POWER_PIN_HOLD
+  uint32_t pinWakeMillis;
+  uint32_t sleeps;
+  uint32_t pinWakes;
+  uint32_t rtcWakes;               // INT/SQW del DS3231 u otra interrupción
+  uint32_t watchdogWakes;
+
+  // Sumar el tiempo despierto desde la última cuenta. Ajustar la hora
+  // del DS3231 mueve el total: la medición vuelve a empezar
+  void account() {
+    if (rtcManager->getTimeChangeCount() != timeChangesSeen) {
+      resetStats();
+      return;
+    }
+    uint32_t now = millis();
+    awakeMillis += now - accountedMillis;
+    accountedMillis = now;
+    awakeSeconds += awakeMillis / 1000;
+    awakeMillis %= 1000;
+  }
+
+  // Sin onda cuadrada nada despierta al MCU cada segundo
+  bool useWatchdog() {
+    return POWER_WATCHDOG_MS > 0 && !rtcManager->isSquareWaveActive();
+  }
+
+  // Una interrupción dejó trabajo después de la comprobación del loop
+  // (llamar con las interrupciones deshabilitadas)
+  bool workPending() {
+    return feedChannelsBusy || buttonEventHead != buttonEventTail || rtcManager->hasUnseenEdges() ||
+           (SERIAL_ENABLED && Serial.available());
+  }
+
+  // Dormir en power-down; se llama con las interrupciones deshabilitadas
+  // y retorna con ellas habilitadas, ya despierto
+  void powerDown(bool watchdog) {
+#if defined(__AVR__)
+    // Botones y RX (D0) despiertan por PCINT2 solo mientras se duerme
+    PCMSK2 = BUTTON_PORT_MASK | (SERIAL_ENABLED ? bit(0) : 0);
+    PCIFR = bit(PCIF2);
+    PCICR |= bit(PCIE2);
+    
+    if (watchdog) {
+      // Watchdog en modo interrupción, sin reinicio
+      MCUSR &= ~bit(WDRF);
+      WDTCSR = bit(WDCE) | bit(WDE);
+      WDTCSR = bit(WDIE) | (POWER_WATCHDOG_PRESCALER & 0x07) | ((POWER_WATCHDOG_PRESCALER & 0x08) ? bit(WDP3) : 0);
+    }
+    
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+#if defined(sleep_bod_disable)
+    sleep_bod_disable();
+#endif
+    // sei ejecuta la instrucción siguiente antes de atender interrupciones:
+    // una que ya esté pendiente despierta al MCU enseguida
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+    
+    PCICR &= ~bit(PCIE2);
+    if (watchdog) {
+      wdt_disable();
+    }
+#else
+    interrupts();
+    if (!powerWakeFlags && !workPending()) {
+      sleepPowerDown(watchdog ? powerWatchdogISR : 0, POWER_WATCHDOG_PERIOD * 1000);
+    }
+#endif
+  }
+
+public:
+  // Constructor
+  PowerManager(RTCManager* rtc)
+    : rtcManager(rtc), startEpoch(0), timeChangesSeen(0), awakeSeconds(0), awakeMillis(0),
+      accountedMillis(0), pinHold(false), pinWakeMillis(0), sleeps(0), pinWakes(0), rtcWakes(0),
+      watchdogWakes(0) {}
+
+  // Empezar a medir (después de RTCManager::begin())
+  void begin() {
+#if !defined(__AVR__)
+    // Simulador: los botones despiertan por sus interrupciones de pin
+    for (uint8_t i = 0; i < 4; i++) {
+      attachInterrupt(digitalPinToInterrupt(buttonPins[i]), powerPinWakeISR, CHANGE);
+    }
+#endif
+    resetStats();
+  }
+
+  // Verificar si se puede dormir (el sketch decide si está en reposo)
+  bool canSleep() {
+    if (!USE_POWER_SAVE) return false;
+    if (pinHold && millis() - pinWakeMillis < POWER_PIN_HOLD) return false;
+    pinHold = false;
+    return true;
+  }
+
+  // Dormir hasta el próximo evento
+  void sleep() {
+    if (SERIAL_ENABLED) {
+      Serial.flush();  // El USART se detiene: terminar de transmitir
+    }
+    bool watchdog = useWatchdog();
+    account();
+    
+    noInterrupts();
+    if (workPending()) {
+      interrupts();
+      return;
+    }
+    powerWakeFlags = 0;
+    sleeps++;
+    powerDown(watchdog);
+    
+    // Solo el watchdog dice cuánto se durmió; un pin o el DS3231 pueden
+    // despertar en cualquier momento
+    uint8_t flags = powerWakeFlags;
+    if (flags & POWER_WAKE_PIN) {
+      pinWakes++;
+      pinHold = true;
+      pinWakeMillis = millis();
+    } else if (flags & POWER_WAKE_WATCHDOG) {
+      watchdogWakes++;
+      rtcManager->wakeUp(POWER_WATCHDOG_PERIOD);
+      return;
+    } else {
+      rtcWakes++;
+    }
+    rtcManager->wakeUp();
+  }
+
+  // Esperar la próxima interrupción con la CPU detenida (timers y TWI
+  // siguen), como mucho maxUs: el tick del Timer0 despierta cada 1 ms
+  void idle(uint32_t maxUs = 1000) {
+#if defined(__AVR__)
+    (void)maxUs;
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+#else
+    sleepIdle(maxUs);
+#endif
+  }
+
+  // Volver a medir desde ahora
+  void resetStats() {
+    startEpoch = rtcManager->getEpoch();
+    timeChangesSeen = rtcManager->getTimeChangeCount();
+    awakeSeconds = 0;
+    awakeMillis = 0;
+    accountedMillis = millis();
+    sleeps = 0;
+    pinWakes = 0;
+    rtcWakes = 0;
+    watchdogWakes = 0;
+  }
+
+  // Segundos medidos con el DS3231 desde resetStats()
+  uint32_t getElapsedSeconds() {
+    account();
+    return rtcManager->getEpoch() - startEpoch;
+  }
+
+  // Segundos despierto desde resetStats()
+  uint32_t getAwakeSeconds() {
+    account();
+    return awakeSeconds;
+  }
+
+  // Proporción del tiempo despierto en milésimas (1000 = nunca durmió)
+  unsigned int getDutyCycle() {
+    uint32_t elapsed = getElapsedSeconds();
+    uint32_t awake = awakeSeconds;
+    if (elapsed == 0 || awake >= elapsed) return 1000;
+    // Sin desbordar awake * 1000 en 32 bits (49 días despierto)
+    if (awake < 4000000UL) return awake * 1000UL / elapsed;
+    return awake / (elapsed / 1000UL);
+  }
+
+  uint32_t getSleepCount() {
+    return sleeps;
+  }
+
+  uint32_t getPinWakeCount() {
+    return pinWakes;
+  }
+
+  uint32_t getRtcWakeCount() {
+    return rtcWakes;
+  }
+
+  uint32_t getWatchdogWakeCount() {
+    return watchdogWakes;
+  }
+
+  // Mostrar tiempo despierto y dormido por Serial
+  void displayStats() {
+    uint32_t elapsed = getElapsedSeconds();
+    unsigned int duty = getDutyCycle();
+    
+    Serial.println(F("\n=== Energía ==="));
+    Serial.print(F("Despierto: "));
+    Serial.print(awakeSeconds);
+    Serial.print(F(" s de "));
+    Serial.print(elapsed);
+    Serial.print(F(" s ("));
+    Serial.print(duty / 10);
+    Serial.print(F("."));
+    Serial.print(duty % 10);
+    Serial.println(F("%)"));
+    Serial.print(F("Sueños: "));
+    Serial.print(sleeps);
+    Serial.print(F(", despertares por botón/serie: "));
+    Serial.print(pinWakes);
+    Serial.print(F(", RTC: "));
+    Serial.print(rtcWakes);
+    Serial.print(F(", watchdog: "));
+    Serial.println(watchdogWakes);
+    Serial.println(F("==============="));
+  }
+};
+
+#endif // POWER_MANAGER_H
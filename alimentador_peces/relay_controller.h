@@ -1,86 +1,439 @@
 /*
-  relay_controller.h - Controlador del relay y LED indicador
+  relay_controller.h - Controlador de los relays y LED indicador
   
   Este módulo maneja el control del relay que activa el alimentador
   y el LED indicador de estado.
+
+  Los pines se resuelven al compilar con pin_map.h: los relays que
+  comparten puerto cambian con una sola escritura al registro (con los
+  pines de config.h, el relay 1 en PORTD y los relays 2-4 en PORTB), y
+  el estado se responde desde una copia en RAM sin leer los pines.
+
+  Cada relay es un canal independiente, con su propia dosis (duración)
+  y su propio estado: varios tanques pueden alimentarse a la vez con
+  dosis distintas, y un horario puede llegar mientras otro canal sigue
+  alimentando. Los arranques se separan RELAY_STAGGER_MS para que la
+  corriente de arranque de los motores no coincida.
+
+  El corte no depende del loop: el Timer1 en modo CTC interrumpe cada
+  1 ms exacto mientras algún canal está ocupado, arranca los canales que
+  esperan su turno y apaga cada uno al terminar su dosis, aunque el loop
+  esté detenido en un delay() del LCD o del menú. La misma interrupción
+  genera el tren de pulsos (FEED_PULSE_ON_MS / FEED_PULSE_OFF_MS) para
+  alimentadores de tornillo sin fin. update() solo apaga el LED cuando
+  terminaron todos los canales.
+
+  Con la alarma del DS3231 (USE_RTC_ALARM) el sketch deja armada la
+  dosis del próximo horario con armAlarmDose(), y feedAlarmFire() la
+  arranca desde la interrupción de la alarma: la alimentación empieza
+  en el flanco de INT/SQW aunque el loop esté ocupado. El loop enciende
+  después el LED con takeAlarmDose(). Los relays reservados por trabajos
+  que esperan en la FeedQueue quedan para la cola.
+
+  El parpadeo del LED y las pruebas de relays son corrutinas
+  (coroutine.h) que avanza update(): retornan enseguida y el loop sigue
+  con los horarios y la parada de emergencia mientras corren. Una prueba
+  no toca los canales que están alimentando, y emergencyStop() la corta.
 */
 
 #ifndef RELAY_CONTROLLER_H
 #define RELAY_CONTROLLER_H
 
 #include "config.h"
+#include "pin_map.h"
+#include "coroutine.h"
+
+// Relays encendidos (bit i = relay i + 1), compartido con la interrupción
+static volatile uint8_t relayShadow = 0;
+
+// Máscara en 'port' de los relays de 'relays'
+constexpr uint8_t relayPortMask(uint8_t port, uint8_t relays) {
+  return pinGroupMask(port, relays, RELAY_1_PIN, RELAY_2_PIN, RELAY_3_PIN, RELAY_4_PIN);
+}
+
+// Encender o apagar los relays de 'relays' con un acceso por puerto.
+// Llamar con las interrupciones deshabilitadas: el buzzer escribe PORTB
+// desde el Timer0
+static void relayWrite(uint8_t relays, bool state) {
+  pinPortWrite(PIN_PORT_D, relayPortMask(PIN_PORT_D, relays), state);
+  pinPortWrite(PIN_PORT_B, relayPortMask(PIN_PORT_B, relays), state);
+  pinPortWrite(PIN_PORT_C, relayPortMask(PIN_PORT_C, relays), state);
+  
+  if (state) {
+    relayShadow |= relays;
+  } else {
+    relayShadow &= ~relays;
+  }
+}
+
+// Dosis de un canal (compartida con la interrupción)
+struct RelayChannel {
+  uint16_t startDelay;   // ms hasta encender (arranque escalonado)
+  uint16_t remaining;    // ms de dosis que faltan desde el encendido
+  uint16_t phaseLeft;    // ms hasta el próximo cambio del tren de pulsos
+  bool pulseOn;
+};
+
+static volatile RelayChannel relayChannels[RELAY_CHANNELS];
+static volatile uint8_t feedChannelsBusy = 0;   // Canales con dosis en curso o en espera (bit i = relay i + 1)
+static volatile uint16_t feedStaggerLeft = 0;   // ms hasta el próximo arranque permitido
+
+static inline void feedTimerStop() {
+#if defined(__AVR__)
+  TCCR1B = 0;
+  TIMSK1 &= ~bit(OCIE1A);
+#else
+  detachTimer1CompareInterrupt();
+#endif
+}
+
+// Un tick de 1 ms: arrancar los canales que cumplieron su espera, cortar
+// los que terminaron su dosis y alternar los del tren de pulsos
+static void feedTimerTick() {
+  uint8_t switchOn = 0;
+  uint8_t switchOff = 0;
+  uint8_t mask = 1;
+  
+  if (feedStaggerLeft) {
+    feedStaggerLeft--;
+  }
+  
+  for (uint8_t i = 0; i < RELAY_CHANNELS; i++, mask <<= 1) {
+    if (!(feedChannelsBusy & mask)) continue;
+    volatile RelayChannel& channel = relayChannels[i];
+    
+    if (channel.startDelay) {
+      if (--channel.startDelay == 0) {
+        switchOn |= mask;
+      }
+      continue;
+    }
+    
+    if (--channel.remaining == 0) {
+      switchOff |= mask;
+      feedChannelsBusy &= ~mask;
+      continue;
+    }
+    
+    if (FEED_PULSE_OFF_MS > 0 && --channel.phaseLeft == 0) {
+      channel.pulseOn = !channel.pulseOn;
+      if (channel.pulseOn) {
+        switchOn |= mask;
+      } else {
+        switchOff |= mask;
+      }
+      channel.phaseLeft = channel.pulseOn ? FEED_PULSE_ON_MS : FEED_PULSE_OFF_MS;
+    }
+  }
+  
+  if (switchOn) relayWrite(switchOn, true);
+  if (switchOff) relayWrite(switchOff, false);
+  
+  if (!feedChannelsBusy) {
+    feedTimerStop();
+    feedStaggerLeft = 0;
+  }
+}
+
+#if defined(__AVR__)
+ISR(TIMER1_COMPA_vect) {
+  feedTimerTick();
+}
+#endif
+
+// Dar una dosis de durationMs (1-65535) a los canales libres de 'relays',
+// cada uno RELAY_STAGGER_MS después del arranque anterior. Retorna los
+// canales asignados; llamar con las interrupciones deshabilitadas
+static uint8_t feedTimerStart(uint8_t relays, uint16_t durationMs) {
+  uint8_t wasBusy = feedChannelsBusy;
+  uint8_t assigned = relays & RELAY_ALL & ~wasBusy;
+  uint8_t switchOn = 0;
+  uint8_t waiting = 0;
+  uint8_t mask = 1;
+  
+  for (uint8_t i = 0; i < RELAY_CHANNELS; i++, mask <<= 1) {
+    if (!(assigned & mask)) continue;
+    volatile RelayChannel& channel = relayChannels[i];
+    channel.startDelay = feedStaggerLeft;
+    channel.remaining = durationMs;
+    channel.phaseLeft = FEED_PULSE_ON_MS;
+    channel.pulseOn = true;
+    if (!feedStaggerLeft) {
+      switchOn |= mask;
+    } else {
+      waiting |= mask;
+    }
+    feedStaggerLeft += RELAY_STAGGER_MS;
+  }
+  
+  feedChannelsBusy = wasBusy | assigned;
+  if (switchOn) relayWrite(switchOn, true);
+  // Los que esperan su turno arrancan apagados (una prueba pudo dejarlos encendidos)
+  if (waiting) relayWrite(waiting, false);
+  
+  // Con otros canales en curso el Timer1 ya corre: no reiniciarlo
+  if (wasBusy || !assigned) return assigned;
+  
+#if defined(__AVR__)
+  // CTC con prescaler 64: 250 cuentas = 1 ms. Pines 9 y 10 dejan de
+  // tener PWM, pero aquí son relays
+  TCCR1B = 0;
+  TCCR1A = 0;
+  TCNT1 = 0;
+  OCR1A = F_CPU / 64 / 1000 - 1;
+  TIFR1 = bit(OCF1A);
+  TIMSK1 |= bit(OCIE1A);
+  TCCR1B = bit(WGM12) | bit(CS11) | bit(CS10);
+#else
+  attachTimer1CompareInterrupt(feedTimerTick, 1000);
+#endif
+  return assigned;
+}
+
+// Cortar los canales de 'relays'; llamar con las interrupciones deshabilitadas
+static void feedTimerCancel(uint8_t relays) {
+  feedChannelsBusy &= ~relays;
+  relayWrite(relays, false);
+  if (!feedChannelsBusy) {
+    feedTimerStop();
+    feedStaggerLeft = 0;
+  }
+}
+
+// Dosis que arranca la interrupción de la alarma del DS3231
+static volatile uint8_t alarmDoseRelays = 0;     // 0 = sin dosis armada
+static volatile uint16_t alarmDoseMs = 0;
+static volatile uint8_t alarmDoseStarted = 0;    // Canales que arrancó la última alarma
+static volatile bool alarmDoseFired = false;
+static volatile uint8_t feedRelaysReserved = 0;  // Relays que espera un trabajo de la FeedQueue
+
+// Llamar desde la interrupción de la alarma: arranca la dosis armada
+// en sus canales libres (una sola vez). Los relays que ya espera un
+// trabajo de la cola no se tocan: el horario los pide a la cola y
+// sale detrás de ese trabajo
+static inline void feedAlarmFire() {
+  if (!alarmDoseRelays) return;
+  alarmDoseStarted = feedTimerStart(alarmDoseRelays & ~feedRelaysReserved, alarmDoseMs);
+  alarmDoseRelays = 0;
+  alarmDoseFired = true;
+}
 
 class RelayController {
 private:
-  unsigned long feedStartTime;
+  uint32_t channelStartTime[RELAY_CHANNELS];        // millis() al asignar cada dosis
+  uint16_t channelLimit[RELAY_CHANNELS];            // Espera de arranque + dosis (ms)
   bool isFeeding;
-  int relayPins[4];
-  int activeRelays;
+  bool ledShadow;
+
+  // Parpadeo del LED (blinkLed)
+  Coroutine blinkTask;
+  uint8_t blinkTimes;
+  uint8_t blinkCount;
+  uint16_t blinkMs;
+
+  // Prueba de relays: todos juntos (testRelays) o de a uno (testAllRelays)
+  Coroutine testTask;
+  uint8_t testOn;                                   // Relays que encendió la prueba
+  uint8_t testStep;
+  bool testSequential;
+  uint16_t testMs;
+
+  typedef FastPin<LED_PIN> LedPin;
+
+  // Encender o apagar los relays de 'relays' desde el loop
+  void writeRelays(uint8_t relays, bool state) {
+    noInterrupts();
+    relayWrite(relays, state);
+    interrupts();
+  }
 
   // Método privado para controlar todos los relays
   void setAllRelays(bool state) {
-    for (int i = 0; i < 4; i++) {
-      digitalWrite(relayPins[i], state ? HIGH : LOW);
+    writeRelays(RELAY_ALL, state);
+  }
+
+  void writeLed(bool state) {
+    LedPin::write(state);
+    ledShadow = state;
+  }
+
+  // Encender o apagar relays de la prueba sin tocar los canales que
+  // están alimentando (el Timer1 los maneja)
+  void writeTestRelays(uint8_t relays, bool state) {
+    noInterrupts();
+    relayWrite(relays & ~feedChannelsBusy, state);
+    interrupts();
+  }
+
+  // Parpadear y dejar el LED indicando si hay alimentación en curso
+  bool runBlink() {
+    CO_BEGIN(blinkTask);
+    for (blinkCount = 0; blinkCount < blinkTimes; blinkCount++) {
+      writeLed(true);
+      CO_DELAY(blinkTask, blinkMs);
+      writeLed(false);
+      CO_DELAY(blinkTask, blinkMs);
     }
+    writeLed(isFeeding);
+    CO_END(blinkTask);
+  }
+
+  // Encender cada paso de la prueba durante testMs
+  bool runTest() {
+    CO_BEGIN(testTask);
+    for (testStep = 0; testStep < (testSequential ? RELAY_CHANNELS : 1); testStep++) {
+      testOn = testSequential ? 1 << testStep : RELAY_ALL;
+      writeTestRelays(testOn, true);
+      CO_DELAY(testTask, testMs);
+      writeTestRelays(testOn, false);
+      testOn = 0;
+    }
+    CO_END(testTask);
+  }
+
+  // Empezar una prueba (la anterior, si sigue, se corta)
+  void startTest(bool sequential, int stepMs) {
+    stopTest();
+    testSequential = sequential;
+    testMs = max(stepMs, 0);
+    testTask.start();
+    runTest();
+  }
+
+  // Apagar lo que encendió la prueba y abandonarla
+  void stopTest() {
+    if (!testTask.isRunning()) return;
+    writeTestRelays(testOn, false);
+    testOn = 0;
+    testTask.stop();
+  }
+
+  // Cortar todos los canales y apagar el LED (durante un parpadeo el
+  // LED queda a cargo de runBlink())
+  void endFeeding() {
+    noInterrupts();
+    feedTimerCancel(RELAY_ALL);
+    interrupts();
+    if (!blinkTask.isRunning()) writeLed(false);
+    isFeeding = false;
   }
 
 public:
   // Constructor
-  RelayController() : feedStartTime(0), isFeeding(false), activeRelays(0) {
-    relayPins[0] = RELAY_1_PIN;
-    relayPins[1] = RELAY_2_PIN;
-    relayPins[2] = RELAY_3_PIN;
-    relayPins[3] = RELAY_4_PIN;
+  RelayController()
+    : isFeeding(false), ledShadow(false), blinkTimes(0), blinkCount(0), blinkMs(0), testOn(0), testStep(0),
+      testSequential(false), testMs(0) {
+    for (uint8_t i = 0; i < RELAY_CHANNELS; i++) {
+      channelStartTime[i] = 0;
+      channelLimit[i] = 0;
+    }
   }
 
   // Inicializar los pines del relay y LED
   void begin() {
-    // Configurar pines de relays
-    for (int i = 0; i < 4; i++) {
-      pinMode(relayPins[i], OUTPUT);
-    }
-    pinMode(LED_PIN, OUTPUT);
-    
-    // Asegurar que todos los relays estén apagados al inicio
+    // Asegurar que todos los relays estén apagados antes de ser salidas
     setAllRelays(false);
-    digitalWrite(LED_PIN, LOW);
+    writeLed(false);
     
-    // Verificar que los pines se configuraron correctamente
-    delay(10);
-    if (digitalRead(relayPins[0]) != LOW || digitalRead(LED_PIN) != LOW) {
-      isFeeding = false;
-    }
+    // Configurar pines de relays
+    pinMode(RELAY_1_PIN, OUTPUT);
+    pinMode(RELAY_2_PIN, OUTPUT);
+    pinMode(RELAY_3_PIN, OUTPUT);
+    pinMode(RELAY_4_PIN, OUTPUT);
+    LedPin::output();
   }
 
-  // Iniciar proceso de alimentación
-  void startFeeding(int scheduleNumber = 0) {
-    if (isFeeding) {
-      return;
+  // Iniciar proceso de alimentación (todos los relays, FEED_DURATION)
+  void startFeeding() {
+    startFeedingWithRelays(RELAY_ALL, FEED_DURATION);
+  }
+
+  // Dar una dosis de 'duration' segundos a los relays de relayMask. Los
+  // canales que ya están alimentando siguen con su dosis; retorna los
+  // que arrancaron (escalonados, el Timer1 los apaga)
+  uint8_t startFeedingWithRelays(int relayMask, int duration = FEED_DURATION) {
+    uint16_t durationMs = constrain(duration, MIN_FEED_DURATION, MAX_FEED_DURATION) * 1000U;
+    uint32_t now = millis();
+    
+    noInterrupts();
+    uint8_t started = feedTimerStart(relayMask, durationMs);
+    uint8_t mask = 1;
+    for (uint8_t i = 0; i < RELAY_CHANNELS; i++, mask <<= 1) {
+      if (started & mask) {
+        channelStartTime[i] = now;
+        channelLimit[i] = relayChannels[i].startDelay + durationMs;
+      }
     }
+    interrupts();
     
-    // Activar todos los relays y LED
-    setAllRelays(true);
-    digitalWrite(LED_PIN, HIGH);
+    if (started) {
+      writeLed(true);
+      isFeeding = true;
+    }
+    return started;
+  }
+
+  // Armar la dosis que arranca la próxima alarma del DS3231
+  void armAlarmDose(uint8_t relays, int duration) {
+    noInterrupts();
+    alarmDoseRelays = relays & RELAY_ALL;
+    alarmDoseMs = constrain(duration, MIN_FEED_DURATION, MAX_FEED_DURATION) * 1000U;
+    interrupts();
+  }
+
+  // Desarmar la dosis (no hay horarios habilitados)
+  void disarmAlarmDose() {
+    noInterrupts();
+    alarmDoseRelays = 0;
+    interrupts();
+  }
+
+  // Recoger la dosis que arrancó la alarma: retorna los canales que
+  // arrancaron (0 si no sonó o estaban ocupados) y enciende el LED
+  uint8_t takeAlarmDose() {
+    noInterrupts();
+    bool fired = alarmDoseFired;
+    uint8_t started = alarmDoseStarted;
+    alarmDoseFired = false;
+    alarmDoseStarted = 0;
+    interrupts();
+    if (!fired || !started) return 0;
     
-    // Registrar tiempo de inicio
-    feedStartTime = millis();
+    uint32_t now = millis();
+    uint8_t mask = 1;
+    noInterrupts();
+    for (uint8_t i = 0; i < RELAY_CHANNELS; i++, mask <<= 1) {
+      if (started & mask) {
+        channelStartTime[i] = now;
+        channelLimit[i] = relayChannels[i].startDelay + relayChannels[i].remaining;
+      }
+    }
+    interrupts();
+    writeLed(true);
     isFeeding = true;
+    return started;
   }
 
-  // Controlar la duración de la alimentación
+  // Avanzar el parpadeo y la prueba de relays, y apagar el LED cuando
+  // el Timer1 cortó todos los canales
   void update() {
-    if (isFeeding) {
-      unsigned long currentTime = millis();
-      unsigned long elapsed = currentTime - feedStartTime;
-      
-      // Protección contra overflow de millis()
-      if (elapsed >= FEED_DURATION * 1000) {
-        stopFeeding();
-      }
-      
-      // Protección contra alimentación muy larga (máximo 30 segundos)
-      if (elapsed > 30000) {
+    if (blinkTask.isRunning()) runBlink();
+    if (testTask.isRunning()) runTest();
+    if (!isFeeding) return;
+    
+    uint8_t busy = feedChannelsBusy;
+    if (!busy) {
+      endFeeding();
+      return;
+    }
+    
+    // Protección: un canal que sigue ocupado 1 s después de su corte
+    uint32_t now = millis();
+    uint8_t mask = 1;
+    for (uint8_t i = 0; i < RELAY_CHANNELS; i++, mask <<= 1) {
+      if ((busy & mask) && now - channelStartTime[i] > channelLimit[i] + 1000UL) {
         emergencyStop();
+        return;
       }
     }
   }
@@ -88,27 +441,50 @@ public:
   // Detener proceso de alimentación
   void stopFeeding() {
     if (!isFeeding) return;
+    endFeeding();
+  }
+
+  // Cortar la dosis de un canal (1-4) sin tocar los demás
+  void stopChannel(int relayNumber) {
+    if (relayNumber < 1 || relayNumber > RELAY_CHANNELS) return;
     
-    // Desactivar todos los relays y LED
-    setAllRelays(false);
-    digitalWrite(LED_PIN, LOW);
-    
-    isFeeding = false;
+    noInterrupts();
+    feedTimerCancel(1 << (relayNumber - 1));
+    interrupts();
   }
 
-  // Verificar si está alimentando actualmente
+  // Verificar si está alimentando actualmente (algún canal ocupado)
   bool isFeedingActive() {
     return isFeeding;
   }
 
-  // Obtener tiempo restante de alimentación en segundos
+  // Verificar si un canal (1-4) tiene una dosis en curso o esperando su arranque
+  bool isChannelActive(int relayNumber) {
+    if (relayNumber < 1 || relayNumber > RELAY_CHANNELS) return false;
+    return feedChannelsBusy & (1 << (relayNumber - 1));
+  }
+
+  // Milisegundos hasta el corte de un canal (1-4), contando la espera del arranque
+  uint16_t getChannelRemaining(int relayNumber) {
+    if (!isChannelActive(relayNumber)) return 0;
+    
+    noInterrupts();
+    volatile RelayChannel& channel = relayChannels[relayNumber - 1];
+    uint16_t remaining = channel.startDelay + channel.remaining;
+    interrupts();
+    return remaining;
+  }
+
+  // Obtener tiempo restante de alimentación en segundos (el canal que más tarda)
   int getRemainingFeedTime() {
     if (!isFeeding) return 0;
     
-    unsigned long currentTime = millis();
-    unsigned long elapsed = (currentTime - feedStartTime) / 1000;
-    int remaining = FEED_DURATION - elapsed;
-    return (remaining > 0) ? remaining : 0;
+    uint16_t longest = 0;
+    for (int relay = 1; relay <= RELAY_CHANNELS; relay++) {
+      uint16_t remaining = getChannelRemaining(relay);
+      if (remaining > longest) longest = remaining;
+    }
+    return (longest + 999UL) / 1000;
   }
 
   // Activar/desactivar todos los relays manualmente (para pruebas)
@@ -118,98 +494,75 @@ public:
 
   // Activar/desactivar un relay específico (para pruebas individuales)
   void setRelayState(int relayNumber, bool state) {
-    if (relayNumber >= 1 && relayNumber <= 4) {
-      digitalWrite(relayPins[relayNumber - 1], state ? HIGH : LOW);
+    if (relayNumber >= 1 && relayNumber <= RELAY_CHANNELS) {
+      writeRelays(1 << (relayNumber - 1), state);
     }
   }
 
   // Activar/desactivar LED manualmente (para pruebas)
   void setLedState(bool state) {
-    digitalWrite(LED_PIN, state ? HIGH : LOW);
+    writeLed(state);
   }
 
-  // Parpadear LED (para indicaciones especiales)
+  // Parpadear LED (para indicaciones especiales); retorna enseguida y
+  // update() lo avanza. Al terminar, el LED vuelve a indicar si hay
+  // alimentación en curso
   void blinkLed(int times = 3, int delayMs = 200) {
-    bool originalState = digitalRead(LED_PIN);
-    
-    for (int i = 0; i < times; i++) {
-      digitalWrite(LED_PIN, HIGH);
-      delay(delayMs);
-      digitalWrite(LED_PIN, LOW);
-      delay(delayMs);
-    }
+    blinkTimes = constrain(times, 0, 255);
+    blinkMs = max(delayMs, 0);
+    blinkTask.start();
+    runBlink();
+  }
     
-    // Restaurar estado original
-    digitalWrite(LED_PIN, originalState);
+  // Verificar si hay un parpadeo en curso
+  bool isBlinking() {
+    return blinkTask.isRunning();
   }
 
   // Obtener estado actual de todos los relays (true si al menos uno está activo)
   bool getRelayState() {
-    for (int i = 0; i < 4; i++) {
-      if (digitalRead(relayPins[i]) == HIGH) {
-        return true;
-      }
-    }
-    return false;
+    return relayShadow != 0;
   }
 
   // Obtener estado de un relay específico
   bool getRelayState(int relayNumber) {
-    if (relayNumber >= 1 && relayNumber <= 4) {
-      return digitalRead(relayPins[relayNumber - 1]) == HIGH;
+    if (relayNumber >= 1 && relayNumber <= RELAY_CHANNELS) {
+      return relayShadow & (1 << (relayNumber - 1));
     }
     return false;
   }
 
   // Obtener estado actual del LED
   bool getLedState() {
-    return digitalRead(LED_PIN) == HIGH;
+    return ledShadow;
   }
 
-  // Forzar parada de emergencia
+  // Forzar parada de emergencia (todos los canales y la prueba de relays)
   void emergencyStop() {
-    setAllRelays(false);
-    digitalWrite(LED_PIN, LOW);
-    isFeeding = false;
-  }
-
-  // Iniciar alimentación con relays específicos
-  void startFeedingWithRelays(int relayMask) {
-    if (isFeeding) {
-      return;
-    }
-    
-    // Activar solo los relays especificados en el mask
-    for (int i = 0; i < 4; i++) {
-      if (relayMask & (1 << i)) {
-        digitalWrite(relayPins[i], HIGH);
-      }
-    }
-    digitalWrite(LED_PIN, HIGH);
-    
-    feedStartTime = millis();
-    isFeeding = true;
-    activeRelays = relayMask;
+    stopTest();
+    endFeeding();
   }
 
   // Obtener número de relays activos
   int getActiveRelayCount() {
-    int count = 0;
-    for (int i = 0; i < 4; i++) {
-      if (digitalRead(relayPins[i]) == HIGH) {
-        count++;
-      }
-    }
-    return count;
+    static const uint8_t bitCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+    return bitCount[relayShadow];
   }
 
-  // Probar todos los relays secuencialmente
+  // Probar todos los relays secuencialmente, delayMs cada uno; retorna
+  // enseguida y update() la avanza
   void testAllRelays(int delayMs = 500) {
-    for (int i = 0; i < 4; i++) {
-      digitalWrite(relayPins[i], HIGH);
-      delay(delayMs);
-      digitalWrite(relayPins[i], LOW);
-    }
+    startTest(true, delayMs);
+  }
+
+  // Encender todos los relays juntos durante durationMs (prueba)
+  void testRelays(int durationMs) {
+    startTest(false, durationMs);
+  }
+
+  // Verificar si hay una prueba de relays en curso
+  bool isTesting() {
+    return testTask.isRunning();
   }
 };
 
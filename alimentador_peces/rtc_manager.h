@@ -1,64 +1,545 @@
 /*
   rtc_manager.h - Gestor del reloj de tiempo real DS3231
-  
+
   Este módulo maneja todas las operaciones relacionadas con el RTC DS3231,
   incluyendo inicialización, lectura de tiempo y configuración.
+
+  La hora se guarda en una copia local que se actualiza en update(), una
+  vez por pasada del loop; todas las consultas se responden desde esa
+  copia sin tocar el bus I2C. Con USE_RTC_SQW el DS3231 genera una onda
+  cuadrada de 1 Hz y cada flanco de bajada suma un segundo a un reloj por
+  software, que solo se relee por I2C cada RTC_RESYNC_INTERVAL. Si la
+  onda deja de llegar se vuelve a leer el DS3231 cada RTC_SNAPSHOT_MAX_AGE.
+
+  Con USE_RTC_ALARM el mismo pin queda para la alarma 1, que el sketch
+  programa con el próximo horario: la interrupción del flanco llama a
+  un manejador (la dosis arranca ahí, sin esperar al loop) y update()
+  limpia la bandera. Sin onda cuadrada los segundos se cuentan con
+  millis(): cada alarma fija la fase (sonó en el segundo 0) y entre
+  alarmas se relee el DS3231 cada RTC_ALARM_RESYNC_INTERVAL, corrigiendo
+  solo si el reloj se desvió un segundo entero.
+
+  Los registros del DS3231 se leen y escriben con ds3231.h, en ráfagas
+  de prioridad alta de twi_engine.h: update() pide la lectura y la
+  recoge en una pasada posterior, sin esperar al bus. El arranque
+  (startBegin() y updateBegin()) también: es una corrutina que pide
+  cada registro y sigue cuando llega la respuesta. setTime() escribe solo la hora y setDate() solo la
+  fecha, sin leer antes el DS3231.
 */
 
 #ifndef RTC_MANAGER_H
 #define RTC_MANAGER_H
 
-#include <Wire.h>
-#include <RTClib.h>
 #include "config.h"
+#include "date_time.h"
+#include "ds3231.h"
+#include "coroutine.h"
+
+// Flancos de bajada de la onda cuadrada del DS3231 (uno por segundo)
+static volatile uint32_t rtcSqwEdges = 0;
+
+// Flancos contados cuando terminó la última lectura de la hora
+static uint32_t rtcEdgesAtRead = 0;
+
+static void rtcSquareWaveISR() {
+  rtcSqwEdges++;
+}
+
+// Alarmas del DS3231 (flancos de bajada de INT/SQW con INTCN = 1) y
+// millis() de la última
+static volatile uint32_t rtcAlarmEdges = 0;
+static volatile uint32_t rtcAlarmMillis = 0;
+
+// Se llama desde la interrupción de cada alarma (0 = ninguno)
+static void (*volatile rtcAlarmHandler)() = 0;
+
+static void rtcAlarmISR() {
+  rtcAlarmEdges++;
+  rtcAlarmMillis = millis();
+  if (rtcAlarmHandler) {
+    rtcAlarmHandler();
+  }
+}
+
+// Se llama desde la interrupción TWI al terminar la lectura de la hora;
+// no mira el estado del trabajo porque collectRead() descarta las fallidas
+static void rtcReadComplete(TWIJob*) {
+  rtcEdgesAtRead = rtcSqwEdges;
+}
+
+#if defined(__AVR__)
+// A0-A3 comparten PCINT1: contar solo los flancos de bajada del pin SQW
+ISR(PCINT1_vect) {
+  if (digitalRead(RTC_SQW_PIN) == LOW) {
+    if (USE_RTC_ALARM) {
+      rtcAlarmISR();
+    } else {
+      rtcSquareWaveISR();
+    }
+  }
+}
+#endif
 
 class RTCManager {
 private:
-  RTC_DS3231 rtc;
-  unsigned long lastTimeDisplay;
+  uint32_t lastTimeDisplay;
+
+  // Copia de la hora actual
+  DateTime snapshot;
+  uint32_t snapshotEpoch;
+  uint32_t snapshotMillis;
+  bool snapshotValid;
+  uint32_t reportedEpoch;
+
+  // Reloj por software alimentado por la onda cuadrada
+  bool sqwEnabled;
+  bool sqwActive;
+  uint32_t syncEpoch;
+  uint32_t syncEdges;
+  uint32_t lastEdges;
+  uint32_t lastEdgeMillis;
+  uint32_t lastSyncMillis;
+
+  // Reloj por millis() con la alarma 1 (sin onda cuadrada)
+  bool alarmEnabled;
+  bool alarmPending;           // Sonó la alarma y el sketch no la atendió
+  bool alarmPhase;             // La próxima lectura alinea con una alarma (segundo 0)
+  bool clockValid;
+  uint32_t syncMillis;         // millis() en el inicio del segundo syncEpoch
+  uint32_t alarmMillis;        // millis() de la última alarma
+  uint32_t lastAlarmEdges;
+
+  // Lecturas del DS3231
+  DS3231 ds3231;
+  bool readInFlight;           // Hay una lectura de la hora sin recoger
+  bool readForResync;          // Esa lectura realinea el reloj por software
+  bool readStale;              // Esa lectura salió antes de escribir la hora
+  uint32_t readEdgesBefore;
+
+  // Veces que se ajustó la hora (para que otros módulos recalculen)
+  unsigned int timeChanges;
+
+  // Arranque por el bus sin esperar (startBegin())
+  Coroutine beginTask;
+  bool started;                // El DS3231 respondió y ya hay hora
+
+  // Guardar en la copia la última lectura del DS3231; retorna sus segundos Unix
+  uint32_t snapshotFromRead() {
+    DS3231Time time;
+    ds3231.getTime(time);
+    uint32_t epoch = DS3231::toEpoch(time);
+    setSnapshot(DateTime(2000U + time.year, time.month, time.day, time.hour, time.minute, time.second), epoch);
+    return epoch;
+  }
+
+  // Pedir la hora al DS3231; el resultado se recoge en collectRead()
+  void requestRead(bool resync) {
+    if (readInFlight) return;
+    readInFlight = true;
+    readForResync = resync;
+    readEdgesBefore = readSqwEdges();
+    ds3231.requestTime();
+  }
+
+  // Recoger la lectura de la hora si ya terminó
+  void collectRead() {
+    if (!readInFlight || ds3231.isReadPending()) return;
+    readInFlight = false;
+    
+    // Se leyó la hora vieja: pedirla otra vez
+    if (readStale) {
+      readStale = false;
+      requestRead(readForResync);
+      return;
+    }
+    
+    // Si falló, se vuelve a pedir en la próxima pasada que la necesite
+    if (!ds3231.isReadValid()) return;
+    
+    // Repetir si un flanco llegó durante la lectura
+    if (readForResync && rtcEdgesAtRead != readEdgesBefore) {
+      requestRead(true);
+      return;
+    }
+    
+    uint32_t epoch = snapshotFromRead();
+    if (readForResync && alarmEnabled) {
+      alignClock(epoch);
+    } else if (readForResync) {
+      syncEpoch = epoch;
+      syncEdges = rtcEdgesAtRead;
+      lastEdges = rtcEdgesAtRead;
+      lastSyncMillis = millis();
+      sqwActive = true;
+    }
+  }
+
+  // Segundos Unix del reloj por millis()
+  uint32_t clockEpoch() {
+    return syncEpoch + (millis() - syncMillis) / 1000;
+  }
+
+  // Alinear el reloj por millis() con una lectura del DS3231. Tras una
+  // alarma la fase es exacta (sonó en el segundo 0); si no, solo se
+  // corrige cuando se desvió un segundo entero, para no perder la fase
+  void alignClock(uint32_t epoch) {
+    lastSyncMillis = millis();
+    if (alarmPhase) {
+      alarmPhase = false;
+      syncEpoch = epoch - epoch % 60;
+      syncMillis = alarmMillis;
+      clockValid = true;
+      return;
+    }
+    if (!clockValid || clockEpoch() != epoch) {
+      syncEpoch = epoch;
+      syncMillis = millis();
+      clockValid = true;
+    }
+  }
+
+  // Atender las alarmas y avanzar el reloj por millis()
+  void updateAlarmClock() {
+    noInterrupts();
+    uint32_t edges = rtcAlarmEdges;
+    uint32_t edgeMillis = rtcAlarmMillis;
+    interrupts();
+    
+    if (edges != lastAlarmEdges) {
+      lastAlarmEdges = edges;
+      alarmPending = true;
+      ds3231.clearAlarmFlags();
+      
+      // Releer la hora para fijar la fase; una lectura ya en cola es de antes
+      alarmPhase = true;
+      alarmMillis = edgeMillis;
+      if (readInFlight) {
+        readStale = true;
+        readForResync = true;
+      } else {
+        requestRead(true);
+      }
+    } else if (millis() - lastSyncMillis >= RTC_ALARM_RESYNC_INTERVAL) {
+      requestRead(true);
+    }
+    
+    if (clockValid) {
+      uint32_t epoch = clockEpoch();
+      if (epoch != snapshotEpoch) {
+        setSnapshot(DateTime(epoch), epoch);
+      }
+    }
+  }
+
+  // Escribir hora y fecha en el DS3231 sin esperar al bus
+  void writeRTC(const DateTime& requested) {
+    // Normalizar (por ejemplo, día 32 pasa al mes siguiente)
+    DateTime time(requested.unixtime());
+    DS3231Time registers = {time.second(), time.minute(), time.hour(),
+                            time.day(), time.month(), (uint8_t)(time.year() - 2000U)};
+    ds3231.writeDateTime(registers, time.dayOfTheWeek());
+    timeWritten(time);
+  }
+
+  // Escribir solo la fecha (normalizada); la hora del DS3231 sigue corriendo
+  void writeDate(const DateTime& requested) {
+    DateTime date(requested.unixtime());
+    ds3231.writeDate(date.day(), date.month(), date.year() - 2000U, date.dayOfTheWeek());
+    DateTime currentTime = now();
+    timeWritten(DateTime(date.year(), date.month(), date.day(),
+                         currentTime.hour(), currentTime.minute(), currentTime.second()), false);
+  }
+
+  // La copia pasa a la hora escrita; el reloj por software espera al
+  // próximo flanco para volver a alinearse con el DS3231. El reloj por
+  // millis() sigue a la hora escrita: escribir los segundos fija su fase
+  void timeWritten(const DateTime& time, bool secondsWritten = true) {
+    setSnapshot(time, time.unixtime());
+    timeChanges++;
+    
+    if (alarmEnabled) {
+      if (secondsWritten || !clockValid) {
+        syncMillis = millis();
+        syncEpoch = time.unixtime();
+      } else {
+        syncEpoch = time.unixtime() - (millis() - syncMillis) / 1000;
+      }
+      clockValid = true;
+      lastSyncMillis = millis();
+    }
+    
+    // Una lectura que ya estaba en cola trae la hora anterior
+    if (readInFlight) {
+      readStale = true;
+    }
+    
+    // Escribir los segundos reinicia la cadena de división del DS3231
+    sqwActive = false;
+  }
+
+  // Guardar una nueva copia de la hora
+  void setSnapshot(const DateTime& time, uint32_t epoch) {
+    snapshot = time;
+    snapshotEpoch = epoch;
+    snapshotMillis = millis();
+    snapshotValid = true;
+  }
+
+  // Copia atómica del contador de flancos
+  uint32_t readSqwEdges() {
+    noInterrupts();
+    uint32_t edges = rtcSqwEdges;
+    interrupts();
+    return edges;
+  }
+
+  // Habilitar la interrupción del pin INT/SQW (onda cuadrada o alarma)
+  void attachIntPin() {
+#if defined(__AVR__)
+    *digitalPinToPCMSK(RTC_SQW_PIN) |= bit(digitalPinToPCMSKbit(RTC_SQW_PIN));
+    PCIFR |= bit(digitalPinToPCICRbit(RTC_SQW_PIN));
+    PCICR |= bit(digitalPinToPCICRbit(RTC_SQW_PIN));
+#else
+    attachInterrupt(digitalPinToInterrupt(RTC_SQW_PIN), USE_RTC_ALARM ? rtcAlarmISR : rtcSquareWaveISR, FALLING);
+#endif
+  }
 
 public:
   // Constructor
-  RTCManager() : lastTimeDisplay(0) {}
+  RTCManager() : lastTimeDisplay(0), snapshotEpoch(0), snapshotMillis(0), snapshotValid(false),
+                 reportedEpoch(0), sqwEnabled(false), sqwActive(false), syncEpoch(0),
+                 syncEdges(0), lastEdges(0), lastEdgeMillis(0), lastSyncMillis(0),
+                 alarmEnabled(false), alarmPending(false), alarmPhase(false), clockValid(false),
+                 syncMillis(0), alarmMillis(0), lastAlarmEdges(0),
+                 ds3231(rtcReadComplete), readInFlight(false), readForResync(false), readStale(false),
+                 readEdgesBefore(0), timeChanges(0), started(false) {}
+
+  // Empezar el arranque del RTC sin esperar; updateBegin() lo avanza
+  void startBegin() {
+    twiBus.begin();
+    started = false;
+    beginTask.start();
+  }
 
-  // Inicializar el RTC
-  bool begin() {
-    if (!rtc.begin()) {
-      return false;
+  // Avanzar el arranque; retorna true al terminar (bien o no: ver
+  // isStarted()). Cada lectura sale por el bus y se recoge en una
+  // pasada posterior
+  bool updateBegin() {
+    CO_BEGIN(beginTask);
+    
+    // El registro de estado dice si el DS3231 responde y si perdió la hora
+    CO_WAIT_UNTIL(beginTask, ds3231.requestRegister(DS3231_REG_STATUS));
+    CO_WAIT_UNTIL(beginTask, !ds3231.isRegisterPending());
+    if (!ds3231.isRegisterValid()) {
+      CO_EXIT(beginTask);
     }
     
     // Si el RTC perdió la hora, configurar con la hora de compilación
-    if (rtc.lostPower()) {
-      rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+    // (getRegister() deja el registro de estado para lostPower())
+    ds3231.getRegister();
+    if (ds3231.lostPower()) {
+      writeRTC(DateTime(F(__DATE__), F(__TIME__)));
     }
     
-    return true;
+    if (USE_RTC_ALARM) {
+      // Alarma 1 en INT/SQW (se programa con setAlarm()); banderas viejas limpias
+      CO_WAIT_UNTIL(beginTask, ds3231.requestRegister(DS3231_REG_CONTROL));
+      CO_WAIT_UNTIL(beginTask, !ds3231.isRegisterPending());
+      if (ds3231.isRegisterValid()) {
+        ds3231.writeRegister(DS3231_REG_CONTROL, (ds3231.getRegister() | DS3231_CONTROL_INTCN | DS3231_CONTROL_A1IE) & ~DS3231_CONTROL_A2IE);
+      }
+      CO_WAIT_UNTIL(beginTask, !ds3231.isRegisterPending());
+      ds3231.clearAlarmFlags();
+      pinMode(RTC_SQW_PIN, INPUT_PULLUP);
+      lastAlarmEdges = rtcAlarmEdges;
+      attachIntPin();
+      alarmEnabled = true;
+    } else if (USE_RTC_SQW) {
+      // Onda cuadrada de 1 Hz en INT/SQW (lectura + escritura del registro de control)
+      CO_WAIT_UNTIL(beginTask, ds3231.requestRegister(DS3231_REG_CONTROL));
+      CO_WAIT_UNTIL(beginTask, !ds3231.isRegisterPending());
+      if (ds3231.isRegisterValid()) {
+        ds3231.writeRegister(DS3231_REG_CONTROL, ds3231.getRegister() & ~(DS3231_CONTROL_INTCN | DS3231_CONTROL_RATE));
+      }
+      pinMode(RTC_SQW_PIN, INPUT_PULLUP);
+      lastEdges = readSqwEdges();
+      attachIntPin();
+      sqwEnabled = true;
+    }
+    
+    // Primera lectura de la hora
+    CO_WAIT_UNTIL(beginTask, ds3231.requestTime());
+    CO_WAIT_UNTIL(beginTask, !ds3231.isReadPending());
+    if (!ds3231.isReadValid()) {
+      CO_EXIT(beginTask);
+    }
+    if (alarmEnabled) {
+      alignClock(snapshotFromRead());
+    } else {
+      snapshotFromRead();
+    }
+    started = true;
+    CO_END(beginTask);
+  }
+
+  // Verificar si el último arranque terminó con el DS3231 respondiendo
+  bool isStarted() {
+    return started;
   }
 
-  // Obtener la fecha y hora actual
+  // Actualizar la copia de la hora (llamar una vez por pasada del loop)
+  // Retorna true si empezó un segundo nuevo desde la llamada anterior
+  bool update() {
+    collectRead();
+    
+    if (sqwEnabled) {
+      uint32_t edges = readSqwEdges();
+      
+      if (edges != lastEdges) {
+        lastEdges = edges;
+        lastEdgeMillis = millis();
+        
+        if (!sqwActive || millis() - lastSyncMillis >= RTC_RESYNC_INTERVAL) {
+          requestRead(true);
+        }
+      } else if (sqwActive && millis() - lastEdgeMillis > RTC_SQW_TIMEOUT) {
+        // La onda cuadrada dejó de llegar: volver a leer por I2C
+        sqwActive = false;
+      }
+    }
+    
+    if (alarmEnabled) {
+      updateAlarmClock();
+    } else if (sqwActive) {
+      uint32_t epoch = syncEpoch + (lastEdges - syncEdges);
+      if (epoch != snapshotEpoch) {
+        setSnapshot(DateTime(epoch), epoch);
+      }
+    } else if (!snapshotValid || millis() - snapshotMillis >= RTC_SNAPSHOT_MAX_AGE) {
+      requestRead(false);
+    }
+    
+    if (snapshotValid && snapshotEpoch != reportedEpoch) {
+      reportedEpoch = snapshotEpoch;
+      return true;
+    }
+    return false;
+  }
+
+  // Obtener la fecha y hora actual (desde la copia local)
   DateTime now() {
-    return rtc.now();
+    return snapshot;
+  }
+
+  // Segundos Unix de la hora actual
+  uint32_t getEpoch() {
+    return snapshotEpoch;
+  }
+
+  // Verificar si el reloj avanza con la onda cuadrada
+  bool isSquareWaveActive() {
+    return sqwActive;
+  }
+
+  // Verificar si hay una lectura del DS3231 sin recoger
+  bool isReadPending() {
+    return readInFlight;
+  }
+
+  // Verificar si llegaron flancos de INT/SQW que update() todavía no vio
+  // (llamar con las interrupciones deshabilitadas, antes de dormir)
+  bool hasUnseenEdges() {
+    return rtcAlarmEdges != lastAlarmEdges || (sqwEnabled && rtcSqwEdges != lastEdges);
+  }
+
+  // Tras dormir en power-down: millis() no avanzó, así que el reloj por
+  // millis() y la edad de la copia quedaron atrás. Si se sabe cuánto se
+  // durmió (el período del watchdog), el reloj por millis() avanza eso y
+  // el DS3231 se sigue releyendo cada RTC_ALARM_RESYNC_INTERVAL; si no,
+  // se relee ahora (con la onda cuadrada los flancos se contaron igual)
+  void wakeUp(uint32_t sleptMillis = 0) {
+    if (sqwActive) return;
+    if (alarmEnabled && clockValid && sleptMillis) {
+      syncMillis -= sleptMillis;
+      lastSyncMillis -= sleptMillis;
+      return;
+    }
+    requestRead(alarmEnabled);
+  }
+
+  // === ALARMA 1 ===
+
+  // Verificar si los horarios se disparan con la alarma 1 del DS3231
+  bool isAlarmEnabled() {
+    return alarmEnabled;
+  }
+
+  // Programar la alarma 1: todos los días a hour:minute:00
+  // Retorna enseguida: ver isAlarmWritePending() e isAlarmWritten()
+  void setAlarm(int hour, int minute) {
+    if (!alarmEnabled) return;
+    ds3231.writeAlarm1(hour, minute, 0);
+  }
+
+  // Verificar si la alarma pedida con setAlarm() sigue en el bus
+  bool isAlarmWritePending() {
+    return ds3231.isAlarmWritePending();
+  }
+
+  // Verificar si la última alarma quedó escrita en el DS3231
+  bool isAlarmWritten() {
+    return ds3231.isAlarmWritten();
+  }
+
+  // Función que se llama desde la interrupción de cada alarma: debe ser
+  // corta y no usar el bus I2C ni Serial
+  void setAlarmHandler(void (*handler)()) {
+    noInterrupts();
+    rtcAlarmHandler = handler;
+    interrupts();
+  }
+
+  // Verificar si sonó la alarma y todavía no se atendió
+  bool isAlarmPending() {
+    return alarmPending;
+  }
+
+  // Atender la alarma: true una sola vez por cada vez que sonó
+  bool takeAlarm() {
+    bool pending = alarmPending;
+    alarmPending = false;
+    return pending;
+  }
+
+  // Contador de ajustes de hora (cambia cada vez que se escribe el DS3231)
+  unsigned int getTimeChangeCount() {
+    return timeChanges;
+  }
+
+  // Número de transacciones I2C hechas con el DS3231 desde el arranque
+  uint32_t getI2CTransactionCount() {
+    return ds3231.getTransactionCount();
   }
 
   // Mostrar la hora actual en formato legible
   void displayCurrentTime() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     displayTime(currentTime);
   }
 
   // Mostrar una hora específica en formato legible
   void displayTime(DateTime time) {
-    Serial.print("Hora actual: ");
+    Serial.print(F("Hora actual: "));
     printTwoDigits(time.hour());
-    Serial.print(":");
+    Serial.print(F(":"));
     printTwoDigits(time.minute());
-    Serial.print(":");
+    Serial.print(F(":"));
     printTwoDigits(time.second());
-    Serial.print(" - ");
+    Serial.print(F(" - "));
     Serial.print(time.day());
-    Serial.print("/");
+    Serial.print(F("/"));
     Serial.print(time.month());
-    Serial.print("/");
+    Serial.print(F("/"));
     Serial.println(time.year());
   }
 
@@ -72,7 +553,7 @@ public:
 
   // Verificar si es una hora y minuto específicos (segundo = 0)
   bool isExactTime(int hour, int minute) {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     return (currentTime.hour() == hour && 
             currentTime.minute() == minute && 
             currentTime.second() == 0);
@@ -80,88 +561,88 @@ public:
 
   // Verificar si estamos en un minuto específico
   bool isInMinute(int hour, int minute) {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     return (currentTime.hour() == hour && currentTime.minute() == minute);
   }
 
   // Configurar fecha y hora manualmente
   void setDateTime(int year, int month, int day, int hour, int minute, int second) {
-    rtc.adjust(DateTime(year, month, day, hour, minute, second));
+    writeRTC(DateTime(year, month, day, hour, minute, second));
   }
 
   // Obtener componentes individuales del tiempo
   int getCurrentHour() {
-    return rtc.now().hour();
+    return now().hour();
   }
 
   int getCurrentMinute() {
-    return rtc.now().minute();
+    return now().minute();
   }
 
   int getCurrentSecond() {
-    return rtc.now().second();
+    return now().second();
   }
 
   int getCurrentDay() {
-    return rtc.now().day();
+    return now().day();
   }
 
   int getCurrentMonth() {
-    return rtc.now().month();
+    return now().month();
   }
 
   int getCurrentYear() {
-    return rtc.now().year();
+    return now().year();
   }
 
   // === FUNCIONES PARA AJUSTE CON BOTONES ===
-  
+
   // Configurar solo la hora (mantiene fecha actual)
   void setTime(int hour, int minute, int second = 0) {
-    DateTime currentTime = rtc.now();
-    rtc.adjust(DateTime(currentTime.year(), currentTime.month(), currentTime.day(), 
-                       hour, minute, second));
+    // Solo los registros de hora: la fecha del DS3231 no se toca
+    ds3231.writeTime(hour, minute, second);
+    DateTime currentTime = now();
+    timeWritten(DateTime(currentTime.year(), currentTime.month(), currentTime.day(), 
+                         hour, minute, second));
     
-    Serial.print("Hora ajustada a: ");
+    Serial.print(F("Hora ajustada a: "));
     printTwoDigits(hour);
-    Serial.print(":");
+    Serial.print(F(":"));
     printTwoDigits(minute);
-    Serial.print(":");
+    Serial.print(F(":"));
     printTwoDigits(second);
     Serial.println();
   }
 
   // Configurar solo la fecha (mantiene hora actual)
   void setDate(int year, int month, int day) {
-    DateTime currentTime = rtc.now();
-    rtc.adjust(DateTime(year, month, day, 
-                       currentTime.hour(), currentTime.minute(), currentTime.second()));
+    writeDate(DateTime(year, month, day));
     
-    Serial.print("Fecha ajustada a: ");
+    Serial.print(F("Fecha ajustada a: "));
     Serial.print(day);
-    Serial.print("/");
+    Serial.print(F("/"));
     Serial.print(month);
-    Serial.print("/");
+    Serial.print(F("/"));
     Serial.println(year);
   }
 
   // Incrementar hora (con rollover)
   void incrementHour() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     int newHour = (currentTime.hour() + 1) % 24;
     setTime(newHour, currentTime.minute(), currentTime.second());
   }
 
   // Decrementar hora (con rollover)
   void decrementHour() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     int newHour = (currentTime.hour() - 1 + 24) % 24;
     setTime(newHour, currentTime.minute(), currentTime.second());
   }
 
   // Incrementar minuto (con rollover)
   void incrementMinute() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     int newMinute = (currentTime.minute() + 1) % 60;
     int newHour = currentTime.hour();
     
@@ -175,7 +656,7 @@ public:
 
   // Decrementar minuto (con rollover)
   void decrementMinute() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     int newMinute = (currentTime.minute() - 1 + 60) % 60;
     int newHour = currentTime.hour();
     
@@ -189,25 +670,21 @@ public:
 
   // Incrementar día (con validación de mes/año)
   void incrementDay() {
-    DateTime currentTime = rtc.now();
-    DateTime newTime = DateTime(currentTime.year(), currentTime.month(), currentTime.day() + 1,
-                               currentTime.hour(), currentTime.minute(), currentTime.second());
-    rtc.adjust(newTime);
-    Serial.println("Día incrementado");
+    DateTime currentTime = now();
+    writeDate(DateTime(currentTime.year(), currentTime.month(), currentTime.day() + 1));
+    Serial.println(F("Día incrementado"));
   }
 
   // Decrementar día (con validación de mes/año)
   void decrementDay() {
-    DateTime currentTime = rtc.now();
-    DateTime newTime = DateTime(currentTime.year(), currentTime.month(), currentTime.day() - 1,
-                               currentTime.hour(), currentTime.minute(), currentTime.second());
-    rtc.adjust(newTime);
-    Serial.println("Día decrementado");
+    DateTime currentTime = now();
+    writeDate(DateTime(currentTime.year(), currentTime.month(), currentTime.day() - 1));
+    Serial.println(F("Día decrementado"));
   }
 
   // Incrementar mes
   void incrementMonth() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     int newMonth = currentTime.month() + 1;
     int newYear = currentTime.year();
     
@@ -221,7 +698,7 @@ public:
 
   // Decrementar mes
   void decrementMonth() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     int newMonth = currentTime.month() - 1;
     int newYear = currentTime.year();
     
@@ -235,13 +712,13 @@ public:
 
   // Incrementar año
   void incrementYear() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     setDate(currentTime.year() + 1, currentTime.month(), currentTime.day());
   }
 
   // Decrementar año
   void decrementYear() {
-    DateTime currentTime = rtc.now();
+    DateTime currentTime = now();
     setDate(currentTime.year() - 1, currentTime.month(), currentTime.day());
   }
 
@@ -271,7 +748,7 @@ private:
   // Función auxiliar para imprimir números con dos dígitos
   void printTwoDigits(int number) {
     if (number < 10) {
-      Serial.print("0");
+      Serial.print(F("0"));
     }
     Serial.print(number);
   }
@@ -3,6 +3,23 @@
   
   Este módulo maneja todos los horarios programables de alimentación,
   incluyendo configuración, verificación y persistencia.
+
+  Cada horario ocupa 3 bytes: minuto del día (11 bits), relays que
+  alimenta (4 bits) y bandera de habilitado, más la duración en
+  segundos. Un horario sin relays está libre. Los minutos con algún horario habilitado se
+  marcan en un mapa de 1440 bits, que hace de línea de tiempo ordenada:
+  saber si hay un horario en un minuto es probar un bit, y el próximo
+  disparo (segundos Unix) se busca recorriendo el mapa. El mapa y el
+  próximo disparo solo se recalculan al cambiar un horario o al ajustar
+  la hora del RTC; en cada tick basta con comparar la hora actual con el
+  próximo disparo. Con la alarma del DS3231 el disparo llega por
+  checkAlarm() y esa comparación solo cubre una alarma que no llegó.
+
+  Los horarios se guardan en la EEPROM con EEPROMManager (registro con
+  CRC en un anillo de ranuras) y se cargan en begin(). save() solo encola
+  la escritura; update() debe llamarse en cada pasada del loop. Un
+  registro de la versión 1 (sin relays ni duración) se convierte al
+  arrancar: todos los relays y FEED_DURATION.
 */
 
 #ifndef SCHEDULE_MANAGER_H
@@ -10,54 +27,150 @@
 
 #include "config.h"
 #include "rtc_manager.h"
+#include "eeprom_manager.h"
+
+const uint16_t SCHEDULE_V1_FLAG_SET = 0x4000;   // Horario configurado en el registro de la versión 1
+
+// Registro que se guarda en la EEPROM
+struct ScheduleRecord {
+  uint16_t schedules[MAX_FEED_TIMES];   // Empaquetados (ver SCHEDULE_MINUTE_MASK en config.h)
+  uint8_t durations[MAX_FEED_TIMES];    // Duración de cada horario (segundos)
+};
 
 class ScheduleManager {
 private:
-  FeedTime feedTimes[MAX_FEED_TIMES];
-  bool lastFeedStatus[MAX_FEED_TIMES];
+  // Horarios y duraciones
+  ScheduleRecord record;
+
+  // Mapa de minutos del día con algún horario habilitado
+  uint8_t minuteBitmap[MINUTES_PER_DAY / 8];
+
+  // Próximo disparo precalculado
+  uint32_t nextFireEpoch;          // Inicio del minuto del próximo horario
+  int nextFireSchedule;            // Número de horario (1-MAX_FEED_TIMES) o -1
+  uint32_t lastFiredEpoch;         // Minuto del último disparo (no repetirlo)
+  uint32_t lastCheckEpoch;         // Para detectar saltos hacia atrás
+  unsigned int seenTimeChanges;    // Ajustes de hora ya tenidos en cuenta
+  bool nextFireValid;
+  bool nextFireDirty;              // Hay que recalcular el próximo disparo
+
+  // Persistencia
+  EEPROMManager store;
 
 public:
   // Constructor
-  ScheduleManager() {
-    // Inicializar horarios predeterminados
-    feedTimes[0] = {DEFAULT_SCHEDULE_1_HOUR, DEFAULT_SCHEDULE_1_MINUTE, DEFAULT_SCHEDULE_1_ENABLED};
-    feedTimes[1] = {DEFAULT_SCHEDULE_2_HOUR, DEFAULT_SCHEDULE_2_MINUTE, DEFAULT_SCHEDULE_2_ENABLED};
-    feedTimes[2] = {DEFAULT_SCHEDULE_3_HOUR, DEFAULT_SCHEDULE_3_MINUTE, DEFAULT_SCHEDULE_3_ENABLED};
-    feedTimes[3] = {DEFAULT_SCHEDULE_4_HOUR, DEFAULT_SCHEDULE_4_MINUTE, DEFAULT_SCHEDULE_4_ENABLED};
-    
-    // Inicializar estados
+  ScheduleManager() : nextFireEpoch(0), nextFireSchedule(-1), lastFiredEpoch(0),
+                      lastCheckEpoch(0), seenTimeChanges(0), nextFireValid(false),
+                      nextFireDirty(true),
+                      store(EEPROM_SCHEDULE_START, EEPROM_STORE_SIZE) {
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      lastFeedStatus[i] = false;
+      record.schedules[i] = 0;
+      record.durations[i] = FEED_DURATION;
     }
+    
+    // Inicializar horarios predeterminados (todos los relays)
+    record.schedules[0] = pack(DEFAULT_SCHEDULE_1_HOUR, DEFAULT_SCHEDULE_1_MINUTE, RELAY_ALL, DEFAULT_SCHEDULE_1_ENABLED);
+    record.schedules[1] = pack(DEFAULT_SCHEDULE_2_HOUR, DEFAULT_SCHEDULE_2_MINUTE, RELAY_ALL, DEFAULT_SCHEDULE_2_ENABLED);
+    record.schedules[2] = pack(DEFAULT_SCHEDULE_3_HOUR, DEFAULT_SCHEDULE_3_MINUTE, RELAY_ALL, DEFAULT_SCHEDULE_3_ENABLED);
+    record.schedules[3] = pack(DEFAULT_SCHEDULE_4_HOUR, DEFAULT_SCHEDULE_4_MINUTE, RELAY_ALL, DEFAULT_SCHEDULE_4_ENABLED);
+    
+    rebuildBitmap();
   }
 
   // Inicializar el gestor de horarios
   void begin() {
-    // Cargar horarios desde EEPROM si están disponibles
-    // Por ahora usar los valores predeterminados
+    // Cargar horarios desde EEPROM si hay un registro válido;
+    // si no, quedan los valores predeterminados
+    if (store.load((uint8_t*)&record, sizeof(record))) {
+      for (int i = 0; i < MAX_FEED_TIMES; i++) {
+        if ((record.schedules[i] & SCHEDULE_MINUTE_MASK) >= MINUTES_PER_DAY) {
+          record.schedules[i] = 0;
+        }
+        if (record.durations[i] < MIN_FEED_DURATION || record.durations[i] > MAX_FEED_DURATION) {
+          record.durations[i] = FEED_DURATION;
+        }
+      }
+    } else if (store.load((uint8_t*)record.schedules, sizeof(record.schedules), 1)) {
+      // Registro de la versión 1: los horarios configurados pasan a todos
+      // los relays (las duraciones quedan en FEED_DURATION) y se guarda
+      // en el formato actual, sin pisar el registro viejo
+      for (int i = 0; i < MAX_FEED_TIMES; i++) {
+        uint16_t entry = record.schedules[i];
+        bool valid = (entry & SCHEDULE_V1_FLAG_SET) && (entry & SCHEDULE_MINUTE_MASK) < MINUTES_PER_DAY;
+        record.schedules[i] = valid ? (entry & (SCHEDULE_MINUTE_MASK | SCHEDULE_FLAG_ENABLED)) | relayBits(RELAY_ALL) : 0;
+      }
+      store.startCurrentFormat(sizeof(record));
+      save();
+    }
+    schedulesChanged();
   }
 
-  // Verificar si es momento de alimentar y retornar el número de horario (1-4) o 0 si no
+  // Guardar los horarios en la EEPROM (solo escribe si cambiaron).
+  // Retorna enseguida: la escritura sigue en segundo plano.
+  bool save() {
+    return store.save((const uint8_t*)&record);
+  }
+
+  // Atender guardados pendientes (llamar en cada pasada del loop)
+  void update() {
+    store.update();
+  }
+
+  // Acceso al almacenamiento para mostrar su estado
+  EEPROMManager& getStore() {
+    return store;
+  }
+
+  // Verificar si es momento de alimentar y retornar el número de horario o 0 si no
   int checkFeedTime(RTCManager& rtcManager) {
-    for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      if (!feedTimes[i].enabled) continue;
-      
-      // Verificar si estamos en el minuto correcto (más flexible que segundo exacto)
-      bool shouldFeed = rtcManager.isInMinute(feedTimes[i].hour, feedTimes[i].minute);
-      
-      // Activar alimentación solo una vez por minuto
-      if (shouldFeed && !lastFeedStatus[i]) {
-        updateLastFeedStatus(rtcManager);
-        return i + 1; // Retornar número de horario (1-4)
-      }
+    uint32_t epoch = syncNextFire(rtcManager);
+    
+    // Caso normal: todavía no llegó el próximo horario
+    if (!nextFireValid || epoch < nextFireEpoch) {
+      return 0;
+    }
+    
+    // Con la alarma del DS3231 disparar solo si no sonó a tiempo
+    if (rtcManager.isAlarmEnabled() && epoch < nextFireEpoch + RTC_ALARM_GRACE) {
+      return 0;
     }
     
-    // Actualizar estados sin activar alimentación
-    updateLastFeedStatus(rtcManager);
-    return 0; // No hay horario que activar
+    // Dentro del minuto programado: disparar una sola vez y pasar al siguiente
+    int schedule = nextFireSchedule;
+    lastFiredEpoch = nextFireEpoch;
+    computeNextFire(epoch);
+    return schedule;
   }
 
-  // Configurar un horario específico
+  // Sonó la alarma 1 del DS3231 (programada con el próximo disparo):
+  // retorna ese horario y pasa al siguiente, o 0 si la alarma no
+  // corresponde a ningún horario. El reloj por millis() puede ir algo
+  // atrasado respecto de la alarma: vale hasta un minuto antes
+  int checkAlarm(RTCManager& rtcManager) {
+    uint32_t epoch = syncNextFire(rtcManager);
+    if (!nextFireValid || epoch + 60 < nextFireEpoch) {
+      return 0;
+    }
+    
+    int schedule = nextFireSchedule;
+    lastFiredEpoch = nextFireEpoch;
+    computeNextFire(nextFireEpoch);
+    return schedule;
+  }
+
+  // Segundos Unix del próximo disparo (0 si no hay horarios habilitados)
+  uint32_t getNextFireEpoch(RTCManager& rtcManager) {
+    syncNextFire(rtcManager);
+    return nextFireValid ? nextFireEpoch : 0;
+  }
+
+  // Verificar si algún horario habilitado cae en un minuto del día (0-1439)
+  bool isMinuteScheduled(int minuteOfDay) {
+    return minuteBitmap[minuteOfDay >> 3] & (1 << (minuteOfDay & 7));
+  }
+
+  // Configurar un horario específico (queda habilitado). Conserva los
+  // relays de un horario configurado; uno libre alimenta todos los relays
   bool setSchedule(int scheduleNumber, int hour, int minute) {
     if (scheduleNumber < 1 || scheduleNumber > MAX_FEED_TIMES) {
       return false;
@@ -67,67 +180,123 @@ public:
       return false;
     }
     
-    int index = scheduleNumber - 1;
-    feedTimes[index].hour = hour;
-    feedTimes[index].minute = minute;
-    feedTimes[index].enabled = true;
+    uint16_t& entry = record.schedules[scheduleNumber - 1];
+    uint8_t relays = (entry & SCHEDULE_RELAY_MASK) ? relaysOf(entry) : RELAY_ALL;
+    entry = pack(hour, minute, relays, true);
+    schedulesChanged();
+    
+    return true;
+  }
+
+  // Elegir relays (1-RELAY_ALL) y duración en segundos de un horario configurado
+  bool setScheduleDose(int scheduleNumber, uint8_t relays, int duration) {
+    if (!isScheduleConfigured(scheduleNumber)) {
+      return false;
+    }
+    
+    if (relays == 0 || (relays & ~RELAY_ALL) || duration < MIN_FEED_DURATION || duration > MAX_FEED_DURATION) {
+      return false;
+    }
     
+    uint16_t& entry = record.schedules[scheduleNumber - 1];
+    entry = (entry & ~SCHEDULE_RELAY_MASK) | relayBits(relays);
+    record.durations[scheduleNumber - 1] = duration;
     return true;
   }
 
-  // Habilitar o deshabilitar un horario
+  // Habilitar o deshabilitar un horario (solo se habilitan horarios configurados)
   bool enableSchedule(int scheduleNumber, bool enabled) {
     if (scheduleNumber < 1 || scheduleNumber > MAX_FEED_TIMES) {
       return false;
     }
     
-    feedTimes[scheduleNumber - 1].enabled = enabled;
+    uint16_t& entry = record.schedules[scheduleNumber - 1];
+    if (enabled) {
+      if (!(entry & SCHEDULE_RELAY_MASK)) {
+        return false;
+      }
+      entry |= SCHEDULE_FLAG_ENABLED;
+    } else {
+      entry &= ~SCHEDULE_FLAG_ENABLED;
+    }
+    schedulesChanged();
     return true;
   }
 
   // Obtener información de un horario específico
   FeedTime getSchedule(int scheduleNumber) {
     if (scheduleNumber < 1 || scheduleNumber > MAX_FEED_TIMES) {
-      return {-1, -1, false}; // Horario inválido
+      return {-1, -1, false, 0, 0}; // Horario inválido
     }
     
-    return feedTimes[scheduleNumber - 1];
+    uint16_t entry = record.schedules[scheduleNumber - 1];
+    int minuteOfDay = entry & SCHEDULE_MINUTE_MASK;
+    return {minuteOfDay / 60, minuteOfDay % 60, (entry & SCHEDULE_FLAG_ENABLED) != 0,
+            relaysOf(entry), record.durations[scheduleNumber - 1]};
+  }
+
+  // Verificar si un horario tiene hora asignada
+  bool isScheduleConfigured(int scheduleNumber) {
+    if (scheduleNumber < 1 || scheduleNumber > MAX_FEED_TIMES) {
+      return false;
+    }
+    return record.schedules[scheduleNumber - 1] & SCHEDULE_RELAY_MASK;
+  }
+
+  // Siguiente horario habilitado en el mismo minuto que scheduleNumber, o 0.
+  // checkFeedTime() retorna el primero de cada minuto; los demás se
+  // recorren con esta función
+  int getNextScheduleSameMinute(int scheduleNumber) {
+    if (scheduleNumber < 1 || scheduleNumber > MAX_FEED_TIMES) {
+      return 0;
+    }
+    int next = findScheduleAt(record.schedules[scheduleNumber - 1] & SCHEDULE_MINUTE_MASK, scheduleNumber);
+    return next > 0 ? next : 0;
   }
 
   // Mostrar todos los horarios programados
   void displaySchedules() {
-    Serial.println("\n=== Horarios Programados ===");
+    Serial.println(F("\n=== Horarios Programados ==="));
+    int configured = 0;
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      Serial.print("Horario ");
-      Serial.print(i + 1);
-      Serial.print(": ");
+      if (!(record.schedules[i] & SCHEDULE_RELAY_MASK)) continue;
+      configured++;
       
-      if (feedTimes[i].enabled) {
-        printTwoDigits(feedTimes[i].hour);
-        Serial.print(":");
-        printTwoDigits(feedTimes[i].minute);
-        Serial.println(" (Habilitado)");
-      } else {
-        Serial.println("Deshabilitado");
-      }
+      FeedTime schedule = getSchedule(i + 1);
+      Serial.print(F("Horario "));
+      Serial.print(i + 1);
+      Serial.print(F(": "));
+      printTwoDigits(schedule.hour);
+      Serial.print(F(":"));
+      printTwoDigits(schedule.minute);
+      Serial.print(schedule.enabled ? F(" (Habilitado) ") : F(" (Deshabilitado) "));
+      printRelays(schedule.relays);
+      Serial.print(F(" "));
+      Serial.print(schedule.duration);
+      Serial.println(F(" s"));
+    }
+    if (configured == 0) {
+      Serial.println(F(MSG_NO_SCHEDULES));
     }
-    Serial.print("Duración: ");
-    Serial.print(FEED_DURATION);
-    Serial.println(" segundos");
-    Serial.println("============================\n");
+    Serial.print(F("Libres: "));
+    Serial.print(MAX_FEED_TIMES - configured);
+    Serial.print(F("/"));
+    Serial.println(MAX_FEED_TIMES);
+    Serial.println(F("============================\n"));
   }
 
   // Mostrar horarios de forma compacta (para inicio del sistema)
   void displaySchedulesCompact() {
-    Serial.println("Horarios programados:");
+    Serial.println(F("Horarios programados:"));
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      if (feedTimes[i].enabled) {
-        Serial.print("Horario ");
+      if (record.schedules[i] & SCHEDULE_FLAG_ENABLED) {
+        FeedTime schedule = getSchedule(i + 1);
+        Serial.print(F("Horario "));
         Serial.print(i + 1);
-        Serial.print(": ");
-        printTwoDigits(feedTimes[i].hour);
-        Serial.print(":");
-        printTwoDigits(feedTimes[i].minute);
+        Serial.print(F(": "));
+        printTwoDigits(schedule.hour);
+        Serial.print(F(":"));
+        printTwoDigits(schedule.minute);
         Serial.println();
       }
     }
@@ -136,7 +305,7 @@ public:
   // Verificar si algún horario está habilitado
   bool hasEnabledSchedules() {
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      if (feedTimes[i].enabled) {
+      if (record.schedules[i] & SCHEDULE_FLAG_ENABLED) {
         return true;
       }
     }
@@ -147,67 +316,157 @@ public:
   int getEnabledSchedulesCount() {
     int count = 0;
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      if (feedTimes[i].enabled) {
+      if (record.schedules[i] & SCHEDULE_FLAG_ENABLED) {
         count++;
       }
     }
     return count;
   }
 
-  // Obtener el próximo horario de alimentación
+  // Obtener el próximo horario de alimentación (precalculado)
   int getNextSchedule(RTCManager& rtcManager) {
-    DateTime now = rtcManager.now();
-    int currentMinutes = now.hour() * 60 + now.minute();
-    int nextSchedule = -1;
-    int minDifference = 24 * 60; // Un día completo en minutos
-    
-    for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      if (!feedTimes[i].enabled) continue;
-      
-      int scheduleMinutes = feedTimes[i].hour * 60 + feedTimes[i].minute;
-      int difference;
-      
-      if (scheduleMinutes > currentMinutes) {
-        difference = scheduleMinutes - currentMinutes;
-      } else {
-        difference = (24 * 60) - currentMinutes + scheduleMinutes; // Próximo día
-      }
-      
-      if (difference < minDifference) {
-        minDifference = difference;
-        nextSchedule = i + 1;
-      }
-    }
-    
-    return nextSchedule;
+    syncNextFire(rtcManager);
+    return nextFireSchedule;
   }
 
   // Deshabilitar todos los horarios
   void disableAllSchedules() {
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      feedTimes[i].enabled = false;
+      record.schedules[i] &= ~SCHEDULE_FLAG_ENABLED;
     }
+    schedulesChanged();
   }
 
-  // Habilitar todos los horarios
+  // Habilitar todos los horarios configurados
   void enableAllSchedules() {
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      feedTimes[i].enabled = true;
+      if (record.schedules[i] & SCHEDULE_RELAY_MASK) {
+        record.schedules[i] |= SCHEDULE_FLAG_ENABLED;
+      }
     }
+    schedulesChanged();
   }
 
 private:
-  // Actualizar estado del último minuto para todos los horarios
-  void updateLastFeedStatus(RTCManager& rtcManager) {
+  // Empaquetar hora, minuto y relays en una entrada configurada
+  static uint16_t pack(int hour, int minute, uint8_t relays, bool enabled) {
+    uint16_t entry = (uint16_t)(hour * 60 + minute) | relayBits(relays);
+    if (enabled) {
+      entry |= SCHEDULE_FLAG_ENABLED;
+    }
+    return entry;
+  }
+
+  static uint16_t relayBits(uint8_t relays) {
+    return (uint16_t)(relays & RELAY_ALL) << SCHEDULE_RELAY_SHIFT;
+  }
+
+  static uint8_t relaysOf(uint16_t entry) {
+    return (entry & SCHEDULE_RELAY_MASK) >> SCHEDULE_RELAY_SHIFT;
+  }
+
+  // Un horario cambió: rehacer el mapa y recalcular el próximo disparo
+  void schedulesChanged() {
+    rebuildBitmap();
+    nextFireDirty = true;
+  }
+
+  // Reconstruir el mapa de minutos a partir de los horarios habilitados
+  void rebuildBitmap() {
+    for (int i = 0; i < MINUTES_PER_DAY / 8; i++) {
+      minuteBitmap[i] = 0;
+    }
     for (int i = 0; i < MAX_FEED_TIMES; i++) {
-      lastFeedStatus[i] = rtcManager.isInMinute(feedTimes[i].hour, feedTimes[i].minute);
+      if (!(record.schedules[i] & SCHEDULE_FLAG_ENABLED)) continue;
+      int minuteOfDay = record.schedules[i] & SCHEDULE_MINUTE_MASK;
+      minuteBitmap[minuteOfDay >> 3] |= 1 << (minuteOfDay & 7);
+    }
+  }
+
+  // Primer horario habilitado en un minuto del día, a partir del índice first
+  int findScheduleAt(int minuteOfDay, int first = 0) {
+    for (int i = first; i < MAX_FEED_TIMES; i++) {
+      if ((record.schedules[i] & SCHEDULE_FLAG_ENABLED) &&
+          (record.schedules[i] & SCHEDULE_MINUTE_MASK) == minuteOfDay) {
+        return i + 1;
+      }
+    }
+    return -1;
+  }
+
+  // Calcular el próximo disparo a partir de la hora dada.
+  // El minuto en curso cuenta si todavía no se disparó (como al arrancar
+  // dentro de un minuto programado).
+  void computeNextFire(uint32_t epoch) {
+    nextFireValid = false;
+    nextFireSchedule = -1;
+    
+    uint32_t currentMinuteStart = epoch - epoch % 60UL;
+    int currentMinute = (epoch % 86400UL) / 60;
+    
+    // Recorrer un día completo más el minuto actual de mañana,
+    // saltando de a 8 minutos los bytes vacíos del mapa
+    int offset = 0;
+    while (offset <= MINUTES_PER_DAY) {
+      int minute = (currentMinute + offset) % MINUTES_PER_DAY;
+      if ((minute & 7) == 0 && minuteBitmap[minute >> 3] == 0) {
+        offset += 8;
+        continue;
+      }
+      
+      if (isMinuteScheduled(minute)) {
+        uint32_t candidate = currentMinuteStart + offset * 60UL;
+        if (candidate != lastFiredEpoch) {
+          nextFireEpoch = candidate;
+          nextFireSchedule = findScheduleAt(minute);
+          nextFireValid = true;
+          return;
+        }
+      }
+      offset++;
+    }
+  }
+
+  // Mantener el próximo disparo al día; retorna la hora actual
+  uint32_t syncNextFire(RTCManager& rtcManager) {
+    uint32_t epoch = rtcManager.getEpoch();
+    bool recompute = false;
+    
+    if (nextFireDirty) {
+      nextFireDirty = false;
+      recompute = true;
+    }
+    
+    // Hora ajustada o salto hacia atrás
+    if (rtcManager.getTimeChangeCount() != seenTimeChanges || epoch < lastCheckEpoch) {
+      seenTimeChanges = rtcManager.getTimeChangeCount();
+      recompute = true;
+    }
+    
+    // El minuto programado terminó sin consultarse (p.ej. alimentación en curso)
+    if (nextFireValid && epoch >= nextFireEpoch + 60) {
+      recompute = true;
+    }
+    
+    if (recompute) {
+      computeNextFire(epoch);
+    }
+    lastCheckEpoch = epoch;
+    return epoch;
+  }
+
+  // Relays de un horario como "R1-3-" (guion = relay sin usar)
+  void printRelays(uint8_t relays) {
+    Serial.print(F("R"));
+    for (uint8_t i = 0; i < RELAY_CHANNELS; i++) {
+      Serial.print(relays & (1 << i) ? (char)('1' + i) : '-');
     }
   }
 
   // Función auxiliar para imprimir números con dos dígitos
   void printTwoDigits(int number) {
     if (number < 10) {
-      Serial.print("0");
+      Serial.print(F("0"));
     }
     Serial.print(number);
   }
@@ -3,6 +3,14 @@
   
   Este módulo maneja todos los comandos que se pueden enviar
   a través del monitor serial para controlar el sistema.
+
+  Las pruebas ("test relay", "test led") no detienen el loop: el
+  RelayController las avanza en su update() y processCommands() avisa
+  cuando terminan, así que los horarios y "stop" siguen atendiéndose.
+
+  "feed" pasa por la FeedQueue como el botón y los horarios. Los
+  comandos de diagnóstico del sketch (power, prof, tasks) llegan al
+  manejador que se pasa al constructor.
 */
 
 #ifndef SERIAL_COMMANDS_H
@@ -12,29 +20,71 @@
 #include "rtc_manager.h"
 #include "relay_controller.h"
 #include "schedule_manager.h"
+#include "feed_queue.h"
+#include "coroutine.h"
+
+// Comandos que atiende el sketch: retorna true si conocía el comando
+typedef bool (*SerialCommandHandler)(const char* command);
 
 class SerialCommands {
 private:
   RTCManager* rtcManager;
   RelayController* relayController;
   ScheduleManager* scheduleManager;
+  FeedQueue* feedQueue;
+  SerialCommandHandler extraCommands;
+
+  // Línea en curso: se arma con lo que llega sin esperar el fin de línea
+  char line[SERIAL_COMMAND_SIZE + 1];
+  uint8_t lineLength;
+
+  // Prueba en curso ("test relay" o "test led")
+  Coroutine testTask;
+  bool testingRelay;
 
 public:
   // Constructor
-  SerialCommands(RTCManager* rtc, RelayController* relay, ScheduleManager* schedule) 
-    : rtcManager(rtc), relayController(relay), scheduleManager(schedule) {}
+  SerialCommands(RTCManager* rtc, RelayController* relay, ScheduleManager* schedule,
+                 FeedQueue* queue, SerialCommandHandler extra = 0)
+    : rtcManager(rtc), relayController(relay), scheduleManager(schedule), feedQueue(queue),
+      extraCommands(extra), lineLength(0), testingRelay(false) {}
 
   // Inicializar comandos seriales
   void begin() {
-    Serial.println("Comandos seriales inicializados");
-    Serial.println("Escribe 'help' para ver comandos disponibles");
+    Serial.println(F("Comandos seriales inicializados"));
+    Serial.println(F("Escribe 'help' para ver comandos disponibles"));
+  }
+
+  // Hay caracteres por leer o una prueba que avisar
+  bool isPending() {
+    return Serial.available() || testTask.isRunning();
   }
 
-  // Procesar comandos seriales disponibles
+  // Procesar comandos seriales disponibles (retorna sin esperar el fin de línea)
   void processCommands() {
-    if (!Serial.available()) return;
+    // Guardados de horarios pendientes en EEPROM
+    scheduleManager->update();
+    
+    // Avisar cuando termina la prueba en curso
+    if (testTask.isRunning()) runTestCommand();
     
-    String command = Serial.readStringUntil('\n');
+    while (Serial.available()) {
+      char c = Serial.read();
+      if (c != '\n' && c != '\r') {
+        if (lineLength < SERIAL_COMMAND_SIZE) line[lineLength++] = c;   // Lo que sobra se descarta
+        continue;
+      }
+      if (lineLength == 0) continue;
+      line[lineLength] = 0;
+      lineLength = 0;
+      runCommand(line);
+    }
+  }
+    
+private:
+  // Ejecutar una línea completa
+  void runCommand(const char* text) {
+    String command(text);
     command.trim();
     command.toLowerCase(); // Convertir a minúsculas para facilitar comparación
     
@@ -49,111 +99,157 @@ public:
       scheduleManager->displaySchedules();
     }
     else if (command == "feed") {
-      if (!relayController->isFeedingActive()) {
-        relayController->startFeeding(0); // Alimentación manual
+      // Alimentación manual: misma cola que el botón y los horarios
+      FeedResult result = feedQueue->submit(FEED_SOURCE_SERIAL, RELAY_ALL);
+      if (result == FEED_STARTED) {
+        Serial.println(F(MSG_FEED_MANUAL));
+      } else if (result == FEED_QUEUED) {
+        Serial.println(F(MSG_FEED_QUEUED));
+      } else if (result == FEED_MERGED) {
+        Serial.println(F(MSG_FEED_MERGED));
       } else {
-        Serial.println(MSG_ALREADY_FEEDING);
+        Serial.println(F(MSG_FEED_REJECTED));
       }
     }
+    else if (command == "queue") {
+      feedQueue->displayQueue();
+    }
     else if (command == "status") {
       showSystemStatus();
     }
     else if (command == "stop") {
+      testTask.stop();
+      feedQueue->clear();
       relayController->emergencyStop();
+      Serial.println(F(MSG_FEED_STOPPED));
     }
     else if (command == "next") {
       showNextSchedule();
     }
     else if (command.startsWith("set")) {
       processSetCommand(command);
+      scheduleManager->save();
     }
     else if (command.startsWith("enable")) {
       processEnableCommand(command);
+      scheduleManager->save();
     }
     else if (command.startsWith("disable")) {
       processDisableCommand(command);
+      scheduleManager->save();
     }
     else if (command.startsWith("test")) {
       processTestCommand(command);
     }
-    else if (command != "") { // Solo mostrar error si no es comando vacío
-      Serial.println(MSG_UNKNOWN_COMMAND);
+    else if (command != "" && !(extraCommands && extraCommands(command.c_str()))) {
+      Serial.println(F(MSG_UNKNOWN_COMMAND));
     }
   }
 
-private:
   // Mostrar ayuda con todos los comandos disponibles
   void showHelp() {
-    Serial.println("\n=== Comandos Disponibles ===");
-    Serial.println("help o ? - Mostrar esta ayuda");
-    Serial.println("time - Mostrar hora actual");
-    Serial.println("schedules - Mostrar horarios programados");
-    Serial.println("status - Mostrar estado del sistema");
-    Serial.println("feed - Alimentar manualmente");
-    Serial.println("stop - Parada de emergencia");
-    Serial.println("next - Mostrar próximo horario");
-    Serial.println("");
-    Serial.println("=== Configuración de Horarios ===");
-    Serial.println("set X HH:MM - Configurar horario X (1-4) a HH:MM");
-    Serial.println("set X off - Deshabilitar horario X");
-    Serial.println("enable X - Habilitar horario X");
-    Serial.println("disable X - Deshabilitar horario X");
-    Serial.println("enable all - Habilitar todos los horarios");
-    Serial.println("disable all - Deshabilitar todos los horarios");
-    Serial.println("");
-    Serial.println("=== Comandos de Prueba ===");
-    Serial.println("test relay - Probar relay (3 segundos)");
-    Serial.println("test led - Probar LED (parpadeo)");
-    Serial.println("");
-    Serial.println("Ejemplos:");
-    Serial.println("  set 1 07:30  (horario 1 a las 7:30)");
-    Serial.println("  disable 2    (deshabilitar horario 2)");
-    Serial.println("============================\n");
+    Serial.println(F("\n=== Comandos Disponibles ==="));
+    Serial.println(F("help o ? - Mostrar esta ayuda"));
+    Serial.println(F("time - Mostrar hora actual"));
+    Serial.println(F("schedules - Mostrar horarios programados"));
+    Serial.println(F("status - Mostrar estado del sistema"));
+    Serial.println(F("feed - Alimentar manualmente"));
+    Serial.println(F("stop - Parada de emergencia"));
+    Serial.println(F("next - Mostrar próximo horario"));
+    Serial.println(F(MSG_COMMAND_QUEUE));
+    if (extraCommands) {
+      Serial.println(F(MSG_COMMAND_POWER));
+      Serial.println(F(MSG_COMMAND_PROF));
+      Serial.println(F(MSG_COMMAND_TASKS));
+    }
+    Serial.println();
+    Serial.println(F("=== Configuración de Horarios ==="));
+    Serial.print(F("set X HH:MM - Configurar horario X (1-"));
+    Serial.print(MAX_FEED_TIMES);
+    Serial.println(F(") a HH:MM"));
+    Serial.println(F("set X off - Deshabilitar horario X"));
+    Serial.println(F("enable X - Habilitar horario X"));
+    Serial.println(F("disable X - Deshabilitar horario X"));
+    Serial.println(F("enable all - Habilitar todos los horarios"));
+    Serial.println(F("disable all - Deshabilitar todos los horarios"));
+    Serial.println();
+    Serial.println(F("=== Comandos de Prueba ==="));
+    Serial.println(F("test relay - Probar relay (3 segundos)"));
+    Serial.println(F("test led - Probar LED (parpadeo)"));
+    Serial.println();
+    Serial.println(F("Ejemplos:"));
+    Serial.println(F("  set 1 07:30  (horario 1 a las 7:30)"));
+    Serial.println(F("  disable 2    (deshabilitar horario 2)"));
+    Serial.println(F("============================\n"));
   }
 
   // Mostrar estado completo del sistema
   void showSystemStatus() {
-    Serial.println("\n=== Estado del Sistema ===");
+    Serial.println(F("\n=== Estado del Sistema ==="));
     
-    // Hora actual
-    Serial.print("Hora actual: ");
+    // Hora actual (displayCurrentTime() pone su título)
     rtcManager->displayCurrentTime();
     
+    // Tráfico I2C con el RTC
+    Serial.print(F("Transacciones I2C RTC: "));
+    Serial.println(rtcManager->getI2CTransactionCount());
+    
+    // Registro de horarios en EEPROM
+    EEPROMManager& store = scheduleManager->getStore();
+    Serial.print(F("EEPROM: "));
+    if (store.hasRecord()) {
+      Serial.print(F("registro #"));
+      Serial.print(store.getSequence());
+      Serial.print(F(" en ranura "));
+      Serial.print(store.getCurrentSlot() + 1);
+      Serial.print(F("/"));
+      Serial.print(store.getSlotCount());
+      if (store.isFlushed()) {
+        Serial.println(F(" (guardado)"));
+      } else {
+        Serial.print(F(" (escribiendo, "));
+        Serial.print(store.getQueueDepth());
+        Serial.println(F(" bytes en cola)"));
+      }
+    } else {
+      Serial.println(F("sin registro (valores predeterminados)"));
+    }
+    
     // Estado del relay
-    Serial.print("Relay: ");
-    Serial.println(relayController->getRelayState() ? "ACTIVO" : "INACTIVO");
+    Serial.print(F("Relay: "));
+    Serial.println(relayController->getRelayState() ? F("ACTIVO") : F("INACTIVO"));
     
     // Estado de alimentación
     if (relayController->isFeedingActive()) {
-      Serial.print("Alimentando - Tiempo restante: ");
+      Serial.print(F("Alimentando - Tiempo restante: "));
       Serial.print(relayController->getRemainingFeedTime());
-      Serial.println(" segundos");
+      Serial.println(F(" segundos"));
     } else {
-      Serial.println("No alimentando");
+      Serial.println(F("No alimentando"));
     }
     
     // Horarios habilitados
-    Serial.print("Horarios habilitados: ");
+    Serial.print(F("Horarios habilitados: "));
     Serial.print(scheduleManager->getEnabledSchedulesCount());
-    Serial.print("/");
+    Serial.print(F("/"));
     Serial.println(MAX_FEED_TIMES);
     
     // Próximo horario
     int nextSchedule = scheduleManager->getNextSchedule(*rtcManager);
     if (nextSchedule > 0) {
       FeedTime next = scheduleManager->getSchedule(nextSchedule);
-      Serial.print("Próximo horario: #");
+      Serial.print(F("Próximo horario: #"));
       Serial.print(nextSchedule);
-      Serial.print(" a las ");
+      Serial.print(F(" a las "));
       printTwoDigits(next.hour);
-      Serial.print(":");
+      Serial.print(F(":"));
       printTwoDigits(next.minute);
       Serial.println();
     } else {
-      Serial.println("No hay horarios habilitados");
+      Serial.println(F("No hay horarios habilitados"));
     }
     
-    Serial.println("=========================\n");
+    Serial.println(F("=========================\n"));
   }
 
   // Mostrar próximo horario de alimentación
@@ -161,15 +257,15 @@ private:
     int nextSchedule = scheduleManager->getNextSchedule(*rtcManager);
     if (nextSchedule > 0) {
       FeedTime next = scheduleManager->getSchedule(nextSchedule);
-      Serial.print("Próximo horario: #");
+      Serial.print(F("Próximo horario: #"));
       Serial.print(nextSchedule);
-      Serial.print(" a las ");
+      Serial.print(F(" a las "));
       printTwoDigits(next.hour);
-      Serial.print(":");
+      Serial.print(F(":"));
       printTwoDigits(next.minute);
       Serial.println();
     } else {
-      Serial.println("No hay horarios habilitados");
+      Serial.println(F("No hay horarios habilitados"));
     }
   }
 
@@ -178,7 +274,7 @@ private:
     // Formato: "set 1 08:30" o "set 1 off"
     int firstSpace = command.indexOf(' ', 4);
     if (firstSpace == -1) {
-      Serial.println("Formato incorrecto. Uso: set X HH:MM o set X off");
+      Serial.println(F("Formato incorrecto. Uso: set X HH:MM o set X off"));
       return;
     }
     
@@ -186,16 +282,16 @@ private:
     String timeStr = command.substring(firstSpace + 1);
     
     if (scheduleNum < 1 || scheduleNum > MAX_FEED_TIMES) {
-      Serial.print("Número de horario debe ser 1-");
+      Serial.print(F("Número de horario debe ser 1-"));
       Serial.println(MAX_FEED_TIMES);
       return;
     }
     
     if (timeStr == "off") {
       if (scheduleManager->enableSchedule(scheduleNum, false)) {
-        Serial.print("Horario ");
+        Serial.print(F("Horario "));
         Serial.print(scheduleNum);
-        Serial.println(" deshabilitado");
+        Serial.println(F(" deshabilitado"));
       }
     }
     else if (timeStr.indexOf(':') == 2 && timeStr.length() == 5) {
@@ -203,16 +299,16 @@ private:
       int minute = timeStr.substring(3, 5).toInt();
       
       if (scheduleManager->setSchedule(scheduleNum, hour, minute)) {
-        Serial.print("Horario ");
+        Serial.print(F("Horario "));
         Serial.print(scheduleNum);
-        Serial.print(" configurado a ");
+        Serial.print(F(" configurado a "));
         Serial.println(timeStr);
       } else {
-        Serial.println("Hora inválida. Formato: HH:MM (00:00 - 23:59)");
+        Serial.println(F("Hora inválida. Formato: HH:MM (00:00 - 23:59)"));
       }
     }
     else {
-      Serial.println("Formato incorrecto. Uso: set X HH:MM o set X off");
+      Serial.println(F("Formato incorrecto. Uso: set X HH:MM o set X off"));
     }
   }
 
@@ -222,17 +318,21 @@ private:
     
     if (parameter == "all") {
       scheduleManager->enableAllSchedules();
-      Serial.println("Todos los horarios habilitados");
+      Serial.println(F("Todos los horarios habilitados"));
     } else {
       int scheduleNum = parameter.toInt();
       if (scheduleNum >= 1 && scheduleNum <= MAX_FEED_TIMES) {
         if (scheduleManager->enableSchedule(scheduleNum, true)) {
-          Serial.print("Horario ");
+          Serial.print(F("Horario "));
           Serial.print(scheduleNum);
-          Serial.println(" habilitado");
+          Serial.println(F(" habilitado"));
+        } else {
+          Serial.print(F("Horario "));
+          Serial.print(scheduleNum);
+          Serial.println(F(" sin hora. Usa: set X HH:MM"));
         }
       } else {
-        Serial.println("Número de horario inválido (1-4) o usa 'enable all'");
+        printInvalidScheduleNumber("enable all");
       }
     }
   }
@@ -243,46 +343,66 @@ private:
     
     if (parameter == "all") {
       scheduleManager->disableAllSchedules();
-      Serial.println("Todos los horarios deshabilitados");
+      Serial.println(F("Todos los horarios deshabilitados"));
     } else {
       int scheduleNum = parameter.toInt();
       if (scheduleNum >= 1 && scheduleNum <= MAX_FEED_TIMES) {
         if (scheduleManager->enableSchedule(scheduleNum, false)) {
-          Serial.print("Horario ");
+          Serial.print(F("Horario "));
           Serial.print(scheduleNum);
-          Serial.println(" deshabilitado");
+          Serial.println(F(" deshabilitado"));
         }
       } else {
-        Serial.println("Número de horario inválido (1-4) o usa 'disable all'");
+        printInvalidScheduleNumber("disable all");
       }
     }
   }
 
-  // Procesar comandos de prueba
+  // Mensaje de número de horario fuera de rango
+  void printInvalidScheduleNumber(const char* allCommand) {
+    Serial.print(F("Número de horario inválido (1-"));
+    Serial.print(MAX_FEED_TIMES);
+    Serial.print(F(") o usa '"));
+    Serial.print(allCommand);
+    Serial.println(F("'"));
+  }
+
+  // Procesar comandos de prueba: arrancan la prueba y retornan enseguida
   void processTestCommand(String command) {
     String parameter = command.substring(5); // Después de "test "
     
-    if (parameter == "relay") {
-      Serial.println("Probando relay por 3 segundos...");
-      relayController->setRelayState(true);
-      delay(3000);
-      relayController->setRelayState(false);
-      Serial.println("Prueba de relay completada");
-    }
-    else if (parameter == "led") {
-      Serial.println("Probando LED...");
-      relayController->blinkLed(5, 300);
-      Serial.println("Prueba de LED completada");
+    if (parameter == "relay" || parameter == "led") {
+      testingRelay = parameter == "relay";
+      testTask.start();
+      runTestCommand();
     }
     else {
-      Serial.println("Pruebas disponibles: 'test relay' o 'test led'");
+      Serial.println(F("Pruebas disponibles: 'test relay' o 'test led'"));
+    }
+  }
+
+  // Prueba en curso: la arranca y espera sin bloquear a que el
+  // RelayController la termine ("stop" la abandona)
+  bool runTestCommand() {
+    CO_BEGIN(testTask);
+    if (testingRelay) {
+      Serial.println(F("Probando relay por 3 segundos..."));
+      relayController->testRelays(3000);
+      CO_WAIT_UNTIL(testTask, !relayController->isTesting());
+      Serial.println(F("Prueba de relay completada"));
+    } else {
+      Serial.println(F("Probando LED..."));
+      relayController->blinkLed(5, 300);
+      CO_WAIT_UNTIL(testTask, !relayController->isBlinking());
+      Serial.println(F("Prueba de LED completada"));
     }
+    CO_END(testTask);
   }
 
   // Función auxiliar para imprimir números con dos dígitos
   void printTwoDigits(int number) {
     if (number < 10) {
-      Serial.print("0");
+      Serial.print(F("0"));
     }
     Serial.print(number);
   }
@@ -0,0 +1,240 @@
+/*
+  Arduino.h - API mínima de Arduino para compilar el sketch en PC
+
+  Solo implementa lo que usa el alimentador: tiempo, pines, String,
+  Serial y utilidades. El tiempo es virtual (ver sim_core.h).
+*/
+
+#ifndef ARDUINO_H_SIM
+#define ARDUINO_H_SIM
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <ctype.h>
+#include <string>
+#include <type_traits>
+#include "sim_core.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+// Pines analógicos del Arduino Uno
+const uint8_t A0 = 14;
+const uint8_t A1 = 15;
+const uint8_t A2 = 16;
+const uint8_t A3 = 17;
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define bit(b) (1UL << (b))
+
+#define PROGMEM
+#define F(text) (text)
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+
+// === TIEMPO ===
+inline uint32_t millis() { return sim::millis32(); }
+inline uint32_t micros() { return sim::micros32(); }
+inline void delay(uint32_t ms) { sim::delayMillis(ms); }
+inline void delayMicroseconds(uint32_t us) { sim::advanceMicros(us); }
+
+// === PINES ===
+inline void pinMode(int pin, int mode) { sim::pinSetMode(pin, mode); }
+inline void digitalWrite(int pin, int level) { sim::pinWrite(pin, level); }
+inline int digitalRead(int pin) { return sim::pinRead(pin); }
+inline void tone(int pin, unsigned int, uint32_t = 0) { sim::pinWrite(pin, HIGH); }
+inline void noTone(int pin) { sim::pinWrite(pin, LOW); }
+
+// === UTILIDADES ===
+template <class A, class B>
+inline auto min(A a, B b) -> typename std::common_type<A, B>::type { return (a < b) ? a : b; }
+template <class A, class B>
+inline auto max(A a, B b) -> typename std::common_type<A, B>::type { return (a > b) ? a : b; }
+template <class T, class L, class H>
+inline T constrain(T value, L low, H high) { return value < low ? low : (value > high ? high : value); }
+
+// === INTERRUPCIONES ===
+inline void noInterrupts() { sim::setInterruptsEnabled(false); }
+inline void interrupts() { sim::setInterruptsEnabled(true); }
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int interrupt, void (*handler)(), int mode) { sim::attachPinInterrupt(interrupt, handler, mode); }
+inline void detachInterrupt(int interrupt) { sim::detachPinInterrupt(interrupt); }
+// Solo en el simulador: sustituye a ISR(TIMER0_COMPA_vect) y TIMSK0
+inline void attachTimer0CompareInterrupt(void (*handler)()) { sim::setTimer0CompareInterrupt(handler); }
+// Solo en el simulador: sustituye al Timer1 en modo CTC y a ISR(TIMER1_COMPA_vect)
+inline void attachTimer1CompareInterrupt(void (*handler)(), uint32_t periodUs) { sim::setTimer1CompareInterrupt(handler, periodUs); }
+inline void detachTimer1CompareInterrupt() { sim::setTimer1CompareInterrupt(0, 0); }
+// Solo en el simulador: sustituye a sleep_cpu() en SLEEP_MODE_PWR_DOWN y a ISR(WDT_vect)
+inline void sleepPowerDown(void (*watchdog)(), uint32_t watchdogUs) { sim::sleepPowerDown(watchdog, watchdogUs); }
+// Solo en el simulador: sustituye a sleep_mode() en SLEEP_MODE_IDLE (como mucho maxUs)
+inline void sleepIdle(uint32_t maxUs) { sim::sleepIdle(maxUs); }
+
+// === STRING ===
+class String {
+private:
+  std::string text;
+
+public:
+  String() {}
+  String(const char* value) : text(value ? value : "") {}
+  String(const std::string& value) : text(value) {}
+  String(char value) : text(1, value) {}
+  String(int value) : text(std::to_string(value)) {}
+  String(unsigned int value) : text(std::to_string(value)) {}
+  String(long value) : text(std::to_string(value)) {}
+  String(unsigned long value) : text(std::to_string(value)) {}
+
+  unsigned int length() const { return (unsigned int)text.size(); }
+  const char* c_str() const { return text.c_str(); }
+  char charAt(unsigned int index) const { return index < text.size() ? text[index] : 0; }
+  char operator[](unsigned int index) const { return charAt(index); }
+
+  String substring(unsigned int from) const {
+    return from < text.size() ? String(text.substr(from)) : String();
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) { unsigned int t = from; from = to; to = t; }
+    if (from >= text.size()) return String();
+    return String(text.substr(from, to - from));
+  }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = text.find(c, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  int indexOf(const String& s, unsigned int from = 0) const {
+    size_t pos = text.find(s.text, from);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+
+  bool startsWith(const String& prefix) const { return text.compare(0, prefix.text.size(), prefix.text) == 0; }
+  bool endsWith(const String& suffix) const {
+    return text.size() >= suffix.text.size() &&
+           text.compare(text.size() - suffix.text.size(), suffix.text.size(), suffix.text) == 0;
+  }
+
+  long toInt() const { return atol(text.c_str()); }
+
+  void trim() {
+    size_t start = 0;
+    while (start < text.size() && isspace((unsigned char)text[start])) start++;
+    size_t end = text.size();
+    while (end > start && isspace((unsigned char)text[end - 1])) end--;
+    text = text.substr(start, end - start);
+  }
+  void toLowerCase() { for (size_t i = 0; i < text.size(); i++) text[i] = (char)tolower((unsigned char)text[i]); }
+  void toUpperCase() { for (size_t i = 0; i < text.size(); i++) text[i] = (char)toupper((unsigned char)text[i]); }
+
+  String& operator+=(const String& other) { text += other.text; return *this; }
+  String& operator+=(const char* other) { text += other; return *this; }
+  String& operator+=(char c) { text += c; return *this; }
+  String& operator+=(int value) { text += std::to_string(value); return *this; }
+
+  bool operator==(const String& other) const { return text == other.text; }
+  bool operator==(const char* other) const { return text == other; }
+  bool operator!=(const String& other) const { return text != other.text; }
+  bool operator!=(const char* other) const { return text != other; }
+
+  friend String operator+(const String& a, const String& b) { return String(a.text + b.text); }
+  friend String operator+(const String& a, const char* b) { return String(a.text + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.text); }
+};
+
+// === PRINT ===
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t value) = 0;
+
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+  size_t write(const char* text) { return text ? write((const uint8_t*)text, strlen(text)) : 0; }
+
+  size_t print(const char* text) { return write(text); }
+  size_t print(const String& text) { return write(text.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value, int base = DEC) { return printNumber((long long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return printNumber((long long)value, base); }
+  size_t print(long value, int base = DEC) { return printNumber((long long)value, base); }
+  size_t print(unsigned long value, int base = DEC) { return printNumber((long long)value, base); }
+  size_t print(double value, int digits = 2) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+    return write(buffer);
+  }
+
+  size_t println() { return write("\r\n"); }
+  template <class T>
+  size_t println(const T& value) { size_t n = print(value); return n + println(); }
+  template <class T>
+  size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+
+private:
+  size_t printNumber(long long value, int base) {
+    char buffer[72];
+    if (base == DEC) {
+      snprintf(buffer, sizeof(buffer), "%lld", value);
+    } else {
+      unsigned long long v = (unsigned long long)value;
+      char* p = buffer + sizeof(buffer) - 1;
+      *p = 0;
+      do {
+        int digit = (int)(v % base);
+        *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        v /= base;
+      } while (v);
+      return write(p);
+    }
+    return write(buffer);
+  }
+};
+
+// === SERIAL ===
+class HardwareSerial : public Print {
+public:
+  void begin(uint32_t) {}
+  void end() {}
+  int available() { return sim::serialAvailable(); }
+  int read() { return sim::serialRead(); }
+  void flush() { fflush(stdout); }
+  operator bool() const { return true; }
+
+  String readStringUntil(char terminator) {
+    String result;
+    int c;
+    while ((c = read()) >= 0 && c != terminator) result += (char)c;
+    return result;
+  }
+
+  using Print::write;
+  size_t write(uint8_t value) override {
+    if (sim::serialEcho()) putchar(value);
+    return 1;
+  }
+};
+
+extern HardwareSerial Serial;
+
+#endif // ARDUINO_H_SIM
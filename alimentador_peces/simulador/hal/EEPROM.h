@@ -0,0 +1,54 @@
+/*
+  EEPROM.h - EEPROM interna simulada (1 KB como el ATmega328P)
+
+  Cada escritura efectiva consume 3,3 ms de tiempo virtual, igual que
+  una escritura de byte bloqueante en AVR. startWrite() y
+  setReadyInterrupt() reemplazan a los registros EEAR/EEDR/EECR para
+  escribir en segundo plano con la interrupción EE_READY.
+*/
+
+#ifndef EEPROM_H_SIM
+#define EEPROM_H_SIM
+
+#include "Arduino.h"
+
+class EEPROMClass {
+public:
+  uint8_t read(int address) {
+    if (address < 0 || address >= sim::EEPROM_BYTES) return 0xFF;
+    return sim::eepromData()[address];
+  }
+
+  void write(int address, uint8_t value);
+
+  // Escritura en segundo plano (equivale a EEMPE + EEPE)
+  bool isReady() { return sim::eepromReady(); }
+  void startWrite(int address, uint8_t value) { sim::eepromStartWrite(address, value); }
+
+  // Interrupción EE_READY (equivale a EERIE); 0 la deshabilita
+  void setReadyInterrupt(void (*handler)()) { sim::setEepromReadyInterrupt(handler); }
+
+  void update(int address, uint8_t value) {
+    if (read(address) != value) write(address, value);
+  }
+
+  template <typename T>
+  T& get(int address, T& value) {
+    uint8_t* p = (uint8_t*)&value;
+    for (size_t i = 0; i < sizeof(T); i++) p[i] = read(address + (int)i);
+    return value;
+  }
+
+  template <typename T>
+  const T& put(int address, const T& value) {
+    const uint8_t* p = (const uint8_t*)&value;
+    for (size_t i = 0; i < sizeof(T); i++) update(address + (int)i, p[i]);
+    return value;
+  }
+
+  uint16_t length() { return sim::EEPROM_BYTES; }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // EEPROM_H_SIM
@@ -0,0 +1,148 @@
+/*
+  LiquidCrystal_I2C.h - Réplica de la librería LiquidCrystal_I2C para el simulador
+
+  Mantiene el mismo protocolo que la librería real: cada nibble se envía
+  como una transmisión Wire al PCF8574 seguida de dos más para el pulso
+  de Enable. Así el tráfico I2C y el tiempo consumido por el LCD virtual
+  son comparables con los del hardware.
+*/
+
+#ifndef LIQUIDCRYSTAL_I2C_H_SIM
+#define LIQUIDCRYSTAL_I2C_H_SIM
+
+#include "Arduino.h"
+#include "Wire.h"
+
+// Comandos HD44780
+#define LCD_CLEARDISPLAY   0x01
+#define LCD_RETURNHOME     0x02
+#define LCD_ENTRYMODESET   0x04
+#define LCD_DISPLAYCONTROL 0x08
+#define LCD_FUNCTIONSET    0x20
+#define LCD_SETCGRAMADDR   0x40
+#define LCD_SETDDRAMADDR   0x80
+
+#define LCD_ENTRYLEFT      0x02
+#define LCD_DISPLAYON      0x04
+#define LCD_4BITMODE       0x00
+#define LCD_2LINE          0x08
+#define LCD_5x8DOTS        0x00
+
+#define LCD_BACKLIGHT      0x08
+#define LCD_NOBACKLIGHT    0x00
+
+#define En 0x04  // Bit de Enable
+#define Rw 0x02  // Bit de Read/Write
+#define Rs 0x01  // Bit de Register select
+
+class LiquidCrystal_I2C : public Print {
+private:
+  uint8_t addr;
+  uint8_t cols;
+  uint8_t rows;
+  uint8_t backlightVal;
+  uint8_t displayControl;
+
+public:
+  LiquidCrystal_I2C(uint8_t lcdAddr, uint8_t lcdCols, uint8_t lcdRows)
+    : addr(lcdAddr), cols(lcdCols), rows(lcdRows), backlightVal(LCD_NOBACKLIGHT),
+      displayControl(LCD_DISPLAYON) {}
+
+  void init() {
+    Wire.begin();
+    begin();
+  }
+
+  void begin() {
+    delay(50);
+    expanderWrite(backlightVal);
+    delay(1000);
+
+    // Secuencia de arranque en modo 4 bits
+    write4bits(0x03 << 4);
+    delayMicroseconds(4500);
+    write4bits(0x03 << 4);
+    delayMicroseconds(4500);
+    write4bits(0x03 << 4);
+    delayMicroseconds(150);
+    write4bits(0x02 << 4);
+
+    command(LCD_FUNCTIONSET | LCD_4BITMODE | LCD_2LINE | LCD_5x8DOTS);
+    command(LCD_DISPLAYCONTROL | displayControl);
+    clear();
+    command(LCD_ENTRYMODESET | LCD_ENTRYLEFT);
+    home();
+  }
+
+  void clear() {
+    command(LCD_CLEARDISPLAY);
+    delayMicroseconds(2000);
+  }
+
+  void home() {
+    command(LCD_RETURNHOME);
+    delayMicroseconds(2000);
+  }
+
+  void setCursor(uint8_t col, uint8_t row) {
+    static const uint8_t rowOffsets[] = {0x00, 0x40, 0x14, 0x54};
+    if (row >= rows) row = rows - 1;
+    command(LCD_SETDDRAMADDR | (col + rowOffsets[row]));
+  }
+
+  void backlight() {
+    backlightVal = LCD_BACKLIGHT;
+    expanderWrite(0);
+  }
+
+  void noBacklight() {
+    backlightVal = LCD_NOBACKLIGHT;
+    expanderWrite(0);
+  }
+
+  void createChar(uint8_t location, uint8_t charmap[]) {
+    location &= 0x7;
+    command(LCD_SETCGRAMADDR | (location << 3));
+    for (int i = 0; i < 8; i++) {
+      write(charmap[i]);
+    }
+  }
+
+  using Print::write;
+  size_t write(uint8_t value) override {
+    send(value, Rs);
+    return 1;
+  }
+
+  void command(uint8_t value) {
+    send(value, 0);
+  }
+
+private:
+  void send(uint8_t value, uint8_t mode) {
+    uint8_t highnib = value & 0xF0;
+    uint8_t lownib = (value << 4) & 0xF0;
+    write4bits(highnib | mode);
+    write4bits(lownib | mode);
+  }
+
+  void write4bits(uint8_t value) {
+    expanderWrite(value);
+    pulseEnable(value);
+  }
+
+  void expanderWrite(uint8_t data) {
+    Wire.beginTransmission(addr);
+    Wire.write((uint8_t)(data | backlightVal));
+    Wire.endTransmission();
+  }
+
+  void pulseEnable(uint8_t data) {
+    expanderWrite(data | En);
+    delayMicroseconds(1);
+    expanderWrite(data & ~En);
+    delayMicroseconds(50);
+  }
+};
+
+#endif // LIQUIDCRYSTAL_I2C_H_SIM
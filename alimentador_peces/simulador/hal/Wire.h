@@ -0,0 +1,103 @@
+/*
+  Wire.h - Bus I2C simulado
+
+  Reproduce la semántica de la librería Wire de AVR (búfer de 32 bytes,
+  transmisiones bloqueantes) y despacha cada transacción al dispositivo
+  virtual de esa dirección. Cada transacción consume tiempo virtual
+  equivalente a un bus de 100 kHz.
+
+  startTransaction() es el equivalente al TWI con la interrupción
+  habilitada que usa twi_engine.h: retorna enseguida y la transacción
+  termina en segundo plano, avisando con el handler de
+  setCompleteInterrupt().
+*/
+
+#ifndef WIRE_H_SIM
+#define WIRE_H_SIM
+
+#include "Arduino.h"
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+private:
+  uint8_t txAddress;
+  uint8_t txBuffer[BUFFER_LENGTH];
+  uint8_t txLength;
+  bool transmitting;
+  uint8_t rxBuffer[BUFFER_LENGTH];
+  uint8_t rxLength;
+  uint8_t rxIndex;
+  uint32_t clockHz;
+
+public:
+  TwoWire() : txAddress(0), txLength(0), transmitting(false),
+              rxLength(0), rxIndex(0), clockHz(100000) {}
+
+  void begin() {}
+  void setClock(uint32_t hz) { clockHz = hz; }
+
+  void beginTransmission(uint8_t address) {
+    txAddress = address;
+    txLength = 0;
+    transmitting = true;
+  }
+  void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+
+  size_t write(uint8_t value) {
+    if (!transmitting || txLength >= BUFFER_LENGTH) return 0;
+    txBuffer[txLength++] = value;
+    return 1;
+  }
+  size_t write(const uint8_t* data, size_t length) {
+    size_t n = 0;
+    while (n < length && write(data[n])) n++;
+    return n;
+  }
+
+  uint8_t endTransmission(bool sendStop = true) {
+    (void)sendStop;
+    transmitting = false;
+    busTime(txLength);
+    sim::I2CDevice* device = sim::findI2CDevice(txAddress);
+    if (!device) return 2;  // NACK en la dirección
+    device->onWrite(txBuffer, txLength);
+    sim::recordI2C(txAddress, txLength);
+    return 0;
+  }
+
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true) {
+    (void)sendStop;
+    if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+    rxIndex = 0;
+    rxLength = 0;
+    busTime(quantity);
+    sim::I2CDevice* device = sim::findI2CDevice(address);
+    if (!device) return 0;
+    rxLength = (uint8_t)device->onRead(rxBuffer, quantity);
+    sim::recordI2C(address, rxLength);
+    return rxLength;
+  }
+  uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+
+  // Transacción sin esperar (equivale a arrancar el TWI con TWIE)
+  void startTransaction(uint8_t address, const uint8_t* tx, uint8_t txLength, uint8_t* rx, uint8_t rxLength) {
+    sim::i2cStartTransaction(address, tx, txLength, rx, rxLength, clockHz);
+  }
+  void setCompleteInterrupt(sim::I2CCompleteHandler handler) { sim::setI2CCompleteInterrupt(handler); }
+  void resetBus() { sim::i2cResetBus(); }
+
+  int available() { return rxLength - rxIndex; }
+  int read() { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+  int peek() { return rxIndex < rxLength ? rxBuffer[rxIndex] : -1; }
+
+private:
+  // START + dirección + datos + STOP, 9 bits por byte
+  void busTime(size_t bytes) {
+    sim::advanceMicros(((bytes + 1) * 9 + 2) * 1000000ULL / clockHz);
+  }
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H_SIM
@@ -0,0 +1,133 @@
+/*
+  sim_core.h - Núcleo del simulador en PC
+
+  Estado compartido por todas las cabeceras del HAL simulado:
+  - Reloj virtual (micros/millis) que solo avanza con delay() o saltos
+  - Pines digitales con niveles de entrada programables
+  - Bus I2C con dispositivos virtuales (DS3231 y LCD PCF8574)
+  - Serial, EEPROM y contadores de tráfico
+*/
+
+#ifndef SIM_CORE_H
+#define SIM_CORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace sim {
+
+// === RELOJ VIRTUAL ===
+uint64_t nowMicros();                    // Tiempo virtual desde el arranque
+void advanceMicros(uint64_t us);         // Avanzar el reloj virtual
+void delayMillis(uint32_t ms);           // delay(): avanza y cuenta el tiempo en espera
+uint64_t delayedMicros();                // Tiempo total pasado dentro de delay() o dormido
+void setMillisOffset(uint32_t ms);       // Valor inicial de millis() (para probar desbordes)
+uint32_t millis32();
+uint32_t micros32();
+
+// === PINES DIGITALES ===
+const int NUM_PINS = 20;
+void setInputLevel(int pin, int level);  // Nivel externo (botones)
+void scheduleInputLevel(int pin, int level, uint64_t atMicros);  // Cambio de nivel en un instante virtual
+int getOutputLevel(int pin);
+typedef void (*PinWriteHook)(int pin, int level);
+void setPinWriteHook(PinWriteHook hook);
+int pinModeOf(int pin);
+int pinRead(int pin);
+void pinWrite(int pin, int level);
+void pinSetMode(int pin, int mode);
+
+// === INTERRUPCIONES EXTERNAS ===
+typedef void (*InterruptHandler)();
+void attachPinInterrupt(int pin, InterruptHandler handler, int mode);
+void detachPinInterrupt(int pin);
+void setInterruptsEnabled(bool enabled);
+
+// === TIMER0 ===
+// Comparación A cada 1024 us (16 MHz, prescaler 64). Con los botones
+// quietos el muestreo no hace nada, así que solo se generan ticks
+// durante TIMER0_ACTIVE_TICKS después de cada cambio programado con
+// scheduleInputLevel()
+const uint32_t TIMER0_TICK_MICROS = 1024;
+const uint32_t TIMER0_ACTIVE_TICKS = 256;
+void setTimer0CompareInterrupt(InterruptHandler handler);
+
+// === TIMER1 ===
+// Modo CTC: interrupción cada periodUs desde ahora (handler 0 = parado)
+void setTimer1CompareInterrupt(InterruptHandler handler, uint32_t periodUs);
+
+// === POWER-DOWN E IDLE ===
+// Dormir hasta la próxima interrupción; el watchdog (si no es 0) corre
+// a los watchdogUs. El Timer0 se detiene: millis() no avanza dormido
+void sleepPowerDown(InterruptHandler watchdog, uint32_t watchdogUs);
+// Modo idle: los timers siguen (millis() avanza); despierta con la
+// próxima interrupción o a los maxUs. Cuenta como espera
+void sleepIdle(uint32_t maxUs);
+void setSleepLimit(uint64_t atMicros);   // No dormir más allá (próximo comando, fin de la simulación)
+uint64_t sleptMicros();                  // Tiempo total dormido
+
+// === BUS I2C ===
+class I2CDevice {
+public:
+  virtual ~I2CDevice() {}
+  virtual uint8_t address() const = 0;
+  virtual void onWrite(const uint8_t* data, size_t length) = 0;
+  virtual size_t onRead(uint8_t* out, size_t length) = 0;
+};
+
+struct I2CStats {
+  uint32_t transactions;   // Transmisiones completas (START..STOP)
+  uint32_t bytes;          // Bytes de datos transferidos
+};
+
+void attachI2CDevice(I2CDevice* device);
+I2CDevice* findI2CDevice(uint8_t address);
+void recordI2C(uint8_t address, size_t bytes);
+I2CStats i2cStats(uint8_t address);
+void resetI2CStats();
+
+// Transacción en segundo plano (interrupción TWI): escribe tx, lee rx con
+// START repetido y al terminar llama al handler con el código de
+// Wire.endTransmission() (0 = ok, 2 = NACK en la dirección)
+typedef void (*I2CCompleteHandler)(uint8_t result);
+void i2cStartTransaction(uint8_t address, const uint8_t* tx, size_t txLength,
+                         uint8_t* rx, size_t rxLength, uint32_t clockHz);
+void setI2CCompleteInterrupt(I2CCompleteHandler handler);
+void i2cResetBus();                      // Abortar la transacción en curso
+void jamI2CAt(uint64_t us);              // La primera transacción desde 'us' no termina nunca
+
+// === DS3231 VIRTUAL ===
+const uint8_t DS3231_ADDRESS = 0x68;
+void setRtcEpoch(uint32_t unixSeconds);
+uint32_t rtcEpoch();
+uint64_t rtcEpochMicros();
+void setRtcLostPower(bool lost);
+void connectRtcSqw(int pin);             // Pin del MCU unido a INT/SQW del DS3231
+uint32_t rtcAlarmCount();                // Coincidencias de la alarma 1
+uint64_t rtcLastAlarmMicros();           // Instante virtual de la última
+
+// === LCD VIRTUAL (HD44780 detrás de PCF8574) ===
+const char* lcdRow(int row);             // Contenido visible de una fila (20 caracteres)
+
+// === SERIAL ===
+void setSerialEcho(bool echo);
+bool serialEcho();
+void pushSerialInput(const char* text);
+int serialAvailable();
+int serialRead();
+
+// === EEPROM ===
+const int EEPROM_BYTES = 1024;
+uint8_t* eepromData();
+uint32_t eepromWrites();
+bool loadEeprom(const char* path);
+bool saveEeprom(const char* path);
+typedef void (*PowerCutHandler)();
+void setEepromPowerCut(uint32_t afterWrites, PowerCutHandler handler);  // Cortar la luz tras N escrituras
+bool eepromReady();                                      // Sin escritura en curso
+void eepromStartWrite(int address, uint8_t value);       // Escritura sin esperar (3,3 ms en segundo plano)
+void setEepromReadyInterrupt(InterruptHandler handler);  // Interrupción EE_READY (0 = deshabilitada)
+
+} // namespace sim
+
+#endif // SIM_CORE_H
@@ -0,0 +1,808 @@
+/*
+  sim_hal.cpp - Implementación del HAL simulado
+
+  Contiene el reloj virtual, los pines, el registro de dispositivos I2C
+  y los modelos del DS3231 y del LCD HD44780 con mochila PCF8574.
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "date_time.h"
+#include <EEPROM.h>
+#include <deque>
+#include <map>
+#include <utility>
+
+HardwareSerial Serial;
+TwoWire Wire;
+EEPROMClass EEPROM;
+
+namespace sim {
+
+// === RELOJ VIRTUAL ===
+static uint64_t virtualMicros = 0;
+static uint32_t millisOffset = 0;
+static uint64_t delayTotal = 0;
+
+// Power-down: el Timer0 se detiene y millis() no avanza mientras se duerme
+static bool sleeping = false;
+static bool sleepWoken = false;
+static uint64_t sleepStart = 0;
+static uint64_t sleptTotal = 0;
+static uint64_t sleepLimit = UINT64_MAX;
+
+static uint64_t nextTimedEdge();
+static void fireTimedEdge();
+static uint64_t nextEepromReady();
+static void fireEepromReady();
+static uint64_t nextI2CDone();
+static void fireI2CDone();
+static uint64_t nextInputChange();
+static void fireInputChange();
+static uint64_t nextTimer0Tick();
+static void fireTimer0Tick();
+static uint64_t nextTimer1Tick();
+static void fireTimer1Tick();
+
+uint64_t nowMicros() { return virtualMicros; }
+
+// Instante del próximo evento programado
+static uint64_t nextEventMicros() {
+  uint64_t next = nextTimedEdge();
+  uint64_t ready = nextEepromReady();
+  uint64_t i2cDone = nextI2CDone();
+  uint64_t input = nextInputChange();
+  uint64_t tick = nextTimer0Tick();
+  uint64_t tick1 = nextTimer1Tick();
+  if (ready < next) next = ready;
+  if (i2cDone < next) next = i2cDone;
+  if (input < next) next = input;
+  if (tick < next) next = tick;
+  if (tick1 < next) next = tick1;
+  return next;
+}
+
+// Avanzar el reloj disparando por el camino los eventos programados
+// (flancos SQW, fin de escrituras de EEPROM y de transacciones I2C,
+// botones y ticks del Timer0 y del Timer1)
+void advanceMicros(uint64_t us) {
+  uint64_t target = virtualMicros + us;
+  for (;;) {
+    uint64_t edge = nextTimedEdge();
+    uint64_t ready = nextEepromReady();
+    uint64_t i2cDone = nextI2CDone();
+    uint64_t input = nextInputChange();
+    uint64_t tick = nextTimer0Tick();
+    uint64_t tick1 = nextTimer1Tick();
+    uint64_t next = edge < ready ? edge : ready;
+    if (i2cDone < next) next = i2cDone;
+    if (input < next) next = input;
+    if (tick < next) next = tick;
+    if (tick1 < next) next = tick1;
+    if (next > target) break;
+    virtualMicros = next;
+    if (input == next) fireInputChange();
+    if (i2cDone == next) fireI2CDone();
+    if (ready == next) fireEepromReady();
+    if (edge == next) fireTimedEdge();
+    if (tick == next) fireTimer0Tick();
+    if (tick1 == next) fireTimer1Tick();
+  }
+  virtualMicros = target;
+}
+void delayMillis(uint32_t ms) {
+  delayTotal += (uint64_t)ms * 1000;
+  advanceMicros((uint64_t)ms * 1000);
+}
+uint64_t delayedMicros() { return delayTotal; }
+void setMillisOffset(uint32_t ms) { millisOffset = ms; }
+
+// Tiempo que vio correr el Timer0 (sin el tiempo dormido)
+static uint64_t awakeMicros() {
+  return (sleeping ? sleepStart : virtualMicros) - sleptTotal;
+}
+uint32_t millis32() { return (uint32_t)(awakeMicros() / 1000) + millisOffset; }
+uint32_t micros32() { return (uint32_t)awakeMicros() + millisOffset * 1000U; }
+
+// === POWER-DOWN E IDLE ===
+void sleepIdle(uint32_t maxUs) {
+  uint64_t wakeAt = virtualMicros + maxUs;
+  uint64_t next = nextEventMicros();
+  if (next < wakeAt) wakeAt = next > virtualMicros ? next : virtualMicros;
+  if (sleepLimit > virtualMicros && sleepLimit < wakeAt) wakeAt = sleepLimit;
+  delayTotal += wakeAt - virtualMicros;
+  advanceMicros(wakeAt - virtualMicros);
+}
+
+void setSleepLimit(uint64_t atMicros) { sleepLimit = atMicros; }
+uint64_t sleptMicros() { return sleptTotal; }
+
+// Dormir hasta que corra una interrupción, venza el watchdog o se llegue
+// al límite del simulador. El tiempo dormido cuenta como espera
+void sleepPowerDown(InterruptHandler watchdog, uint32_t watchdogUs) {
+  uint64_t watchdogAt = (watchdog && watchdogUs) ? virtualMicros + watchdogUs : UINT64_MAX;
+  uint64_t wakeAt = watchdogAt < sleepLimit ? watchdogAt : sleepLimit;
+  if (wakeAt <= virtualMicros) return;
+
+  sleeping = true;
+  sleepWoken = false;
+  sleepStart = virtualMicros;
+  while (!sleepWoken && virtualMicros < wakeAt) {
+    uint64_t next = nextEventMicros();
+    if (next == UINT64_MAX && wakeAt == UINT64_MAX) break;  // Nada puede despertarlo
+    advanceMicros((next < wakeAt ? next : wakeAt) - virtualMicros);
+  }
+  sleeping = false;
+  sleptTotal += virtualMicros - sleepStart;
+  delayTotal += virtualMicros - sleepStart;
+  if (!sleepWoken && virtualMicros == watchdogAt) watchdog();
+}
+
+// === PINES DIGITALES ===
+static int pinModes[NUM_PINS];
+static int pinOutputs[NUM_PINS];
+static int pinInputs[NUM_PINS];
+static bool pinInputSet[NUM_PINS];
+static PinWriteHook pinHook = 0;
+
+static bool validPin(int pin) { return pin >= 0 && pin < NUM_PINS; }
+
+// === INTERRUPCIONES EXTERNAS ===
+static InterruptHandler pinHandlers[NUM_PINS];
+static int pinInterruptModes[NUM_PINS];
+static bool pinInterruptPending[NUM_PINS];
+static bool interruptsEnabled = true;
+static InterruptHandler eepromReadyHandler = 0;
+static bool eepromReadyPending = false;
+static I2CCompleteHandler i2cCompleteHandler = 0;
+static bool i2cCompletePending = false;
+static uint8_t i2cResult = 0;
+static InterruptHandler timer0Handler = 0;
+static bool timer0Pending = false;
+static uint64_t timer0NextAt = 0;
+static uint64_t timer0ActiveUntil = 0;
+static InterruptHandler timer1Handler = 0;
+static bool timer1Pending = false;
+static uint64_t timer1NextAt = UINT64_MAX;
+static uint32_t timer1Period = 0;
+
+void attachPinInterrupt(int pin, InterruptHandler handler, int mode) {
+  if (!validPin(pin)) return;
+  pinHandlers[pin] = handler;
+  pinInterruptModes[pin] = mode;
+}
+
+void detachPinInterrupt(int pin) {
+  if (validPin(pin)) pinHandlers[pin] = 0;
+}
+
+static void runPendingInterrupts() {
+  for (int pin = 0; pin < NUM_PINS; pin++) {
+    if (pinInterruptPending[pin] && pinHandlers[pin]) {
+      pinInterruptPending[pin] = false;
+      sleepWoken = true;
+      pinHandlers[pin]();
+    }
+  }
+  // EE_READY es por nivel: se repite mientras siga habilitada y sin escritura
+  while (eepromReadyPending && eepromReadyHandler && interruptsEnabled) {
+    eepromReadyPending = false;
+    sleepWoken = true;
+    eepromReadyHandler();
+    if (eepromReadyHandler && eepromReady()) eepromReadyPending = true;
+  }
+  if (i2cCompletePending && i2cCompleteHandler && interruptsEnabled) {
+    i2cCompletePending = false;
+    sleepWoken = true;
+    i2cCompleteHandler(i2cResult);
+  }
+  if (timer0Pending && timer0Handler && interruptsEnabled) {
+    timer0Pending = false;
+    timer0Handler();
+  }
+  if (timer1Pending && timer1Handler && interruptsEnabled) {
+    timer1Pending = false;
+    sleepWoken = true;
+    timer1Handler();
+  }
+}
+
+void setInterruptsEnabled(bool enabled) {
+  interruptsEnabled = enabled;
+  if (enabled) runPendingInterrupts();
+}
+
+static void raisePinInterrupt(int pin, int oldLevel, int newLevel) {
+  if (!pinHandlers[pin] || oldLevel == newLevel) return;
+  int mode = pinInterruptModes[pin];
+  bool match = mode == CHANGE ||
+               (mode == FALLING && newLevel == LOW) ||
+               (mode == RISING && newLevel == HIGH);
+  if (!match) return;
+  pinInterruptPending[pin] = true;
+  if (interruptsEnabled) runPendingInterrupts();
+}
+
+void setInputLevel(int pin, int level) {
+  if (!validPin(pin)) return;
+  int oldLevel = pinRead(pin);
+  int newLevel = (pinModes[pin] == OUTPUT) ? oldLevel : level;
+  pinInputs[pin] = level;
+  pinInputSet[pin] = true;
+  raisePinInterrupt(pin, oldLevel, newLevel);
+}
+
+static void wakeTimer0();
+
+// Cambios de nivel programados (instante -> pin, nivel)
+static std::multimap<uint64_t, std::pair<int, int> > inputChanges;
+
+void scheduleInputLevel(int pin, int level, uint64_t atMicros) {
+  inputChanges.insert(std::make_pair(atMicros, std::make_pair(pin, level)));
+}
+
+static uint64_t nextInputChange() {
+  return inputChanges.empty() ? UINT64_MAX : inputChanges.begin()->first;
+}
+
+static void fireInputChange() {
+  std::pair<int, int> change = inputChanges.begin()->second;
+  inputChanges.erase(inputChanges.begin());
+  setInputLevel(change.first, change.second);
+  wakeTimer0();
+}
+
+// === TIMER0 ===
+void setTimer0CompareInterrupt(InterruptHandler handler) {
+  timer0Handler = handler;
+  wakeTimer0();
+}
+
+// Generar ticks durante un rato desde ahora
+static void wakeTimer0() {
+  timer0ActiveUntil = virtualMicros + (uint64_t)TIMER0_ACTIVE_TICKS * TIMER0_TICK_MICROS;
+  if (timer0NextAt <= virtualMicros) {
+    timer0NextAt = (virtualMicros / TIMER0_TICK_MICROS + 1) * TIMER0_TICK_MICROS;
+  }
+}
+
+static uint64_t nextTimer0Tick() {
+  if (sleeping) return UINT64_MAX;  // El Timer0 no corre en power-down
+  return (timer0Handler && timer0NextAt <= timer0ActiveUntil) ? timer0NextAt : UINT64_MAX;
+}
+
+static void fireTimer0Tick() {
+  timer0NextAt += TIMER0_TICK_MICROS;
+  timer0Pending = true;
+  if (interruptsEnabled) runPendingInterrupts();
+}
+
+// === TIMER1 ===
+void setTimer1CompareInterrupt(InterruptHandler handler, uint32_t periodUs) {
+  timer1Handler = handler;
+  timer1Period = periodUs;
+  timer1Pending = false;
+  timer1NextAt = handler ? virtualMicros + periodUs : UINT64_MAX;
+}
+
+static uint64_t nextTimer1Tick() {
+  return timer1NextAt;
+}
+
+static void fireTimer1Tick() {
+  timer1NextAt += timer1Period;
+  timer1Pending = true;
+  if (interruptsEnabled) runPendingInterrupts();
+}
+
+int getOutputLevel(int pin) { return validPin(pin) ? pinOutputs[pin] : LOW; }
+void setPinWriteHook(PinWriteHook hook) { pinHook = hook; }
+int pinModeOf(int pin) { return validPin(pin) ? pinModes[pin] : INPUT; }
+
+void pinSetMode(int pin, int mode) {
+  if (validPin(pin)) pinModes[pin] = mode;
+}
+
+void pinWrite(int pin, int level) {
+  if (!validPin(pin)) return;
+  pinOutputs[pin] = level ? HIGH : LOW;
+  if (pinHook) pinHook(pin, pinOutputs[pin]);
+}
+
+int pinRead(int pin) {
+  if (!validPin(pin)) return LOW;
+  if (pinModes[pin] == OUTPUT) return pinOutputs[pin];
+  if (pinInputSet[pin]) return pinInputs[pin];
+  return pinModes[pin] == INPUT_PULLUP ? HIGH : LOW;
+}
+
+// === BUS I2C ===
+static std::map<uint8_t, I2CDevice*>& devices() {
+  static std::map<uint8_t, I2CDevice*> table;
+  return table;
+}
+static std::map<uint8_t, I2CStats> stats;
+
+void attachI2CDevice(I2CDevice* device) { devices()[device->address()] = device; }
+
+I2CDevice* findI2CDevice(uint8_t address) {
+  std::map<uint8_t, I2CDevice*>::iterator it = devices().find(address);
+  return it == devices().end() ? 0 : it->second;
+}
+
+void recordI2C(uint8_t address, size_t bytes) {
+  I2CStats& s = stats[address];
+  s.transactions++;
+  s.bytes += (uint32_t)bytes;
+}
+
+I2CStats i2cStats(uint8_t address) {
+  std::map<uint8_t, I2CStats>::iterator it = stats.find(address);
+  if (it == stats.end()) {
+    I2CStats empty = {0, 0};
+    return empty;
+  }
+  return it->second;
+}
+
+void resetI2CStats() { stats.clear(); }
+
+// Transacción en curso del motor TWI
+static bool i2cBusy = false;
+static uint64_t i2cDoneAt = UINT64_MAX;    // UINT64_MAX si está atascada
+static uint64_t i2cJamAt = UINT64_MAX;
+static uint8_t i2cAddress = 0;
+static const uint8_t* i2cTx = 0;
+static size_t i2cTxLength = 0;
+static uint8_t* i2cRx = 0;
+static size_t i2cRxLength = 0;
+
+void i2cStartTransaction(uint8_t address, const uint8_t* tx, size_t txLength,
+                         uint8_t* rx, size_t rxLength, uint32_t clockHz) {
+  i2cBusy = true;
+  i2cAddress = address;
+  i2cTx = tx;
+  i2cTxLength = txLength;
+  i2cRx = rx;
+  i2cRxLength = rxLength;
+
+  // Un esclavo que retiene SDA deja la transacción sin terminar
+  if (virtualMicros >= i2cJamAt) {
+    i2cJamAt = UINT64_MAX;
+    i2cDoneAt = UINT64_MAX;
+    return;
+  }
+
+  // START + dirección + datos (+ START repetido + dirección + datos) + STOP
+  size_t bits = (txLength + 1) * 9 + 2;
+  if (rxLength > 0) bits += (rxLength + 1) * 9;
+  i2cDoneAt = virtualMicros + bits * 1000000ULL / clockHz;
+}
+
+void setI2CCompleteInterrupt(I2CCompleteHandler handler) { i2cCompleteHandler = handler; }
+
+void i2cResetBus() {
+  i2cBusy = false;
+  i2cDoneAt = UINT64_MAX;
+  i2cCompletePending = false;
+}
+
+void jamI2CAt(uint64_t us) { i2cJamAt = us; }
+
+static uint64_t nextI2CDone() {
+  return i2cBusy ? i2cDoneAt : UINT64_MAX;
+}
+
+// Fin de la transacción: entregar los datos al dispositivo y avisar
+static void fireI2CDone() {
+  i2cBusy = false;
+  I2CDevice* device = findI2CDevice(i2cAddress);
+  if (!device) {
+    i2cResult = 2;
+  } else {
+    if (i2cTxLength > 0) device->onWrite(i2cTx, i2cTxLength);
+    size_t received = i2cRxLength > 0 ? device->onRead(i2cRx, i2cRxLength) : 0;
+    recordI2C(i2cAddress, i2cTxLength + received);
+    i2cResult = 0;
+  }
+  i2cCompletePending = true;
+  if (interruptsEnabled) runPendingInterrupts();
+}
+
+// === DS3231 VIRTUAL ===
+static void refreshRtcInt();
+
+class DS3231Model : public I2CDevice {
+private:
+  uint8_t regs[0x13];
+  uint8_t pointer;
+  uint64_t epochMicrosAtBase;   // Época (µs) en el instante virtualMicrosAtBase
+  uint64_t virtualMicrosAtBase;
+
+  static uint8_t bin2bcd(uint8_t value) { return value + 6 * (value / 10); }
+  static uint8_t bcd2bin(uint8_t value) { return value - 6 * (value >> 4); }
+
+  // Volcar la hora actual a los registros 0x00-0x06
+  void materializeTime() {
+    DateTime t(epoch());
+    regs[0] = bin2bcd(t.second());
+    regs[1] = bin2bcd(t.minute());
+    regs[2] = bin2bcd(t.hour());
+    regs[3] = bin2bcd(t.dayOfTheWeek() ? t.dayOfTheWeek() : 7);
+    regs[4] = bin2bcd(t.day());
+    regs[5] = bin2bcd(t.month());
+    regs[6] = bin2bcd(t.year() - 2000);
+  }
+
+public:
+  DS3231Model() : pointer(0), epochMicrosAtBase(0), virtualMicrosAtBase(0), alarm1Count(0), alarm1At(0) {
+    memset(regs, 0, sizeof(regs));
+    regs[0x0E] = 0x1C;  // INTCN=1, RS=1 Hz por defecto
+    setEpoch(DateTime(2024, 1, 1, 0, 0, 0).unixtime());
+  }
+
+  uint8_t address() const override { return DS3231_ADDRESS; }
+
+  uint64_t epochMicros() const {
+    return epochMicrosAtBase + (virtualMicros - virtualMicrosAtBase);
+  }
+  uint32_t epoch() const { return (uint32_t)(epochMicros() / 1000000ULL); }
+
+  void setEpoch(uint32_t seconds) {
+    epochMicrosAtBase = (uint64_t)seconds * 1000000ULL;
+    virtualMicrosAtBase = virtualMicros;
+  }
+
+  void setLostPower(bool lost) {
+    if (lost) regs[0x0F] |= 0x80; else regs[0x0F] &= ~0x80;
+  }
+
+  // INTCN=0 y RS2:RS1=00: onda cuadrada de 1 Hz en INT/SQW
+  bool squareWave1Hz() const {
+    return (regs[0x0E] & 0x1C) == 0;
+  }
+
+  // INTCN=1: INT/SQW en bajo mientras haya una bandera de alarma habilitada
+  bool interruptAsserted() const {
+    return (regs[0x0E] & 0x04) && (regs[0x0E] & regs[0x0F] & 0x03);
+  }
+
+  // Próximo segundo Unix (> el actual) en que coincide la alarma 1, o 0.
+  // Máscaras A1M1-A1M4: cada segundo, segundos, minutos o horas; el modo
+  // por fecha o día de la semana no está modelado
+  uint32_t nextAlarm1() const {
+    uint8_t masks = (regs[0x07] >> 7) | ((regs[0x08] >> 6) & 0x02) |
+                    ((regs[0x09] >> 5) & 0x04) | ((regs[0x0A] >> 4) & 0x08);
+    uint32_t period;
+    uint32_t offset = 0;
+    uint8_t second = bcd2bin(regs[0x07] & 0x7F);
+    uint8_t minute = bcd2bin(regs[0x08] & 0x7F);
+    uint8_t hour = bcd2bin(regs[0x09] & 0x3F);
+    switch (masks) {
+      case 0x0F: period = 1; break;
+      case 0x0E: period = 60; offset = second; break;
+      case 0x0C: period = 3600; offset = minute * 60 + second; break;
+      case 0x08: period = 86400; offset = hour * 3600UL + minute * 60 + second; break;
+      default: return 0;
+    }
+    uint32_t now = epoch();
+    uint32_t next = now - now % period + offset;
+    return next > now ? next : next + period;
+  }
+
+  // Coincidencia de la alarma 1: sube A1F (el pin lo actualiza quien llama)
+  void fireAlarm1() {
+    regs[0x0F] |= 0x01;
+    alarm1Count++;
+    alarm1At = virtualMicros;
+  }
+
+  uint32_t alarm1Count;
+  uint64_t alarm1At;
+
+  void onWrite(const uint8_t* data, size_t length) override {
+    if (length == 0) return;
+    pointer = data[0] % sizeof(regs);
+    if (length == 1) return;
+
+    materializeTime();
+    bool timeWritten = false;
+    bool secondsWritten = false;
+    for (size_t i = 1; i < length; i++) {
+      if (pointer <= 0x06) timeWritten = true;
+      if (pointer == 0x00) secondsWritten = true;
+      if (pointer == 0x0F) {
+        // OSF, A2F y A1F solo se pueden poner en 0
+        regs[pointer] = (data[i] & ~0x83) | (regs[pointer] & data[i] & 0x83);
+      } else {
+        regs[pointer] = data[i];
+      }
+      pointer = (pointer + 1) % sizeof(regs);
+    }
+
+    if (timeWritten) {
+      DateTime t(2000 + bcd2bin(regs[6]), bcd2bin(regs[5] & 0x1F), bcd2bin(regs[4]),
+                 bcd2bin(regs[2] & 0x3F), bcd2bin(regs[1]), bcd2bin(regs[0] & 0x7F));
+      // Solo escribir los segundos reinicia la cadena de división
+      uint64_t fraction = secondsWritten ? 0 : epochMicros() % 1000000ULL;
+      setEpoch(t.unixtime());
+      epochMicrosAtBase += fraction;
+    }
+    refreshRtcInt();
+  }
+
+  size_t onRead(uint8_t* out, size_t length) override {
+    materializeTime();
+    for (size_t i = 0; i < length; i++) {
+      out[i] = regs[pointer];
+      pointer = (pointer + 1) % sizeof(regs);
+    }
+    return length;
+  }
+};
+
+static DS3231Model& rtcModel() {
+  static DS3231Model model;
+  return model;
+}
+
+void setRtcEpoch(uint32_t unixSeconds) { rtcModel().setEpoch(unixSeconds); }
+uint32_t rtcEpoch() { return rtcModel().epoch(); }
+uint64_t rtcEpochMicros() { return rtcModel().epochMicros(); }
+void setRtcLostPower(bool lost) { rtcModel().setLostPower(lost); }
+uint32_t rtcAlarmCount() { return rtcModel().alarm1Count; }
+uint64_t rtcLastAlarmMicros() { return rtcModel().alarm1At; }
+
+// Onda cuadrada de 1 Hz: flanco de bajada al cambiar el segundo, subida a mitad.
+// Con INTCN=1 el pin es la salida de interrupción de las alarmas
+static int sqwPin = -1;
+
+void connectRtcSqw(int pin) {
+  if (!validPin(pin)) return;
+  sqwPin = pin;
+  setInputLevel(pin, HIGH);  // Salida en drenador abierto con pull-up
+}
+
+// Nivel de INT tras escribir el control o limpiar las banderas
+static void refreshRtcInt() {
+  if (sqwPin < 0 || rtcModel().squareWave1Hz()) return;
+  int level = rtcModel().interruptAsserted() ? LOW : HIGH;
+  if (pinRead(sqwPin) != level) setInputLevel(sqwPin, level);
+}
+
+static uint64_t nextTimedEdge() {
+  if (sqwPin < 0) return UINT64_MAX;
+  uint64_t fraction = rtcModel().epochMicros() % 1000000ULL;
+  if (!rtcModel().squareWave1Hz()) {
+    uint32_t alarm = rtcModel().nextAlarm1();
+    if (!alarm) return UINT64_MAX;
+    return virtualMicros + (uint64_t)(alarm - rtcModel().epoch()) * 1000000ULL - fraction;
+  }
+  uint64_t wait = (fraction < 500000ULL) ? 500000ULL - fraction : 1000000ULL - fraction;
+  return virtualMicros + wait;
+}
+
+static void fireTimedEdge() {
+  if (!validPin(sqwPin)) return;
+  if (!rtcModel().squareWave1Hz()) {
+    rtcModel().fireAlarm1();
+    refreshRtcInt();
+    return;
+  }
+  uint64_t fraction = rtcModel().epochMicros() % 1000000ULL;
+  setInputLevel(sqwPin, fraction < 500000ULL ? LOW : HIGH);
+}
+
+// === LCD VIRTUAL ===
+// PCF8574: P0=RS, P1=RW, P2=EN, P3=luz, P4-P7=D4-D7
+class LCDModel : public I2CDevice {
+private:
+  uint8_t lastPort;
+  bool fourBitMode;
+  bool haveHighNibble;
+  uint8_t highNibble;
+  bool cgramMode;
+  uint8_t ddramAddress;
+  uint8_t cgramAddress;
+  char ddram[128];
+  uint8_t cgram[64];
+  char rowText[4][21];
+
+  void execute(uint8_t value, bool isData) {
+    if (isData) {
+      if (cgramMode) {
+        cgram[cgramAddress & 0x3F] = value;
+        cgramAddress = (cgramAddress + 1) & 0x3F;
+      } else {
+        ddram[ddramAddress & 0x7F] = (char)value;
+        ddramAddress = (ddramAddress + 1) & 0x7F;
+      }
+      return;
+    }
+
+    if (value & 0x80) {
+      ddramAddress = value & 0x7F;
+      cgramMode = false;
+    } else if (value & 0x40) {
+      cgramAddress = value & 0x3F;
+      cgramMode = true;
+    } else if (value & 0x20) {
+      fourBitMode = !(value & 0x10);
+    } else if (value == 0x01) {
+      memset(ddram, ' ', sizeof(ddram));
+      ddramAddress = 0;
+      cgramMode = false;
+    } else if ((value & 0xFE) == 0x02) {
+      ddramAddress = 0;
+      cgramMode = false;
+    }
+  }
+
+  void latch(uint8_t port) {
+    uint8_t nibble = port >> 4;
+    bool isData = port & 0x01;
+
+    if (!fourBitMode) {
+      // En modo 8 bits solo llegan D4-D7; D0-D3 quedan a cero
+      execute((uint8_t)(nibble << 4), isData);
+      haveHighNibble = false;
+      return;
+    }
+
+    if (!haveHighNibble) {
+      highNibble = nibble;
+      haveHighNibble = true;
+    } else {
+      haveHighNibble = false;
+      execute((uint8_t)((highNibble << 4) | nibble), isData);
+    }
+  }
+
+public:
+  LCDModel() : lastPort(0), fourBitMode(false), haveHighNibble(false), highNibble(0),
+               cgramMode(false), ddramAddress(0), cgramAddress(0) {
+    memset(ddram, ' ', sizeof(ddram));
+    memset(cgram, 0, sizeof(cgram));
+  }
+
+  uint8_t address() const override { return 0x27; }
+
+  void onWrite(const uint8_t* data, size_t length) override {
+    for (size_t i = 0; i < length; i++) {
+      uint8_t port = data[i];
+      // El HD44780 captura el dato en el flanco de bajada de EN
+      if ((lastPort & 0x04) && !(port & 0x04)) latch(lastPort);
+      lastPort = port;
+    }
+  }
+
+  size_t onRead(uint8_t* out, size_t length) override {
+    for (size_t i = 0; i < length; i++) out[i] = lastPort;
+    return length;
+  }
+
+  const char* row(int r) {
+    static const uint8_t rowOffsets[] = {0x00, 0x40, 0x14, 0x54};
+    if (r < 0 || r > 3) r = 0;
+    for (int c = 0; c < 20; c++) {
+      char ch = ddram[(rowOffsets[r] + c) & 0x7F];
+      rowText[r][c] = (ch >= 32 && ch < 127) ? ch : '#';
+    }
+    rowText[r][20] = 0;
+    return rowText[r];
+  }
+};
+
+static LCDModel& lcdModel() {
+  static LCDModel model;
+  return model;
+}
+
+const char* lcdRow(int row) { return lcdModel().row(row); }
+
+// Registrar dispositivos al arrancar
+static struct DeviceRegistration {
+  DeviceRegistration() {
+    attachI2CDevice(&rtcModel());
+    attachI2CDevice(&lcdModel());
+  }
+} deviceRegistration;
+
+// === SERIAL ===
+static bool echo = false;
+static std::deque<char> serialInput;
+
+void setSerialEcho(bool value) { echo = value; }
+bool serialEcho() { return echo; }
+
+void pushSerialInput(const char* text) {
+  while (*text) serialInput.push_back(*text++);
+}
+
+int serialAvailable() { return (int)serialInput.size(); }
+
+int serialRead() {
+  if (serialInput.empty()) return -1;
+  char c = serialInput.front();
+  serialInput.pop_front();
+  return (unsigned char)c;
+}
+
+// === EEPROM ===
+static uint8_t eeprom[EEPROM_BYTES];
+static uint32_t eepromWriteCount = 0;
+static struct EepromErase {
+  EepromErase() { memset(eeprom, 0xFF, sizeof(eeprom)); }
+} eepromErase;
+
+static uint32_t eepromCutAfter = 0;
+static PowerCutHandler eepromCutHandler = 0;
+static uint64_t eepromBusyUntil = 0;
+static bool eepromWriting = false;   // Escritura en curso cuyo fin aún no se notificó
+
+uint8_t* eepromData() { return eeprom; }
+uint32_t eepromWrites() { return eepromWriteCount; }
+
+void setEepromPowerCut(uint32_t afterWrites, PowerCutHandler handler) {
+  eepromCutAfter = afterWrites;
+  eepromCutHandler = handler;
+}
+
+bool eepromReady() { return virtualMicros >= eepromBusyUntil; }
+
+// Guardar el byte; el corte de luz simulado se produce con el byte ya escrito
+static void commitEepromByte(int address, uint8_t value) {
+  eeprom[address] = value;
+  eepromWriteCount++;
+  if (eepromCutHandler && eepromWriteCount >= eepromCutAfter) {
+    eepromCutHandler();
+  }
+}
+
+void eepromStartWrite(int address, uint8_t value) {
+  if (address < 0 || address >= EEPROM_BYTES) return;
+  if (!eepromReady()) advanceMicros(eepromBusyUntil - virtualMicros);
+  eepromBusyUntil = virtualMicros + 3300;
+  eepromWriting = true;
+  commitEepromByte(address, value);
+}
+
+void setEepromReadyInterrupt(InterruptHandler handler) {
+  eepromReadyHandler = handler;
+  eepromReadyPending = handler != 0 && eepromReady();
+  if (interruptsEnabled) runPendingInterrupts();
+}
+
+static uint64_t nextEepromReady() {
+  return (eepromWriting && eepromReadyHandler) ? eepromBusyUntil : UINT64_MAX;
+}
+
+static void fireEepromReady() {
+  eepromWriting = false;
+  eepromReadyPending = true;
+  if (interruptsEnabled) runPendingInterrupts();
+}
+
+bool loadEeprom(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  size_t n = fread(eeprom, 1, sizeof(eeprom), f);
+  fclose(f);
+  return n == sizeof(eeprom);
+}
+
+bool saveEeprom(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  size_t n = fwrite(eeprom, 1, sizeof(eeprom), f);
+  fclose(f);
+  return n == sizeof(eeprom);
+}
+
+} // namespace sim
+
+void EEPROMClass::write(int address, uint8_t value) {
+  // Escritura bloqueante de un byte en AVR: esperar a que termine
+  sim::eepromStartWrite(address, value);
+  sim::advanceMicros(sim::eepromBusyUntil - sim::nowMicros());
+}
@@ -0,0 +1,19 @@
+/*
+  sim_prelude.h - Cabeceras previas al sketch dentro del simulador
+
+  Incluye todo el HAL antes del código del alimentador. El sketch guarda
+  los tiempos en uint32_t (el 'unsigned long' de AVR), que también tiene
+  32 bits en PC: millis() desborda exactamente igual que en la placa.
+*/
+
+#ifndef SIM_PRELUDE_H
+#define SIM_PRELUDE_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LiquidCrystal_I2C.h>
+#include <EEPROM.h>
+#include <vector>
+#include <chrono>
+
+#endif // SIM_PRELUDE_H
@@ -0,0 +1,11 @@
+/*
+  modulos.cpp - Comprueba que compilan los módulos que el sketch no incluye
+
+  menu_system.h, display_manager.h y lcd_display.h no forman parte de
+  alimentador_peces.ino, pero se mantienen en el repositorio;
+  compilarlos aquí evita que se queden atrás.
+*/
+
+#include "sim_prelude.h"
+#include "menu_system.h"
+#include "lcd_display.h"
@@ -0,0 +1,32 @@
+# prototipos.awk - Convierte el .ino en C++ válido como hace el IDE de Arduino
+#
+# Declara todas las funciones de nivel superior antes de la primera
+# definición, para que puedan usarse antes de estar definidas.
+
+function is_definition(line) {
+  if (line !~ /^[A-Za-z_][A-Za-z0-9_:<>*& ]*[ *&][A-Za-z_][A-Za-z0-9_]*[ ]*\([^;]*\)[ ]*(const[ ]*)?\{[ ]*$/) return 0
+  if (line ~ /^(else|if|while|for|switch|return|struct|class|enum|namespace|typedef)[ (]/) return 0
+  return 1
+}
+
+{
+  lines[NR] = $0
+  if (!first && is_definition($0)) first = NR
+  if (is_definition($0)) {
+    proto = $0
+    sub(/[ ]*\{[ ]*$/, ";", proto)
+    gsub(/[ ]*=[^,)]*/, "", proto)
+    protos[++nprotos] = proto
+  }
+}
+
+END {
+  printf "#line 1 \"%s\"\n", FILENAME
+  for (i = 1; i <= NR; i++) {
+    if (i == first) {
+      for (j = 1; j <= nprotos; j++) print protos[j]
+      printf "#line %d \"%s\"\n", i, FILENAME
+    }
+    print lines[i]
+  }
+}
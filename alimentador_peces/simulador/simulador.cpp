@@ -0,0 +1,484 @@
+/*
+  simulador.cpp - Ejecuta alimentador_peces.ino en PC con reloj virtual
+
+  Compila el sketch completo contra el HAL simulado (hal/) y lo hace
+  correr durante días o años de tiempo virtual. En modo rápido, cuando
+  el sistema está en reposo, el reloj salta directamente al siguiente
+  evento pendiente (horario, pulsación programada) en vez de avanzar
+  de tarea en tarea.
+
+  Uso:
+    ./build/simulador [--dias N] [--rapido] [--inicio AAAA-MM-DDTHH:MM:SS]
+                      [--millis N] [--boton SEG:NOMBRE[:MS]] [--comando SEG:TEXTO] [--serial]
+                      [--lcd] [--eeprom ARCHIVO] [--corte-eeprom N] [--rtc-sin-hora]
+                      [--atasco-i2c SEG]
+    ./build/simulador --bench-lcd
+*/
+
+#include "sim_prelude.h"
+#include "alimentador_peces.ino.cpp"
+#include <LiquidCrystal_I2C.h>
+
+// === CONFIGURACIÓN DE LA SIMULACIÓN ===
+const uint64_t SIM_LEAD_MICROS = 2000000ULL;   // Margen antes de cada evento al saltar
+const uint64_t SIM_SECOND = 1000000ULL;
+
+struct PulsacionProgramada {
+  uint64_t inicioUs;      // Instante virtual de la pulsación
+  uint64_t finUs;         // Instante virtual de la liberación
+  int pin;
+  bool presionado;
+  bool liberado;
+};
+
+struct ComandoProgramado {
+  uint64_t instanteUs;    // Instante virtual en que llega la línea
+  std::string texto;
+  bool enviado;
+};
+
+static std::vector<PulsacionProgramada> pulsaciones;
+static std::vector<ComandoProgramado> comandos;
+static bool mostrarLcd = false;
+
+// Estadísticas de alimentación: el LED marca cada alimentación y los
+// flancos de cada relay su dosis (del primer encendido al último corte)
+static const int pinesRelay[RELAY_CHANNELS] = {RELAY_1_PIN, RELAY_2_PIN, RELAY_3_PIN, RELAY_4_PIN};
+static bool ledEncendido = false;
+static bool relayEncendido[RELAY_CHANNELS] = {false};
+static bool relayUsado[RELAY_CHANNELS] = {false};
+static uint64_t relayOnUs[RELAY_CHANNELS] = {0};
+static uint64_t relayOffUs[RELAY_CHANNELS] = {0};
+static uint64_t ultimoArranqueUs = 0;
+static uint64_t separacionMinimaUs = UINT64_MAX;
+static uint32_t pulsosRelay = 0;
+static uint64_t ultimaAlimentacionEpochUs = 0;
+static uint32_t alimentaciones = 0;
+static uint32_t dosis = 0;
+static uint64_t duracionTotalUs = 0;
+static uint64_t duracionMaximaUs = 0;
+
+// Latencia de la alarma 1 del DS3231 al primer relay que arranca
+static uint32_t alarmasAtendidas = 0;
+static uint64_t latenciaAlarmaTotalUs = 0;
+static uint64_t latenciaAlarmaMaxUs = 0;
+
+// Imprimir una fecha del DS3231 virtual
+static void imprimirFecha(uint32_t epoch) {
+  DateTime t(epoch);
+  printf("%04u-%02u-%02u %02u:%02u:%02u", t.year(), t.month(), t.day(),
+         t.hour(), t.minute(), t.second());
+}
+
+static void imprimirLcd() {
+  printf("  +--------------------+\n");
+  for (int r = 0; r < 4; r++) printf("  |%s|\n", sim::lcdRow(r));
+  printf("  +--------------------+\n");
+}
+
+// Flanco de un relay: el primer encendido de cada alimentación abre su
+// dosis (y mide la separación con el arranque anterior), cada apagado la cierra
+static void alCambiarRelay(int canal, bool encendido) {
+  if (encendido == relayEncendido[canal]) return;
+  relayEncendido[canal] = encendido;
+  uint64_t ahora = sim::nowMicros();
+
+  if (!encendido) {
+    relayOffUs[canal] = ahora;
+    return;
+  }
+  pulsosRelay++;
+  if (sim::rtcAlarmCount() > alarmasAtendidas) {
+    alarmasAtendidas = sim::rtcAlarmCount();
+    uint64_t latencia = ahora - sim::rtcLastAlarmMicros();
+    latenciaAlarmaTotalUs += latencia;
+    if (latencia > latenciaAlarmaMaxUs) latenciaAlarmaMaxUs = latencia;
+  }
+  if (relayUsado[canal]) return;
+  relayUsado[canal] = true;
+  relayOnUs[canal] = ahora;
+  if (ultimoArranqueUs && ahora - ultimoArranqueUs < separacionMinimaUs) {
+    separacionMinimaUs = ahora - ultimoArranqueUs;
+  }
+  ultimoArranqueUs = ahora;
+}
+
+// Registrar inicio y fin de cada alimentación
+static void alEscribirPin(int pin, int level) {
+  bool encendido = level == HIGH;
+  for (int canal = 0; canal < RELAY_CHANNELS; canal++) {
+    if (pin == pinesRelay[canal]) {
+      alCambiarRelay(canal, encendido);
+      return;
+    }
+  }
+  if (pin != LED_PIN || encendido == ledEncendido) return;
+  ledEncendido = encendido;
+
+  if (encendido) {
+    ultimaAlimentacionEpochUs = sim::rtcEpochMicros();
+    if (mostrarLcd) {
+      printf("[");
+      imprimirFecha(sim::rtcEpoch());
+      printf("] Alimentación #%u\n", alimentaciones + 1);
+    }
+  } else {
+    alimentaciones++;
+    for (int canal = 0; canal < RELAY_CHANNELS; canal++) {
+      if (!relayUsado[canal]) continue;
+      relayUsado[canal] = false;
+      uint64_t duracion = relayOffUs[canal] - relayOnUs[canal];
+      dosis++;
+      duracionTotalUs += duracion;
+      if (duracion > duracionMaximaUs) duracionMaximaUs = duracion;
+    }
+    ultimoArranqueUs = 0;
+  }
+}
+
+static int pinDeBoton(const char* nombre) {
+  if (strcmp(nombre, "select") == 0) return BUTTON_SELECT_PIN;
+  if (strcmp(nombre, "up") == 0) return BUTTON_UP_PIN;
+  if (strcmp(nombre, "down") == 0) return BUTTON_DOWN_PIN;
+  if (strcmp(nombre, "confirm") == 0) return BUTTON_CONFIRM_PIN;
+  return -1;
+}
+
+// Marcar las pulsaciones cuyo instante ya pasó (el HAL cambia el nivel
+// del pin en el instante exacto, aunque sea en medio de un delay())
+static void marcarPulsaciones() {
+  uint64_t ahora = sim::nowMicros();
+  for (size_t i = 0; i < pulsaciones.size(); i++) {
+    PulsacionProgramada& p = pulsaciones[i];
+    if (ahora >= p.inicioUs) p.presionado = true;
+    if (ahora >= p.finUs) p.liberado = true;
+  }
+}
+
+// Entregar al puerto serie los comandos cuyo instante ya pasó
+static void enviarComandos() {
+  uint64_t ahora = sim::nowMicros();
+  for (size_t i = 0; i < comandos.size(); i++) {
+    ComandoProgramado& c = comandos[i];
+    if (c.enviado || ahora < c.instanteUs) continue;
+    c.enviado = true;
+    sim::pushSerialInput(c.texto.c_str());
+    sim::pushSerialInput("\n");
+  }
+}
+
+// El sketch no duerme más allá del próximo comando serie ni del final
+static uint64_t limiteDeSueno(uint64_t finUs) {
+  uint64_t limite = finUs;
+  for (size_t i = 0; i < comandos.size(); i++) {
+    if (!comandos[i].enviado && comandos[i].instanteUs < limite) limite = comandos[i].instanteUs;
+  }
+  return limite;
+}
+
+// Micros desde 'ahora' hasta el siguiente minuto programado; -1 si hay uno en curso sin disparar
+static int64_t microsHastaHorario() {
+  uint64_t ahoraUs = sim::rtcEpochMicros();
+  uint64_t mejor = UINT64_MAX;
+  uint64_t inicioDia = (ahoraUs / (86400 * SIM_SECOND)) * 86400 * SIM_SECOND;
+
+  for (int i = 1; i <= MAX_FEED_TIMES; i++) {
+    FeedTime horario = scheduleManager.getSchedule(i);
+    if (!horario.enabled) continue;
+
+    uint64_t objetivo = inicioDia + (uint64_t)(horario.hour * 3600 + horario.minute * 60) * SIM_SECOND;
+    bool enCurso = ahoraUs >= objetivo && ahoraUs < objetivo + 60 * SIM_SECOND;
+    if (enCurso && ultimaAlimentacionEpochUs < objetivo) return -1;
+    if (objetivo <= ahoraUs) objetivo += 86400 * SIM_SECOND;
+    if (objetivo - ahoraUs < mejor) mejor = objetivo - ahoraUs;
+  }
+  return mejor == UINT64_MAX ? INT64_MAX : (int64_t)mejor;
+}
+
+// El sketch no tiene nada que hacer hasta el próximo evento
+static bool sistemaEnReposo() {
+  return currentState == MENU_CLOCK && !inMenu && !relayController.isFeedingActive() && feedQueue.isEmpty();
+}
+
+// Saltar el reloj virtual hasta poco antes del siguiente evento
+static void avanzarHastaEvento(uint64_t finUs) {
+  uint64_t ahora = sim::nowMicros();
+  int64_t hastaHorario = microsHastaHorario();
+  if (hastaHorario < 0) return;
+
+  uint64_t objetivo = (hastaHorario == INT64_MAX) ? finUs : ahora + (uint64_t)hastaHorario;
+  for (size_t i = 0; i < pulsaciones.size(); i++) {
+    const PulsacionProgramada& p = pulsaciones[i];
+    if (!p.presionado && p.inicioUs < objetivo) objetivo = p.inicioUs;
+    if (p.presionado && !p.liberado) return;
+  }
+  for (size_t i = 0; i < comandos.size(); i++) {
+    if (!comandos[i].enviado && comandos[i].instanteUs < objetivo) objetivo = comandos[i].instanteUs;
+  }
+  if (objetivo > finUs) objetivo = finUs;
+
+  if (objetivo > ahora + SIM_LEAD_MICROS + SIM_SECOND) {
+    sim::advanceMicros(objetivo - SIM_LEAD_MICROS - ahora);
+  }
+}
+
+// Alimentaciones esperadas según los horarios (minutos distintos) en [inicio, fin).
+// Un minuto programado ya empezado al arrancar también cuenta, igual que en el sketch.
+static uint32_t alimentacionesEsperadas(uint32_t inicio, uint32_t fin) {
+  bool minutos[24 * 60] = {false};
+  for (int i = 1; i <= MAX_FEED_TIMES; i++) {
+    FeedTime horario = scheduleManager.getSchedule(i);
+    if (horario.enabled) minutos[horario.hour * 60 + horario.minute] = true;
+  }
+
+  uint32_t total = 0;
+  for (uint32_t dia = inicio - inicio % 86400; dia < fin; dia += 86400) {
+    for (int m = 0; m < 24 * 60; m++) {
+      uint32_t t = dia + m * 60;
+      if (minutos[m] && t + 60 > inicio && t + 1 < fin) total++;
+    }
+  }
+  return total;
+}
+
+static bool leerFecha(const char* texto, uint32_t& epoch) {
+  int y, mo, d, h, mi, s;
+  if (sscanf(texto, "%d-%d-%dT%d:%d:%d", &y, &mo, &d, &h, &mi, &s) != 6) return false;
+  epoch = DateTime(y, mo, d, h, mi, s).unixtime();
+  return true;
+}
+
+// === BENCHMARK DEL LCD ===
+// Escribe pantallas completas con la librería y con el driver agrupado
+// y mide caracteres por segundo en tiempo virtual (I2C a 100 kHz)
+template <class LCD>
+static bool medirLcd(const char* nombre, LCD& lcd, bool porCaracter) {
+  static const char* lineas[4] = {"    12:34:56        ", "===== MENU =====    ",
+                                  ">Alimentar Ahora    ", "Proximo: 08:00 H1   "};
+  const int repeticiones = 50;
+
+  lcd.init();
+  lcd.backlight();
+  sim::resetI2CStats();
+  uint64_t inicioUs = sim::nowMicros();
+  for (int i = 0; i < repeticiones; i++) {
+    for (int fila = 0; fila < 4; fila++) {
+      lcd.setCursor(0, fila);
+      if (porCaracter) {
+        for (const char* c = lineas[fila]; *c; c++) lcd.write((uint8_t)*c);
+      } else {
+        lcd.print(lineas[fila]);
+      }
+    }
+  }
+  // El driver agrupado termina de enviar en segundo plano
+  while (!twiBus.isIdle()) sim::advanceMicros(10);
+  double segundos = (sim::nowMicros() - inicioUs) / 1e6;
+  sim::I2CStats i2c = sim::i2cStats(LCD_ADDRESS);
+  double caracteres = repeticiones * 80.0;
+
+  bool correcto = true;
+  for (int fila = 0; fila < 4; fila++) {
+    if (strcmp(sim::lcdRow(fila), lineas[fila]) != 0) correcto = false;
+  }
+  printf("%-24s %7.0f car/s  %5.2f transacciones/car  %5.2f bytes/car  %s\n", nombre,
+         caracteres / segundos, i2c.transactions / caracteres, i2c.bytes / caracteres,
+         correcto ? "ok" : "PANTALLA INCORRECTA");
+  return correcto;
+}
+
+static int benchLcd() {
+  LiquidCrystal_I2C libreria(LCD_ADDRESS, LCD_COLUMNS, LCD_ROWS);
+  LCDPCF8574 driver(LCD_ADDRESS, LCD_COLUMNS, LCD_ROWS);
+  bool correcto = true;
+
+  printf("=== LCD 20x4 por PCF8574 (I2C 100 kHz, 4 filas + setCursor) ===\n");
+  correcto &= medirLcd("LiquidCrystal_I2C", libreria, false);
+  correcto &= medirLcd("LCDPCF8574 (print)", driver, false);
+  correcto &= medirLcd("LCDPCF8574 (write 1 a 1)", driver, true);
+  return correcto ? 0 : 1;
+}
+
+static void uso() {
+  printf("Uso: simulador [--dias N] [--rapido] [--inicio AAAA-MM-DDTHH:MM:SS]\n"
+         "                [--millis N] [--boton SEG:select|up|down|confirm[:MS]]\n"
+         "                [--comando SEG:TEXTO]\n"
+         "                [--serial] [--lcd] [--eeprom ARCHIVO] [--corte-eeprom N]\n"
+         "                [--rtc-sin-hora] [--atasco-i2c SEG]\n"
+         "       simulador --bench-lcd\n");
+}
+
+// Archivo de EEPROM a conservar si se simula un corte de luz
+static const char* archivoEepromCorte = 0;
+
+static void cortarLuz() {
+  printf("\n*** CORTE DE LUZ tras %u escrituras de EEPROM ***\n", sim::eepromWrites());
+  if (archivoEepromCorte) sim::saveEeprom(archivoEepromCorte);
+  exit(3);
+}
+
+int main(int argc, char** argv) {
+  double dias = 1;
+  bool rapido = false;
+  const char* archivoEeprom = 0;
+  uint32_t inicioEpoch = DateTime(2024, 1, 1, 0, 0, 0).unixtime();
+
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool hayValor = i + 1 < argc;
+    if (strcmp(arg, "--dias") == 0 && hayValor) {
+      dias = atof(argv[++i]);
+    } else if (strcmp(arg, "--rapido") == 0) {
+      rapido = true;
+    } else if (strcmp(arg, "--inicio") == 0 && hayValor) {
+      if (!leerFecha(argv[++i], inicioEpoch)) { uso(); return 2; }
+    } else if (strcmp(arg, "--millis") == 0 && hayValor) {
+      sim::setMillisOffset((uint32_t)strtoul(argv[++i], 0, 10));
+    } else if (strcmp(arg, "--boton") == 0 && hayValor) {
+      char nombre[16] = {0};
+      double segundos = 0;
+      unsigned ms = 120;
+      if (sscanf(argv[++i], "%lf:%15[a-z]:%u", &segundos, nombre, &ms) < 2 || pinDeBoton(nombre) < 0) {
+        uso();
+        return 2;
+      }
+      PulsacionProgramada p;
+      p.inicioUs = (uint64_t)(segundos * SIM_SECOND);
+      p.finUs = p.inicioUs + (uint64_t)ms * 1000;
+      p.pin = pinDeBoton(nombre);
+      p.presionado = false;
+      p.liberado = false;
+      pulsaciones.push_back(p);
+      sim::scheduleInputLevel(p.pin, LOW, p.inicioUs);
+      sim::scheduleInputLevel(p.pin, HIGH, p.finUs);
+    } else if (strcmp(arg, "--comando") == 0 && hayValor) {
+      const char* valor = argv[++i];
+      const char* texto = strchr(valor, ':');
+      if (!texto) { uso(); return 2; }
+      ComandoProgramado c;
+      c.instanteUs = (uint64_t)(atof(valor) * SIM_SECOND);
+      c.texto = texto + 1;
+      c.enviado = false;
+      comandos.push_back(c);
+    } else if (strcmp(arg, "--serial") == 0) {
+      sim::setSerialEcho(true);
+    } else if (strcmp(arg, "--lcd") == 0) {
+      mostrarLcd = true;
+    } else if (strcmp(arg, "--eeprom") == 0 && hayValor) {
+      archivoEeprom = argv[++i];
+      sim::loadEeprom(archivoEeprom);
+    } else if (strcmp(arg, "--corte-eeprom") == 0 && hayValor) {
+      sim::setEepromPowerCut((uint32_t)strtoul(argv[++i], 0, 10), cortarLuz);
+    } else if (strcmp(arg, "--rtc-sin-hora") == 0) {
+      sim::setRtcLostPower(true);
+    } else if (strcmp(arg, "--atasco-i2c") == 0 && hayValor) {
+      sim::jamI2CAt((uint64_t)(atof(argv[++i]) * SIM_SECOND));
+    } else if (strcmp(arg, "--bench-lcd") == 0) {
+      return benchLcd();
+    } else {
+      uso();
+      return 2;
+    }
+  }
+
+  archivoEepromCorte = archivoEeprom;
+  sim::setRtcEpoch(inicioEpoch);
+  sim::connectRtcSqw(RTC_SQW_PIN);
+  sim::setPinWriteHook(alEscribirPin);
+
+  std::chrono::steady_clock::time_point relojInicio = std::chrono::steady_clock::now();
+  uint64_t finUs = (uint64_t)(dias * 86400.0 * SIM_SECOND);
+  uint32_t epochInicial = sim::rtcEpoch();
+  uint64_t pasadas = 0;
+  uint64_t pasadaMaxUs = 0;
+
+  setup();
+  while (sim::nowMicros() < finUs) {
+    marcarPulsaciones();
+    if (rapido && sistemaEnReposo()) {
+      avanzarHastaEvento(finUs);
+      marcarPulsaciones();
+    }
+    enviarComandos();
+    sim::setSleepLimit(limiteDeSueno(finUs));
+    // Duración de la pasada sin contar la espera de delay() del propio loop
+    uint64_t inicioUs = sim::nowMicros();
+    uint64_t esperaUs = sim::delayedMicros();
+    loop();
+    uint64_t trabajoUs = (sim::nowMicros() - inicioUs) - (sim::delayedMicros() - esperaUs);
+    if (trabajoUs > pasadaMaxUs) pasadaMaxUs = trabajoUs;
+    pasadas++;
+  }
+
+  double segundosReales = std::chrono::duration<double>(std::chrono::steady_clock::now() - relojInicio).count();
+  uint32_t epochFinal = sim::rtcEpoch();
+  uint32_t esperadas = alimentacionesEsperadas(epochInicial, epochFinal);
+  double segundosVirtuales = sim::nowMicros() / 1e6;
+
+  sim::I2CStats rtc = sim::i2cStats(sim::DS3231_ADDRESS);
+  sim::I2CStats lcd = sim::i2cStats(LCD_ADDRESS);
+
+  if (mostrarLcd) imprimirLcd();
+  printf("\n=== RESUMEN DE LA SIMULACIÓN ===\n");
+  printf("Desde:              "); imprimirFecha(epochInicial); printf("\n");
+  printf("Hasta:              "); imprimirFecha(epochFinal); printf("\n");
+  printf("Tiempo simulado:    %.0f s (%.2f días)\n", segundosVirtuales, segundosVirtuales / 86400.0);
+  printf("Tiempo real:        %.3f s (x%.0f)\n", segundosReales,
+         segundosReales > 0 ? segundosVirtuales / segundosReales : 0.0);
+  printf("Pasadas de loop():  %llu\n", (unsigned long long)pasadas);
+  printf("Pasada más larga:   %.1f ms (sin contar delay())\n", pasadaMaxUs / 1000.0);
+  printf("millis() final:     %u\n", (unsigned)millis());
+  if (USE_POWER_SAVE) {
+    unsigned duty = powerManager.getDutyCycle();
+    if (rapido) {
+      // Los saltos avanzan millis() como si el MCU siguiera despierto: ni
+      // el tiempo dormido ni el ciclo de trabajo del sketch dicen nada
+      printf("Dormido:            n/a en modo rápido, %u sueños\n", (unsigned)powerManager.getSleepCount());
+    } else {
+      printf("Dormido:            %.1f%% del tiempo, %u sueños (despierto según el sketch: %u.%u%%)\n",
+             100.0 * sim::sleptMicros() / sim::nowMicros(), (unsigned)powerManager.getSleepCount(), duty / 10, duty % 10);
+    }
+    printf("Despertares:        %u botón/serie, %u RTC, %u watchdog\n", (unsigned)powerManager.getPinWakeCount(),
+           (unsigned)powerManager.getRtcWakeCount(), (unsigned)powerManager.getWatchdogWakeCount());
+  }
+  printf("Alimentaciones:     %u de %u esperadas\n", alimentaciones, esperadas);
+  if (dosis > 0) {
+    printf("Duración media:     %.3f s por relay (máx %.3f s, configurada %d s)\n",
+           duracionTotalUs / 1e6 / dosis, duracionMaximaUs / 1e6, FEED_DURATION);
+    if (separacionMinimaUs != UINT64_MAX) {
+      printf("Arranques:          %u dosis, separación mínima %.3f s (configurada %.3f s)\n", dosis,
+             separacionMinimaUs / 1e6, RELAY_STAGGER_MS / 1e3);
+    }
+    if (FEED_PULSE_OFF_MS > 0) {
+      printf("Pulsos de relays:   %u (%u ms encendido, %u ms apagado)\n", pulsosRelay,
+             (unsigned)FEED_PULSE_ON_MS, (unsigned)FEED_PULSE_OFF_MS);
+    }
+  }
+  if (sim::rtcAlarmCount() > 0) {
+    printf("Alarmas RTC:        %u, relay en marcha a %.3f ms (máx %.3f ms)\n", sim::rtcAlarmCount(),
+           alarmasAtendidas ? latenciaAlarmaTotalUs / 1e3 / alarmasAtendidas : 0.0, latenciaAlarmaMaxUs / 1e3);
+  }
+  printf("I2C DS3231:         %u transacciones, %u bytes (RTCManager: %u)\n", rtc.transactions, rtc.bytes,
+         (unsigned)rtcManager.getI2CTransactionCount());
+  printf("I2C LCD:            %u transacciones, %u bytes\n", lcd.transactions, lcd.bytes);
+  for (uint8_t i = 0; i < twiBus.getDeviceCount(); i++) {
+    const TWIDeviceStats* twi = twiBus.getDeviceStats(i);
+    printf("TWI 0x%02X:           %u trabajos, latencia media %u us (máx %u us), %u errores, %u timeouts\n",
+           twi->address, (unsigned)twi->jobs, (unsigned)(twi->jobs ? twi->totalLatency / twi->jobs : 0),
+           (unsigned)twi->maxLatency, (unsigned)twi->errors, (unsigned)twi->timeouts);
+  }
+  printf("LCD HD44780:        %u frames, %u bytes (último frame %u en %u pasadas, %u pendientes)\n",
+         (unsigned)lcdDisplay.getFrameCount(), (unsigned)lcdDisplay.getTotalBytes(), lcdDisplay.getLastFrameBytes(),
+         lcdDisplay.getLastFramePasses(), lcdDisplay.getFramesPending());
+  printf("Escrituras EEPROM:  %u\n", sim::eepromWrites());
+  printf("================================\n");
+
+  // Terminar las escrituras en cola antes de conservar la EEPROM
+  if (archivoEeprom) {
+    scheduleManager.getStore().flush();
+    sim::saveEeprom(archivoEeprom);
+  }
+
+  // Sin pulsaciones ni comandos programados toda diferencia es un fallo
+  return (pulsaciones.empty() && comandos.empty() && alimentaciones != esperadas) ? 1 : 0;
+}
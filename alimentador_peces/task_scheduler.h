@@ -0,0 +1,196 @@
+/*
+  task_scheduler.h - Tareas periódicas del loop
+  
+  Reemplaza la pasada fija de LOOP_DELAY (hacer todo y esperar con
+  delay() hasta completar 100 ms) por una tabla estática de tareas, cada
+  una con su período, su fase y su plazo. dispatch() corre en cada pasada
+  las tareas que vencieron, en el orden de la tabla, y getTimeToNextDue()
+  dice cuánto se puede dormir hasta la próxima.
+
+  El próximo vencimiento se cuenta desde el anterior y no desde que la
+  tarea terminó, así que el período no acumula deriva; la fase reparte
+  el primer vencimiento para que las tareas no coincidan en la misma
+  pasada. Si una tarea se atrasa más de un período no se repite para
+  ponerse al día: sigue en su fase con el vencimiento siguiente.
+
+  Una tarea puede correr además a pedido: si ready() retorna true corre
+  en esa pasada aunque no haya vencido, y su período vuelve a contar
+  desde ahí (período 0 = solo a pedido). Por cada tarea se cuentan las
+  corridas, los plazos perdidos (empezó más de 'deadline' ms después de
+  vencer) y el atraso (jitter) medio y máximo con micros().
+*/
+
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include "config.h"
+
+typedef void (*TaskFunction)();
+typedef bool (*TaskReady)();
+
+// Configuración de una tarea: la tabla es const y va en flash (PROGMEM),
+// así que se lee con pgm_read_word() y pgm_read_ptr()
+struct TaskConfig {
+  const char* name;
+  TaskFunction run;
+  TaskReady ready;              // Pedido fuera de período (0 = ninguno)
+  uint16_t period;              // ms (0 = solo a pedido)
+  uint16_t phase;               // ms hasta el primer vencimiento
+  uint16_t deadline;            // Atraso tolerado en ms
+};
+
+// Estado de una tarea en el despachador (RAM, empieza en 0)
+struct TaskState {
+  uint32_t due;                 // micros() del próximo vencimiento
+  uint32_t runs;                // Corridas (por período y a pedido)
+  uint32_t demanded;            // Corridas a pedido
+  uint32_t misses;              // Plazos perdidos
+  uint32_t maxJitterUs;         // Mayor atraso al vencer
+  uint32_t jitterSumUs;         // Suma de atrasos (media = suma / cuenta)
+  uint32_t jitterCount;
+};
+
+class TaskScheduler {
+private:
+  const TaskConfig* configs;    // En flash
+  TaskState* states;
+  uint8_t count;
+
+  uint16_t periodOf(uint8_t index) {
+    return pgm_read_word(&configs[index].period);
+  }
+
+  uint16_t phaseOf(uint8_t index) {
+    return pgm_read_word(&configs[index].phase);
+  }
+
+  // Microsegundos hasta el vencimiento (0 = ya venció). Un vencimiento
+  // más adelante que el período o la fase no puede ser legítimo: el
+  // loop estuvo detenido más de media vuelta de micros() (35 minutos) y
+  // la tarea se da por vencida
+  uint32_t timeToDue(uint8_t index, uint32_t now) {
+    uint32_t ahead = states[index].due - now;
+    uint32_t limit = (uint32_t)max(periodOf(index), phaseOf(index)) * 1000UL;
+    return ahead > limit ? 0 : ahead;
+  }
+
+  bool isDue(uint8_t index, uint32_t now) {
+    return periodOf(index) > 0 && timeToDue(index, now) == 0;
+  }
+
+  // Atraso de una corrida por período; el próximo vencimiento sigue la
+  // fase aunque se haya perdido más de uno
+  void recordDueRun(uint8_t index, uint32_t now) {
+    TaskState& task = states[index];
+    uint32_t late = now - task.due;
+    if (late > task.maxJitterUs) task.maxJitterUs = late;
+    if (late > (uint32_t)pgm_read_word(&configs[index].deadline) * 1000UL) task.misses++;
+    
+    // Como en LoopProfiler: partir la suma antes de que desborde
+    if (task.jitterSumUs > 0xFFFFFFFFUL - late) {
+      task.jitterSumUs >>= 1;
+      task.jitterCount >>= 1;
+    }
+    task.jitterSumUs += late;
+    task.jitterCount++;
+    
+    uint32_t periodUs = (uint32_t)periodOf(index) * 1000UL;
+    task.due += (late / periodUs + 1) * periodUs;
+  }
+
+public:
+  // Constructor: 'table' en flash y 'state' con una entrada por tarea
+  TaskScheduler(const TaskConfig* table, TaskState* state, uint8_t taskCount)
+    : configs(table), states(state), count(taskCount) {}
+
+  // Primer vencimiento de cada tarea según su fase
+  void begin() {
+    uint32_t now = micros();
+    for (uint8_t i = 0; i < count; i++) {
+      states[i].due = now + (uint32_t)phaseOf(i) * 1000UL;
+    }
+  }
+
+  // Correr las tareas vencidas o pedidas (cada pasada del loop)
+  void dispatch() {
+    for (uint8_t i = 0; i < count; i++) {
+      TaskState& task = states[i];
+      TaskReady ready = (TaskReady)pgm_read_ptr(&configs[i].ready);
+      uint32_t now = micros();
+      
+      if (isDue(i, now)) {
+        recordDueRun(i, now);
+      } else if (ready && ready()) {
+        task.demanded++;
+        task.due = now + (uint32_t)periodOf(i) * 1000UL;
+      } else {
+        continue;
+      }
+      task.runs++;
+      ((TaskFunction)pgm_read_ptr(&configs[i].run))();
+    }
+  }
+
+  // Microsegundos hasta la próxima tarea periódica (0 = ya vence alguna).
+  // Las tareas a pedido dependen de interrupciones, que despiertan al MCU
+  uint32_t getTimeToNextDue() {
+    uint32_t now = micros();
+    uint32_t wait = 0xFFFFFFFFUL;
+    for (uint8_t i = 0; i < count; i++) {
+      if (periodOf(i) == 0) continue;
+      uint32_t ahead = timeToDue(i, now);
+      if (ahead < wait) wait = ahead;
+    }
+    return wait;
+  }
+
+  // Borrar las estadísticas (los vencimientos siguen igual)
+  void resetStats() {
+    for (uint8_t i = 0; i < count; i++) {
+      uint32_t due = states[i].due;
+      memset(&states[i], 0, sizeof(TaskState));
+      states[i].due = due;
+    }
+  }
+
+  uint8_t getTaskCount() {
+    return count;
+  }
+
+  const TaskState& getTaskState(uint8_t index) {
+    return states[index];
+  }
+
+  const char* getTaskName(uint8_t index) {
+    return (const char*)pgm_read_ptr(&configs[index].name);
+  }
+
+  // Mostrar las tareas por Serial
+  void displayTasks() {
+    Serial.println(F("\n=== Tareas del Loop ==="));
+    for (uint8_t i = 0; i < count; i++) {
+      const TaskState& task = states[i];
+      Serial.print(getTaskName(i));
+      Serial.print(F(": "));
+      if (periodOf(i) > 0) {
+        Serial.print(periodOf(i));
+        Serial.print(F(" ms, "));
+      } else {
+        Serial.print(F("a pedido, "));
+      }
+      Serial.print(task.runs);
+      Serial.print(F(" corridas ("));
+      Serial.print(task.demanded);
+      Serial.print(F(" a pedido), "));
+      Serial.print(task.misses);
+      Serial.print(F(" plazos perdidos, atraso medio "));
+      Serial.print(task.jitterCount ? task.jitterSumUs / task.jitterCount : 0);
+      Serial.print(F(" us (máx "));
+      Serial.print(task.maxJitterUs);
+      Serial.println(F(" us)"));
+    }
+    Serial.println(F("======================="));
+  }
+};
+
+#endif // TASK_SCHEDULER_H
@@ -0,0 +1,373 @@
+/*
+  twi_engine.h - Cola de transacciones I2C atendida por la interrupción TWI
+  
+  El DS3231 y el LCD comparten el bus I2C. Con Wire cada transacción
+  bloquea la CPU hasta que termina; aquí cada módulo arma un TWIJob
+  (dirección, bytes a escribir, bytes a leer) y lo entrega con submit(),
+  que retorna enseguida. La interrupción TWI recorre la transacción
+  completa (START, escritura, START repetido, lectura, STOP) y al
+  terminar marca el estado del trabajo, llama a su callback y arranca el
+  siguiente de la cola sin pasar por loop().
+
+  Hay dos colas: TWI_PRIORITY_HIGH (lecturas y escrituras del RTC) se
+  atiende antes que TWI_PRIORITY_LOW (envíos del LCD); un trabajo en
+  curso no se interrumpe. update(), llamado en cada pasada del loop,
+  aborta el trabajo que supere TWI_TIMEOUT, libera el bus (hasta 9
+  pulsos de SCL por si un esclavo quedó reteniendo SDA) y sigue con la
+  cola. Por dispositivo se cuentan trabajos, errores, timeouts y la
+  latencia desde submit() hasta el final.
+
+  Este módulo reemplaza a Wire: las dos librerías no pueden convivir en
+  el mismo sketch porque ambas definen la ISR del TWI.
+*/
+
+#ifndef TWI_ENGINE_H
+#define TWI_ENGINE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#if defined(__AVR__)
+#include <util/twi.h>
+#else
+#include <Wire.h>
+#endif
+
+// Estado de un trabajo
+const uint8_t TWI_JOB_IDLE = 0;        // Nunca enviado
+const uint8_t TWI_JOB_QUEUED = 1;      // En cola
+const uint8_t TWI_JOB_ACTIVE = 2;      // En el bus
+const uint8_t TWI_JOB_DONE = 3;        // Terminado sin errores
+const uint8_t TWI_JOB_NACK = 4;        // El dispositivo no respondió
+const uint8_t TWI_JOB_BUS_ERROR = 5;   // Error de bus o arbitraje perdido
+const uint8_t TWI_JOB_TIMEOUT = 6;     // Abortado por update()
+
+// Prioridad de un trabajo
+const uint8_t TWI_PRIORITY_HIGH = 0;
+const uint8_t TWI_PRIORITY_LOW = 1;
+
+struct TWIJob;
+typedef void (*TWICallback)(TWIJob* job);
+
+// Transacción I2C: primero escribe txData y luego lee rxLength bytes
+// (con START repetido). Los buffers deben seguir vivos hasta el final.
+struct TWIJob {
+  uint8_t address;
+  uint8_t priority;
+  const uint8_t* txData;
+  uint8_t txLength;
+  uint8_t* rxData;
+  uint8_t rxLength;
+  TWICallback onComplete;      // Se llama desde la interrupción (debe ser breve)
+  volatile uint8_t status;
+  uint32_t submitMicros;
+  TWIJob* next;
+};
+
+// Estadísticas por dispositivo
+struct TWIDeviceStats {
+  uint8_t address;
+  uint32_t jobs;               // Trabajos terminados (con o sin error)
+  uint32_t errors;             // NACK y errores de bus
+  uint32_t timeouts;
+  uint32_t totalLatency;       // Suma de latencias (us)
+  uint32_t maxLatency;         // Latencia más alta (us)
+};
+
+// Colas por prioridad y trabajo en curso
+static TWIJob* twiQueueHead[2] = {0, 0};
+static TWIJob* twiQueueTail[2] = {0, 0};
+static TWIJob* volatile twiActive = 0;
+static uint32_t twiActiveSince = 0;        // millis() al empezar el trabajo en curso
+static uint8_t twiIndex = 0;               // Próximo byte a escribir o leer
+static bool twiReading = false;            // En la fase de lectura
+static bool twiStarted = false;
+static TWIDeviceStats twiStats[TWI_MAX_DEVICES];
+static uint8_t twiDeviceCount = 0;
+
+// Entrada de estadísticas de un dispositivo (la crea si hay lugar)
+static TWIDeviceStats* twiDeviceStats(uint8_t address) {
+  for (uint8_t i = 0; i < twiDeviceCount; i++) {
+    if (twiStats[i].address == address) {
+      return &twiStats[i];
+    }
+  }
+  if (twiDeviceCount >= TWI_MAX_DEVICES) return 0;
+  TWIDeviceStats* stats = &twiStats[twiDeviceCount++];
+  memset(stats, 0, sizeof(TWIDeviceStats));
+  stats->address = address;
+  return stats;
+}
+
+// Sacar de la cola el próximo trabajo (primero la prioridad alta);
+// retorna true si hay uno para arrancar
+static bool twiNextJob() {
+  for (uint8_t priority = 0; priority < 2; priority++) {
+    TWIJob* job = twiQueueHead[priority];
+    if (!job) continue;
+    
+    twiQueueHead[priority] = job->next;
+    if (!job->next) {
+      twiQueueTail[priority] = 0;
+    }
+    job->next = 0;
+    job->status = TWI_JOB_ACTIVE;
+    twiActive = job;
+    twiActiveSince = millis();
+    twiIndex = 0;
+    twiReading = job->txLength == 0;
+    return true;
+  }
+  twiActive = 0;
+  return false;
+}
+
+// Cerrar el trabajo en curso con status; retorna true si quedó otro
+// trabajo en curso que hay que arrancar
+static bool twiFinishJob(uint8_t status) {
+  TWIJob* job = twiActive;
+  if (job) {
+    TWIDeviceStats* stats = twiDeviceStats(job->address);
+    if (stats) {
+      uint32_t latency = micros() - job->submitMicros;
+      stats->jobs++;
+      stats->totalLatency += latency;
+      if (latency > stats->maxLatency) {
+        stats->maxLatency = latency;
+      }
+      if (status == TWI_JOB_TIMEOUT) {
+        stats->timeouts++;
+      } else if (status != TWI_JOB_DONE) {
+        stats->errors++;
+      }
+    }
+    job->status = status;
+    if (job->onComplete) {
+      job->onComplete(job);
+    }
+  }
+  return twiNextJob();
+}
+
+#if defined(__AVR__)
+// TWINT a 1 limpia la bandera y deja que el TWI siga con el próximo paso
+const uint8_t TWI_CONTINUE = bit(TWINT) | bit(TWEN) | bit(TWIE);
+
+static void twiHardwareBegin() {
+  // Pull-ups internos en SDA y SCL, como Wire
+  digitalWrite(SDA, HIGH);
+  digitalWrite(SCL, HIGH);
+  TWSR = 0;   // Prescaler 1
+  TWBR = ((F_CPU / TWI_FREQUENCY) - 16) / 2;
+  TWCR = bit(TWEN) | bit(TWIE);
+}
+
+// Generar START para el trabajo en curso
+static void twiHardwareStart() {
+  TWCR = TWI_CONTINUE | bit(TWSTA);
+}
+
+// Generar STOP; si hay otro trabajo, START enseguida después del STOP
+static void twiHardwareStop(bool startNext) {
+  TWCR = TWI_CONTINUE | bit(TWSTO) | (startNext ? bit(TWSTA) : 0);
+}
+
+// Soltar el bus tras un timeout: apagar el TWI y dar hasta 9 pulsos
+// de SCL para que un esclavo a mitad de byte libere SDA
+static void twiHardwareRecover() {
+  TWCR = 0;
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, INPUT_PULLUP);
+  for (uint8_t i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+    digitalWrite(SCL, LOW);
+    pinMode(SCL, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(SCL, INPUT_PULLUP);
+    delayMicroseconds(5);
+  }
+  twiHardwareBegin();
+}
+
+// Máquina de estados del maestro: un paso por cada evento del TWI
+ISR(TWI_vect) {
+  TWIJob* job = twiActive;
+  if (!job) {
+    TWCR = TWI_CONTINUE | bit(TWSTO);
+    return;
+  }
+
+  switch (TW_STATUS) {
+    case TW_START:
+    case TW_REP_START:
+      TWDR = (job->address << 1) | (twiReading ? TW_READ : TW_WRITE);
+      TWCR = TWI_CONTINUE;
+      break;
+    
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (twiIndex < job->txLength) {
+        TWDR = job->txData[twiIndex++];
+        TWCR = TWI_CONTINUE;
+      } else if (job->rxLength > 0) {
+        // Pasar a lectura con START repetido
+        twiReading = true;
+        twiIndex = 0;
+        TWCR = TWI_CONTINUE | bit(TWSTA);
+      } else {
+        twiHardwareStop(twiFinishJob(TWI_JOB_DONE));
+      }
+      break;
+    
+    case TW_MR_SLA_ACK:
+      // ACK a cada byte salvo al último
+      TWCR = job->rxLength > 1 ? TWI_CONTINUE | bit(TWEA) : TWI_CONTINUE;
+      break;
+    
+    case TW_MR_DATA_ACK:
+      job->rxData[twiIndex++] = TWDR;
+      TWCR = twiIndex + 1 < job->rxLength ? TWI_CONTINUE | bit(TWEA) : TWI_CONTINUE;
+      break;
+    
+    case TW_MR_DATA_NACK:
+      job->rxData[twiIndex++] = TWDR;
+      twiHardwareStop(twiFinishJob(TWI_JOB_DONE));
+      break;
+    
+    case TW_MT_SLA_NACK:
+    case TW_MT_DATA_NACK:
+    case TW_MR_SLA_NACK:
+      twiHardwareStop(twiFinishJob(TWI_JOB_NACK));
+      break;
+    
+    default:
+      // Arbitraje perdido o error de bus: soltar el bus
+      twiHardwareStop(twiFinishJob(TWI_JOB_BUS_ERROR));
+      break;
+  }
+}
+#else
+// Simulador: el HAL recorre la transacción completa en tiempo virtual
+// y avisa al terminar con el código de Wire.endTransmission()
+static void twiSimComplete(uint8_t result);
+
+static void twiHardwareBegin() {
+  Wire.setCompleteInterrupt(twiSimComplete);
+}
+
+static void twiHardwareStart() {
+  TWIJob* job = twiActive;
+  Wire.startTransaction(job->address, job->txData, job->txLength, job->rxData, job->rxLength);
+}
+
+static void twiHardwareRecover() {
+  Wire.resetBus();
+  twiHardwareBegin();
+}
+
+static void twiSimComplete(uint8_t result) {
+  uint8_t status = TWI_JOB_DONE;
+  if (result == 2 || result == 3) {
+    status = TWI_JOB_NACK;
+  } else if (result != 0) {
+    status = TWI_JOB_BUS_ERROR;
+  }
+  if (twiFinishJob(status)) {
+    twiHardwareStart();
+  }
+}
+#endif
+
+class TWIEngine {
+public:
+  // Configurar el TWI (se puede llamar más de una vez)
+  void begin() {
+    if (twiStarted) return;
+    twiStarted = true;
+    twiHardwareBegin();
+  }
+
+  // Encolar un trabajo; retorna false si ese trabajo aún no terminó
+  bool submit(TWIJob* job) {
+    noInterrupts();
+    if (job->status == TWI_JOB_QUEUED || job->status == TWI_JOB_ACTIVE) {
+      interrupts();
+      return false;
+    }
+    
+    uint8_t priority = job->priority ? TWI_PRIORITY_LOW : TWI_PRIORITY_HIGH;
+    job->status = TWI_JOB_QUEUED;
+    job->submitMicros = micros();
+    job->next = 0;
+    if (twiQueueTail[priority]) {
+      twiQueueTail[priority]->next = job;
+    } else {
+      twiQueueHead[priority] = job;
+    }
+    twiQueueTail[priority] = job;
+    
+    // Con el bus libre, arrancar ya
+    if (!twiActive && twiNextJob()) {
+      twiHardwareStart();
+    }
+    interrupts();
+    return true;
+  }
+
+  // Llamar en cada pasada del loop: abortar el trabajo colgado y liberar el bus
+  void update() {
+    noInterrupts();
+    if (twiActive && millis() - twiActiveSince > TWI_TIMEOUT) {
+      twiHardwareRecover();
+      if (twiFinishJob(TWI_JOB_TIMEOUT)) {
+        twiHardwareStart();
+      }
+    }
+    interrupts();
+  }
+
+  // Verificar si un trabajo sigue en cola o en el bus
+  bool isPending(TWIJob* job) {
+    uint8_t status = job->status;
+    return status == TWI_JOB_QUEUED || status == TWI_JOB_ACTIVE;
+  }
+
+  // Verificar si el bus está libre y sin trabajos en cola
+  bool isIdle() {
+    return twiActive == 0;
+  }
+
+  // Esperar a que termine un trabajo. Solo para el arranque (setup) o
+  // cuando no queda otra: es la única espera activa del módulo
+  uint8_t waitFor(TWIJob* job) {
+    while (isPending(job)) {
+      update();
+      delayMicroseconds(10);
+    }
+    return job->status;
+  }
+
+  // Número de dispositivos con estadísticas
+  uint8_t getDeviceCount() {
+    return twiDeviceCount;
+  }
+
+  // Estadísticas del dispositivo número index (0 si no existe)
+  const TWIDeviceStats* getDeviceStats(uint8_t index) {
+    return index < twiDeviceCount ? &twiStats[index] : 0;
+  }
+
+  // Estadísticas de una dirección I2C (0 si aún no tuvo trabajos)
+  const TWIDeviceStats* findDeviceStats(uint8_t address) {
+    for (uint8_t i = 0; i < twiDeviceCount; i++) {
+      if (twiStats[i].address == address) {
+        return &twiStats[i];
+      }
+    }
+    return 0;
+  }
+};
+
+// Único bus TWI del ATmega328P, compartido por el RTC y el LCD
+static TWIEngine twiBus;
+
+#endif // TWI_ENGINE_H